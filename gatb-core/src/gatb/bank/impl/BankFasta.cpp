@@ -41,6 +41,9 @@ using namespace gatb::core::tools::misc;
 
 #define BUFFER_SIZE     (256*1024)
 
+/** Size of the window read for finding a sequence start after some offset. */
+#define RESYNC_SIZE     (4*1024*1024)
+
 #define nearest_power_of_2(x) (--(x), (x)|=(x)>>1, (x)|=(x)>>2, (x)|=(x)>>4, (x)|=(x)>>8, (x)|=(x)>>16, ++(x))
 
 /** https://graphics.stanford.edu/~seander/bithacks.html#DetermineIfPowerOf2 */
@@ -188,6 +191,20 @@ void BankFasta::init ()
     }
 }
 
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+bool BankFasta::isCompressed () const
+{
+    const char* fname = _filenames[0].c_str();
+    return strlen (fname) >= 2  &&  strcmp (fname + strlen (fname) - 2, "gz") == 0;
+}
+
 /*********************************************************************
 ** METHOD  :
 ** PURPOSE :
@@ -301,9 +318,9 @@ void BankFasta::insert (const Sequence& item)
 ** RETURN  :
 ** REMARKS :
 *********************************************************************/
-BankFasta::Iterator::Iterator (BankFasta& ref, CommentMode_e commentMode)
+BankFasta::Iterator::Iterator (BankFasta& ref, CommentMode_e commentMode, u_int64_t offset)
     : _ref(ref), _commentsMode(commentMode), _isDone(true), _isInitialized(false), _nIters(0),
-      index_file(0), buffered_file(0), buffered_strings(0), _index(0)
+      index_file(0), buffered_file(0), buffered_strings(0), _index(0), _offset(offset)
 {
     DEBUG (("Bank::Iterator::Iterator\n"));
 
@@ -327,6 +344,40 @@ BankFasta::Iterator::~Iterator ()
     finalize ();
 }
 
+/*********************************************************************
+** METHOD  :
+** PURPOSE : find the position of the first sequence header after some offset
+** INPUT   : the stream and the offset
+** OUTPUT  :
+** RETURN  : the position of the header, -1 if none was found
+** REMARKS : a line starting with '>' is a FASTA header; a line starting
+**           with '@' is a FASTQ header if the line two below starts with '+'
+**           (a quality line may start with '@', but it is followed by a
+**           header and a sequence). The line at the offset may be partial,
+**           so it is skipped.
+*********************************************************************/
+static int64_t find_sequence_start (gzFile stream, u_int64_t offset)
+{
+    if (gzseek (stream, offset, SEEK_SET) < 0)  { return -1; }
+
+    vector<char> window (RESYNC_SIZE);
+    int len = gzread (stream, &window[0], window.size());
+    if (len <= 0)  { return -1; }
+
+    /** We get the starts of the complete lines of the window. */
+    vector<int> lines;
+    for (int i=0; i<len-1; i++)  {  if (window[i]=='\n')  { lines.push_back (i+1); }  }
+
+    for (size_t i=0; i<lines.size(); i++)
+    {
+        char c = window[lines[i]];
+        if (c == '>')  { return offset + lines[i]; }
+        if (c == '@' && i+2 < lines.size() && window[lines[i+2]] == '+')  { return offset + lines[i]; }
+    }
+
+    return -1;
+}
+
 /*********************************************************************
 ** METHOD  :
 ** PURPOSE :
@@ -351,6 +402,17 @@ void BankFasta::Iterator::first()
     
     _nIters = 0;
     _index  = 0;
+
+    /** We may have to start the iteration after some position in the file. */
+    if (_offset > 0)
+    {
+        buffered_file_t* bf = (buffered_file_t *) buffered_file[0];
+
+        int64_t start = find_sequence_start (bf->stream, _offset);
+        if (start < 0)  { _isDone = true;  return; }
+
+        gzseek (bf->stream, start, SEEK_SET);
+    }
     
     next();
 }
@@ -85,6 +85,17 @@ public:
     /** \copydoc IBank::iterator */
     tools::dp::Iterator<Sequence>* iterator ()  { return new Iterator (*this); }
 
+    /** Create an iterator starting at the first sequence found after some position in the file.
+     * This is useful for sampling several parts of a file; note that seeking into a compressed
+     * file implies to uncompress it up to the position.
+     * \param[in] offset : position (in the uncompressed file) where to look for the first sequence.
+     * \return the iterator. */
+    tools::dp::Iterator<Sequence>* iterator (u_int64_t offset)  { return new Iterator (*this, Iterator::NONE, offset); }
+
+    /** Tell whether the file of the bank is compressed.
+     * \return true if compressed, false otherwise. */
+    bool isCompressed () const;
+
     /** \copydoc IBank::getNbItems */
     int64_t getNbItems () { return -1; }
 
@@ -148,8 +159,9 @@ public:
         /** Constructor.
          * \param[in] ref : the associated iterable instance.
          * \param[in] commentMode : kind of comments we want to retrieve
+         * \param[in] offset : position in the file where to look for the first sequence
          */
-        Iterator (BankFasta& ref, CommentMode_e commentMode = FULL);
+        Iterator (BankFasta& ref, CommentMode_e commentMode = FULL, u_int64_t offset = 0);
 
         /** Destructor */
         ~Iterator ();
@@ -204,6 +216,9 @@ public:
         bool get_next_seq_from_file (tools::misc::Vector<char>& data, std::string& comment, std::string& quality, int file_id, CommentMode_e mode);
 
         size_t _index;
+
+        /** Position in the file where the iteration starts. */
+        u_int64_t _offset;
     };
 
 protected:
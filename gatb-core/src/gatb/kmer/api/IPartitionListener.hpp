@@ -0,0 +1,75 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef _GATB_CORE_KMER_IPARTITION_LISTENER_HPP_
+#define _GATB_CORE_KMER_IPARTITION_LISTENER_HPP_
+
+/********************************************************************************/
+
+#include <gatb/kmer/impl/Model.hpp>
+#include <gatb/kmer/impl/Configuration.hpp>
+#include <vector>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+/********************************************************************************/
+
+/** \brief Interface for consumers of the kmers partitions counted by SortingCountAlgorithm
+ *
+ * This interface is a push-based alternative to reading the solid kmers once the counting
+ * is over: as soon as a partition has been counted (and sorted), its [kmer,abundance] items
+ * are published to the registered listeners (see CountProcessorStream), so a consumer (a Bloom
+ * filter builder for instance) can start its job while the other partitions are still counted.
+ *
+ * Note that:
+ *      1) the partitions are published out of order, ie. in the order they are counted
+ *      2) 'publish' is called from the counting threads, possibly concurrently for several partitions,
+ *         so an implementation has to be thread safe
+ *      3) the items of one partition are sorted only within each radix bucket of the partition
+ */
+template<size_t span>
+class IPartitionListener : public system::SmartPointer
+{
+public:
+
+    /** Shortcuts. */
+    typedef typename kmer::impl::Kmer<span>::Count Count;
+
+    /** Called (in the main thread) just before the mainloop of SortingCountAlgorithm.
+     * \param[in] config : configuration of the SortingCountAlgorithm. */
+    virtual void begin (const kmer::impl::Configuration& config) = 0;
+
+    /** Called (in a counting thread) when a partition has been counted.
+     * \param[in] passId : index of the pass of the partition
+     * \param[in] partId : index of the partition in the pass
+     * \param[in] items : the counted kmers of the partition; only valid during the call. */
+    virtual void publish (size_t passId, size_t partId, const std::vector<Count>& items) = 0;
+
+    /** Called (in the main thread) just after the mainloop of SortingCountAlgorithm, ie. once
+     * all the partitions have been published. */
+    virtual void end () = 0;
+};
+
+/********************************************************************************/
+} } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _GATB_CORE_KMER_IPARTITION_LISTENER_HPP_ */
@@ -29,6 +29,7 @@
 /********************************************************************************/
 
 #include <gatb/kmer/impl/Model.hpp>
+#include <gatb/kmer/api/IPartitionListener.hpp>
 
 #include <gatb/tools/collections/api/Iterable.hpp>
 #include <gatb/tools/collections/impl/Bloom.hpp>
@@ -95,6 +96,14 @@ public:
     {
     }
 
+    /** Create an empty Bloom filter, for instance to be filled while the kmers are counted
+     * (see BloomPartitionListener).
+     * \return the IBloom instance. */
+    tools::collections::impl::IBloom<Type>*  create ()
+    {
+        return tools::collections::impl::BloomFactory::singleton().createBloom<Type> (_bloomKind, _bloomSize, _nbHash, _ksize);
+    }
+
     /** Create a Bloom filter and fill it with the provided kmers iterator.
      * \param[in] itKmers : an iterator over the kmers to be inserted; more precisely, we iterate couples [kmers,abundance]
      * \param[in] stats : properties object to be filled by statistics gathered during the build.
@@ -181,6 +190,70 @@ private:
     };
 };
 
+/********************************************************************************/
+
+/** \brief Partition listener that fills a Bloom filter while the kmers are counted
+ *
+ * Each partition published by the counting (see CountProcessorStream) is inserted into the
+ * Bloom filter, concurrently with the counting of the other partitions. Since the number
+ * of solid kmers is not known before the end of the counting, the Bloom filter has to be
+ * created (and sized) by the caller, for instance with BloomBuilder::create.
+ *
+ * Note that the insertion is thread safe only for the Bloom filters kinds using atomic
+ * operations (ie. not BLOOM_BASIC), as for BloomBuilder::build with several cores.
+ */
+template<size_t span=KMER_DEFAULT_SPAN>
+class BloomPartitionListener : public IPartitionListener<span>
+{
+public:
+
+    /** Shortcuts. */
+    typedef typename Kmer<span>::Type  Type;
+    typedef typename Kmer<span>::Count Count;
+
+    /** Constructor.
+     * \param[in] bloom : the Bloom filter to be filled
+     * \param[in] min_abundance : if >0, only kmers having abundance greater than that threshold are inserted. */
+    BloomPartitionListener (tools::collections::impl::IBloom<Type>* bloom, int min_abundance=0)
+        : _bloom(0), _min_abundance(min_abundance), _nbItems(0)  {  setBloom (bloom);  }
+
+    /** Destructor. */
+    ~BloomPartitionListener ()  {  setBloom (0);  }
+
+    /** \copydoc IPartitionListener<span>::begin */
+    void begin (const Configuration& config)  {}
+
+    /** \copydoc IPartitionListener<span>::publish */
+    void publish (size_t passId, size_t partId, const std::vector<Count>& items)
+    {
+        u_int64_t nbItems = 0;
+        for (size_t i=0; i<items.size(); i++)
+        {
+            if ((int)items[i].abundance >= _min_abundance)  {  _bloom->insert (items[i].value);  nbItems++;  }
+        }
+        __sync_fetch_and_add (&_nbItems, nbItems);
+    }
+
+    /** \copydoc IPartitionListener<span>::end */
+    void end ()  {}
+
+    /** Get the Bloom filter.
+     * \return the IBloom instance. */
+    tools::collections::impl::IBloom<Type>* getBloom ()  { return _bloom; }
+
+    /** Get the number of kmers inserted into the Bloom filter.
+     * \return the number of kmers. */
+    u_int64_t getNbItems () const  { return _nbItems; }
+
+private:
+
+    tools::collections::impl::IBloom<Type>* _bloom;
+    void setBloom (tools::collections::impl::IBloom<Type>* bloom)  { SP_SETATTR(bloom); }
+
+    int       _min_abundance;
+    u_int64_t _nbItems;
+};
+
 /********************************************************************************/
 } } } } /* end of namespaces. */
 /********************************************************************************/
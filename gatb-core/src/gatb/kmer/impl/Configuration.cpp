@@ -50,6 +50,7 @@ Properties Configuration::getProperties() const
     result.add (1, "kmer_size",         "%ld", _kmerSize);
     result.add (1, "mini_size",         "%ld", _minim_size);
     result.add (1, "solidity_kind",      "%s", toString(_solidityKind).c_str());
+    result.add (1, "kmer_orientation",   "%s", toString(_orientation).c_str());
 
 	if(_solidityKind==KMER_SOLIDITY_CUSTOM)
 	{
@@ -73,6 +74,11 @@ Properties Configuration::getProperties() const
     result.add (1, "sequence_volume",   "%ld", _estimateSeqTotalSize / system::MBYTE);
     result.add (1, "kmers_number",      "%ld", _kmersNb);
     result.add (1, "kmers_volume",      "%ld", _volume);
+    if (_estimatedDistinctKmersNb > 0)
+    {
+        result.add (1, "distinct_kmers_estimate", "%ld",  _estimatedDistinctKmersNb);
+        result.add (1, "distinct_kmers_error",    "%.4f", _estimatedDistinctKmersError);
+    }
     result.add (1, "max_disk_space",    "%ld", _max_disk_space);
     result.add (1, "max_memory",        "%ld", _max_memory);
     result.add (1, "nb_passes",         "%d",  _nb_passes);
@@ -81,6 +87,8 @@ Properties Configuration::getProperties() const
     result.add (1, "nb_cores",          "%d",  _nbCores);
     result.add (1, "minimizer_type",    "%s",  (_minimizerType == 0) ? "lexicographic (kmc2 heuristic)" : "frequency");
     result.add (1, "repartition_type",  "%s",  (_repartitionType == 0) ? "unordered" : "ordered");
+    if (!_repartitionIn.empty())  {  result.add (1, "repartition_in",  "%s",  _repartitionIn.c_str());  }
+    if (!_incrementalIn.empty())  {  result.add (1, "incremental_in",  "%s",  _incrementalIn.c_str());  }
 
     result.add (1, "nb_cores_per_partition",     "%d",  _nbCores_per_partition);
     result.add (1, "nb_partitions_in_parallel",  "%d",  _nb_partitions_in_parallel);
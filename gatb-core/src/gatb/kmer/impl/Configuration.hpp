@@ -41,13 +41,19 @@ public:
 
     /** */
     Configuration ()
-    : _kmerSize(0), _minim_size(0), _repartitionType(0), _minimizerType(0),
+    : _kmerSize(0), _minim_size(0), _repartitionType(0), _minimizerType(0), _repartitionSampleSize(0), _repartitionSampleTime(0),
       _solidityKind(tools::misc::KMER_SOLIDITY_SUM),
+#ifdef NONCANONICAL
+      _orientation(tools::misc::KMER_ORIENTATION_DIRECT),
+#else
+      _orientation(tools::misc::KMER_ORIENTATION_CANONICAL),
+#endif
       _max_disk_space(0), _max_memory(0),
       _nbCores(0), _nb_partitions_in_parallel(0), _abundanceUserNb(0), _storage_type(tools::storage::impl::STORAGE_HDF5) ,
       _isComputed(false), _nbCores_per_partition(0),
       _estimateSeqNb(0), _estimateSeqTotalSize(0), _estimateSeqMaxSize(0),
-      _available_space(0), _volume(0), _kmersNb(0), _nb_passes(0), _nb_partitions(0), _nb_bits_per_kmer(0), _nb_banks(0) {}
+      _available_space(0), _volume(0), _kmersNb(0), _estimatedDistinctKmersNb(0), _estimatedDistinctKmersError(0),
+      _nb_passes(0), _nb_partitions(0), _nb_bits_per_kmer(0), _nb_banks(0) {}
 
     /****************************************/
     /**             PROVIDED                */
@@ -58,8 +64,26 @@ public:
     size_t      _repartitionType;
     size_t      _minimizerType;
 
+    /** Bounds of the sampling of the input for computing the repartition: number of sequences
+     * (0 for an automatic choice) and time in seconds (0 for no limit). */
+    u_int64_t   _repartitionSampleSize;
+    size_t      _repartitionSampleTime;
+
+    /** Uris of a repartition file computed by a previous run to be used (instead of sampling
+     * the input), and of a repartition file to be saved for later runs (empty if none). */
+    std::string _repartitionIn;
+    std::string _repartitionOut;
+
+    /** Uri of the output of a previous run whose counts are added to the ones of the input, for
+     * counting only the new input (empty if none). */
+    std::string _incrementalIn;
+
     tools::misc::KmerSolidityKind _solidityKind;
 
+    /** Orientation of the counted kmers. Note that the superkmers are partitioned by canonical
+     * minimizers, so a kmer and its reverse complement always fall in the same partition. */
+    tools::misc::KmerOrientation  _orientation;
+
     u_int64_t   _max_disk_space;
     u_int32_t   _max_memory;
 
@@ -90,6 +114,10 @@ public:
     u_int64_t   _volume;
     u_int64_t   _kmersNb;
 
+    /** Estimation of the number of distinct kmers (0 if not estimated) and its relative standard error. */
+    u_int64_t   _estimatedDistinctKmersNb;
+    double      _estimatedDistinctKmersError;
+
     u_int32_t   _nb_passes;
     u_int32_t   _nb_partitions;
 
@@ -22,7 +22,9 @@
 #include <gatb/tools/collections/impl/OAHash.hpp>
 #include <gatb/tools/misc/api/StringsRepository.hpp>
 #include <gatb/tools/misc/impl/Tokenizer.hpp>
-#include <gatb/kmer/impl/LinearCounter.hpp>
+#include <gatb/kmer/impl/HyperLogLog.hpp>
+#include <gatb/kmer/impl/PartiInfo.hpp>
+#include <gatb/tools/storage/impl/Storage.hpp>
 
 #include <cmath>
 
@@ -48,6 +50,8 @@ using namespace gatb::core::tools::collections::impl;
 using namespace gatb::core::tools::misc;
 using namespace gatb::core::tools::misc::impl;
 
+using namespace gatb::core::tools::storage::impl;
+
 /********************************************************************************/
 
 #define DEBUG(a)  //printf a
@@ -61,119 +65,51 @@ using namespace gatb::core::tools::misc::impl;
 ** REMARKS :
 *********************************************************************/
 
-// estimated the number of distinct kmers in a dataset
-// wrapper around a Linear Counter. Adapted from Kmergenie code.
-// why not a hyperloglog? it seems that the transition from the 32bit-hash initial implementation to 64bits, and supporting billions of elements, is nontrivial, so i didn't bother
-// probably deserves to be in its own file
+/** Functor estimating the number of distinct kmers of a bank with a HyperLogLog sketch.
+ * Each thread fills its own sketch, which is merged into the shared one when the functor is
+ * deleted; so the dispatcher has to delete the functors synchronously. */
 template<size_t span>
 class EstimateNbDistinctKmers
 {
 public:
 
     /** Shortcut. */
-    typedef typename Kmer<span>::Type  Type;
-    typedef typename Kmer<span>::ModelDirect     ModelDirect;
-    typedef typename Kmer<span>::ModelCanonical  ModelCanonical;
-#ifdef NONCANONICAL 
-    typedef typename Kmer<span>::template ModelMinimizer <ModelDirect>   Model;
-#else
-    typedef typename Kmer<span>::template ModelMinimizer <ModelCanonical>   Model;
-#endif
-    typedef typename Model::Kmer                        KmerType;
-
-    /** */
-    void estimate()
-    {
-        nb_distinct_kmers =(unsigned long)( (float)(linearCounter->count( )) * ((float)nbKmersTotal / (float)nbProcessedKmers)); // dubious linear extrapolation, that's all I got
-
-        abs_error = abs((long)(nb_distinct_kmers-previous_nb_distinct_kmers));
-
-        previous_nb_distinct_kmers = nb_distinct_kmers;
-    }
+    typedef typename Kmer<span>::ModelCanonical  Model;
+    typedef typename Model::Kmer                 KmerType;
 
     /** */
     void operator() (Sequence& sequence)
     {
         /** We build the kmers from the current sequence. */
-        if (model.build (sequence.getData(), kmers) == false)  {  throw "reached EOF"; return; }
+        if (_model.build (sequence.getData(), _kmers) == false)  {  return;  }
 
         /** We loop over the kmers. */
-        for (size_t i=0; i<kmers.size(); i++)
+        for (size_t i=0; i<_kmers.size(); i++)
         {
-            linearCounter->add((kmers[i].value()));
-
-
-            // heuristics to stop early, i found that it's inaccurate with low coverage (e.g. on dsk/test/FiftyK.fastq)
-            /*
-            if (nbProcessedReads % eval_every_N_reads == 0 )
-            {
-
-                // let's see if the estimation converges..
-                // the following stopping condition will grossly over-estimate the number of distinct kmers
-                // but I expect the correct result to be in the same order of magnitude
-                // and better to overestimate than underestimate (for both dsk and kmergenie)
-                   estimate();
-                   bool debug = true;
-                   if (debug)
-                       printf("linear estimator at %ld kmers, number of distinct kmers estimated now: %ld, abs error: %ld\n",nbProcessedKmers, nb_distinct_kmers, abs_error);
-                   if (abs_error < previous_nb_distinct_kmers/20) // 5% error
-                   {
-                       throw "LinearCounter converged"; // well, "converged" is a big word
-                       return;
-                   }
-                   if (!linearCounter->is_accurate())
-                   {
-                   printf("LinearCounter is inaccurate";
-                   return;
-                   }
-
-            }*/
+            if (_kmers[i].isValid() == false)  { continue; }
 
+            _localSketch.add (oahash (_canonical ? _kmers[i].value() : _kmers[i].forward()));
         }
-        nbProcessedKmers += kmers.size();
-        nbProcessedReads++;
-        //if (nbProcessedReads % 100000 == 0) printf("nb: %ld\n",nbProcessedReads);
-
-        // disabled progress
-        //if (nbCurProgressKmers > 500000)   {  _progress.inc (nbCurProgressKmers);  nbCurProgressKmers = 0;  }
     }
 
-    EstimateNbDistinctKmers (Model& model, u_int32_t max_memory, unsigned long nb_kmers_total, tools::dp::IteratorListener* progress)
-        : model(model),  eval_every_N_reads(10000000),   nbKmersTotal(nb_kmers_total),
-        nbProcessedKmers(0), nbCurProgressKmers(0), previous_nb_distinct_kmers(0), nbProcessedReads(0), abs_error(0)
-        //, _progress  (progress,System::thread().newSynchronizer())
-    {
-        unsigned long size_linearCounter; // (in bits)
-        /* let's set it to just use half of all memory available at most, ok? this isn't very robust for huge dataset, so to be tested*/
-        /* if it's a tiny dataset, let's set it to total number of kmers */
-        size_linearCounter = std::min( nb_kmers_total, (unsigned long) (max_memory*8*1024*1024/2) );
-        linearCounter =  new LinearCounter<span>(size_linearCounter);
-    }
+    /** */
+    EstimateNbDistinctKmers (Model& model, bool canonical, HyperLogLog& sketch)
+        : _model(model), _canonical(canonical), _sketch(sketch), _localSketch(sketch.getPrecision())  {}
 
-    unsigned long getEstimation()
-    {
-        estimate();
-        // soo.. if it's not accurate, let's assume we have a hugeload of kmers, and let's be safe, we return the total number of kmers
-        if (!linearCounter->is_accurate())
-        {
-            cout << "Warning: linear counter was not accurate, returning worst-case estimation of number of distinct kmers";
-            return nbKmersTotal;
-        }
-        return nb_distinct_kmers;
-    }
+    /** The copies (one per thread) start with an empty sketch. */
+    EstimateNbDistinctKmers (const EstimateNbDistinctKmers& f)
+        : _model(f._model), _canonical(f._canonical), _sketch(f._sketch), _localSketch(f._sketch.getPrecision())  {}
+
+    /** */
+    ~EstimateNbDistinctKmers ()  {  _sketch.merge (_localSketch);  }
 
 private:
 
-    /** Local resources. */
-    Model&    model;
-    unsigned long nbProcessedReads, nbProcessedKmers;
-    unsigned long nbCurProgressKmers;
-    unsigned long nbKmersTotal;
-    unsigned long abs_error;
-    vector<KmerType> kmers;
-    LinearCounter<span> *linearCounter;
-    int eval_every_N_reads;
-    unsigned long previous_nb_distinct_kmers, nb_distinct_kmers;
+    Model&           _model;
+    bool             _canonical;
+    HyperLogLog&     _sketch;
+    HyperLogLog      _localSketch;
+    vector<KmerType> _kmers;
 };
 
 
@@ -197,8 +133,21 @@ ConfigurationAlgorithm<span>::ConfigurationAlgorithm (bank::IBank* bank, IProper
     _config._repartitionType    = input->getInt (STR_REPARTITION_TYPE);
     _config._minimizerType      = input->getInt (STR_MINIMIZER_TYPE);
 
+    if (input->get(STR_REPARTITION_SAMPLE_SIZE))  {  _config._repartitionSampleSize = input->getInt (STR_REPARTITION_SAMPLE_SIZE);  }
+    if (input->get(STR_REPARTITION_SAMPLE_TIME))  {  _config._repartitionSampleTime = input->getInt (STR_REPARTITION_SAMPLE_TIME);  }
+    if (input->get(STR_REPARTITION_IN))           {  _config._repartitionIn          = input->getStr (STR_REPARTITION_IN);           }
+    if (input->get(STR_REPARTITION_OUT))          {  _config._repartitionOut         = input->getStr (STR_REPARTITION_OUT);          }
+    if (input->get(STR_INCREMENTAL_IN))           {  _config._incrementalIn          = input->getStr (STR_INCREMENTAL_IN);           }
+
     parse (input->getStr (STR_SOLIDITY_KIND), _config._solidityKind);
 
+    if (input->get(STR_KMER_ORIENTATION))  {  parse (input->getStr (STR_KMER_ORIENTATION), _config._orientation);  }
+#ifdef NONCANONICAL
+    /** The superkmers are partitioned by direct minimizers in this build, so a kmer and its reverse
+     * complement may be in different partitions. */
+    if (_config._orientation != KMER_ORIENTATION_DIRECT)  {  throw system::Exception ("Only direct kmers can be counted by this build (NONCANONICAL)");  }
+#endif
+
     _config._max_disk_space     = input->getInt (STR_MAX_DISK);
     _config._max_memory         = input->getInt (STR_MAX_MEMORY);
     _config._nbCores            = input->get(STR_NB_CORES) ? input->getInt(STR_NB_CORES) : 0;
@@ -339,6 +288,14 @@ void ConfigurationAlgorithm<span>::execute ()
 
     _config._nb_passes = ( (_config._volume/4) / _config._max_disk_space ) + 1; //minim, approx volume /switched to approx /4 (was/3) because of more efficient superk storage
     //_nb_passes = 1; //do not constrain nb passes on disk space anymore (anyway with minim, not very big)
+
+    /** The superkmers may be kept in memory (up to half the memory, see SortingCountAlgorithm), in which case
+     * the disk space doesn't constrain the number of passes when they are expected to fit. */
+    if (_input->get(STR_SUPERK_IN_MEMORY) && _input->getInt(STR_SUPERK_IN_MEMORY) != 0
+        && _config._solidityKind == tools::misc::KMER_SOLIDITY_SUM && (_config._volume/4) <= _config._max_memory/2)
+    {
+        _config._nb_passes = 1;
+    }
     //increase it only if ram issue
 
     //printf("_volume  %lli volume_minim %lli _max_disk_space %lli  _nb_passes init %i  \n", _volume,volume_minim,_max_disk_space,_nb_passes);
@@ -351,40 +308,27 @@ void ConfigurationAlgorithm<span>::execute ()
         max_open_files /= 3; // will need to open twice in STORAGE_FILE instead of HDF5, so this adjustment is needed. needs to be fixed later by putting partitions inside the same file. but i'd rather not do it in the current messy collection/group/partition hdf5-inspired system. overall, that's a FIXME
     }
 
-#if 0
-    /* disabled by default; this was an experiment */
-    float est_volume_distinct_ratio;
-    if (_flagEstimateNbDistinctKmers)
+    /** We may estimate the number of distinct kmers; it is only reported for the moment, since the
+     * partitions are sized for counting all their kmers (see PartitionsByVectorCommand). */
+    if (_input->get(STR_ESTIMATE_DISTINCT) && _input->getInt(STR_ESTIMATE_DISTINCT) != 0)
     {
-        /* we estimate the volume of distinct kmers vs total number of kmers.
-         * we store it in the variable "est_volume_distinct_ratio"
-         * to compute it, we need a linear counter, let's call it now */
-
         TIME_INFO (getTimeInfo(), "estimate_distinct_kmers");
-        Iterator<Sequence>* itSeq = _bank->iterator();
+
+        tools::dp::Iterator<Sequence>* itSeq = _bank->iterator();
         LOCAL (itSeq);
 
-        //_progress->setMessage (progressFormat0); // not touching progress here anymore
-        Model model (_kmerSize, _minim_size);
-        EstimateNbDistinctKmers<span> estimate_nb_distinct_kmers_function(model, _max_memory, kmersNb, _progress);
+        typename Kmer<span>::ModelCanonical model (_config._kmerSize);
+        HyperLogLog sketch;
 
-        /** We launch the iteration of the sequences iterator with the created functors. */
-        try {
-            itSeq->iterate (estimate_nb_distinct_kmers_function);
-        }
-        catch (const char* except)
-        {
+        /** The sketches of the threads are merged when the functors are deleted, hence synchronously. */
+        getDispatcher()->iterate (itSeq, EstimateNbDistinctKmers<span> (
+            model, _config._orientation != KMER_ORIENTATION_DIRECT, sketch
+        ), 1000, true);
 
-        }
-        _estimatedDistinctKmerNb = estimate_nb_distinct_kmers_function.getEstimation();
-        est_volume_distinct_ratio = (float) _estimatedDistinctKmerNb / (float)kmersNb;
-        //est_volume_distinct_ratio = 1; // for debug
-        /* est_volume_distinct_ratio == 1 mean that we guarantee worst case the memory usage,
-           the value mean that, on average, a k-mer will be seen 'est_volume_distinct_ratio' times */
-        // if wrongly estimated, the error 'OAHash: max rehashes..' can happen
-        printf ("LinearCounter done, estimated %ld number of distinct kmers, ratio to total number of kmers: %.2f\n", (long)_estimatedDistinctKmerNb, est_volume_distinct_ratio);
+        _config._estimatedDistinctKmersNb    = sketch.estimate();
+        _config._estimatedDistinctKmersError = sketch.getError();
     }
-#endif
+
     u_int64_t volume_per_pass;
     do  {
 
@@ -414,6 +358,64 @@ void ConfigurationAlgorithm<span>::execute ()
     incpart = incpart % _config._nb_partitions_in_parallel;
     if(((int)max_open_files - (int)_config._nb_partitions  > incpart)) _config._nb_partitions+= incpart ;
 
+    /** An incremental counting merges the counts of each partition with the ones of the same
+     * partition of the previous run, so it needs the partitions of the previous run. */
+    if (!_config._incrementalIn.empty())
+    {
+        if (_config._solidityKind != KMER_SOLIDITY_SUM)
+        {
+            throw Exception ("Incremental counting needs the 'sum' solidity kind");
+        }
+        if (_config._orientation == KMER_ORIENTATION_BOTH)
+        {
+            throw Exception ("Incremental counting is not possible with the 'both' kmers orientation");
+        }
+        if (!_config._repartitionIn.empty() && _config._repartitionIn != _config._incrementalIn)
+        {
+            throw Exception ("Incremental counting uses the repartition of '%s', not the one of '%s'",
+                _config._incrementalIn.c_str(), _config._repartitionIn.c_str()
+            );
+        }
+
+        _config._repartitionIn = _config._incrementalIn;
+    }
+
+    /** The repartition of a previous run may be used, which sets the number of partitions; it must
+     * be at least the one needed by this run. */
+    if (!_config._repartitionIn.empty())
+    {
+        Repartitor repartitor;
+        repartitor.load (_config._repartitionIn, _config._kmerSize, _config._minim_size, _config._minimizerType);
+
+        if (repartitor.getNbPartitions() < _config._nb_partitions || repartitor.getNbPartitions() >= max_open_files)
+        {
+            throw Exception ("Repartition file '%s' has %d partitions, but this run needs between %d and %d partitions",
+                _config._repartitionIn.c_str(), repartitor.getNbPartitions(), _config._nb_partitions, max_open_files-1
+            );
+        }
+
+        _config._nb_partitions = repartitor.getNbPartitions();
+    }
+
+    /** The kmers of a pass depend on the number of passes, so we also use the one of the previous run. */
+    if (!_config._incrementalIn.empty())
+    {
+        Storage* previous = StorageFactory(STORAGE_HDF5).load (_config._incrementalIn);
+        LOCAL (previous);
+
+        size_t nbSolidParts = previous->getGroup("dsk").getPartition<typename Kmer<span>::Count> ("solid").size();
+        size_t nbPasses     = nbSolidParts / _config._nb_partitions;
+
+        if (nbSolidParts % _config._nb_partitions != 0 || nbPasses < _config._nb_passes)
+        {
+            throw Exception ("Previous run '%s' has %d partitions of counts, but this run needs %d passes of %d partitions",
+                _config._incrementalIn.c_str(), nbSolidParts, _config._nb_passes, _config._nb_partitions
+            );
+        }
+
+        _config._nb_passes = nbPasses;
+    }
+
     //_nb_partitions_in_parallel = 1 ;
 
     //then put _nbCores_per_partition
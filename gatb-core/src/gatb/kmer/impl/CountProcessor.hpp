@@ -26,8 +26,12 @@
 #include <gatb/kmer/impl/CountProcessorProxy.hpp>
 #include <gatb/kmer/impl/CountProcessorHistogram.hpp>
 #include <gatb/kmer/impl/CountProcessorDump.hpp>
+#include <gatb/kmer/impl/CountProcessorMatrix.hpp>
+#include <gatb/kmer/impl/CountProcessorMerge.hpp>
 #include <gatb/kmer/impl/CountProcessorSolidity.hpp>
 #include <gatb/kmer/impl/CountProcessorCutoff.hpp>
+#include <gatb/kmer/impl/CountProcessorStream.hpp>
+#include <gatb/kmer/impl/CountProcessorStrand.hpp>
 
 /********************************************************************************/
 
@@ -0,0 +1,444 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef _COUNT_PROCESSOR_MATRIX_HPP_
+#define _COUNT_PROCESSOR_MATRIX_HPP_
+
+/********************************************************************************/
+
+#include <gatb/kmer/impl/Model.hpp>
+#include <gatb/kmer/impl/CountProcessorAbstract.hpp>
+#include <gatb/tools/storage/impl/Storage.hpp>
+#include <gatb/tools/misc/impl/Stringify.hpp>
+
+#include <limits>
+#include <stdlib.h>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+namespace impl      {
+/********************************************************************************/
+
+/** \brief Item of the integer columns of a count matrix.
+ *
+ * Wraps an integral value so that it can be stored in a Partition; the HDF5 type
+ * is chosen from the size and the signedness of T.
+ */
+template<typename T>
+struct CountMatrixValue
+{
+    T value;
+
+    CountMatrixValue (const T& v=0) : value(v) {}
+
+    operator T () const { return value; }
+
+    inline static hid_t hdf5 (bool& isCompound)
+    {
+        bool sign = std::numeric_limits<T>::is_signed;
+             if (sizeof(T)==1) { return H5Tcopy (sign ? H5T_NATIVE_INT8  : H5T_NATIVE_UINT8);  }
+        else if (sizeof(T)==2) { return H5Tcopy (sign ? H5T_NATIVE_INT16 : H5T_NATIVE_UINT16); }
+        else if (sizeof(T)==4) { return H5Tcopy (sign ? H5T_NATIVE_INT32 : H5T_NATIVE_UINT32); }
+        else                   { return H5Tcopy (sign ? H5T_NATIVE_INT64 : H5T_NATIVE_UINT64); }
+    }
+};
+
+/********************************************************************************/
+
+/** \brief Sparse kmer x sample count matrix, as dumped by CountProcessorMatrix.
+ *
+ * The matrix is stored column-wise in a storage group, with one collection per
+ * partition for each of the following partitions:
+ *      - 'kmers'     : the kmers values
+ *      - 'row_sizes' : for each kmer, the number of samples where it occurs
+ *      - 'samples'   : for each kmer, the indexes of the samples where it occurs
+ *      - 'counts'    : for each kmer, its count in each of these samples
+ *
+ * The two last partitions hold the concatenation of the non null cells of the rows,
+ * so the ith collection of each partition are read together to rebuild the rows of
+ * the ith kmers partition.
+ *
+ * This class gives read access to such a matrix; rows are provided with a dense
+ * count vector (one entry per sample), ie. in the same form as what count processors
+ * receive during the counting.
+ *
+ * Sample of use:
+ * \code
+ *  CountMatrix<span> matrix (storage->getGroup("matrix"));
+ *  Iterator<CountMatrix<span>::Row>* it = matrix.iterator();  LOCAL (it);
+ *  for (it->first(); !it->isDone(); it->next())
+ *  {
+ *      cout << it->item().kmer << " " << it->item().counts[0] << endl;
+ *  }
+ * \endcode
+ */
+template<size_t span=KMER_DEFAULT_SPAN>
+class CountMatrix
+{
+public:
+
+    /** Shortcuts. */
+    typedef typename Kmer<span>::Type Type;
+
+    typedef CountMatrixValue<u_int16_t>   RowSize;
+    typedef CountMatrixValue<u_int16_t>   SampleId;
+    typedef CountMatrixValue<CountNumber> SampleCount;
+
+    /** Row of the matrix. */
+    struct Row
+    {
+        Type        kmer;
+        CountVector counts;
+    };
+
+    /** Constructor.
+     * \param[in] group : group where the matrix has been dumped. */
+    CountMatrix (tools::storage::impl::Group& group)
+        : _kmers     (group.getPartition<Type>        ("kmers")),
+          _rowSizes  (group.getPartition<RowSize>     ("row_sizes")),
+          _samples   (group.getPartition<SampleId>    ("samples")),
+          _counts    (group.getPartition<SampleCount> ("counts")),
+          _nbSamples (atol (group.getProperty("nb_samples").c_str()))
+    {
+        if (_kmers.size() != _rowSizes.size() || _kmers.size() != _samples.size() || _kmers.size() != _counts.size())
+        {
+            throw system::Exception ("Bad count matrix in group '%s'", group.getId().c_str());
+        }
+    }
+
+    /** Get the number of samples, ie. the number of columns of the matrix.
+     * \return the number of samples. */
+    size_t getNbSamples () const  { return _nbSamples; }
+
+    /** Get the number of partitions of the matrix.
+     * \return the number of partitions. */
+    size_t getNbPartitions () const  { return _kmers.size(); }
+
+    /** Get the number of kmers, ie. the number of rows of the matrix.
+     * \return the number of kmers. */
+    u_int64_t getNbKmers ()  { return _kmers.getNbItems(); }
+
+    /** Get the number of non null cells of the matrix.
+     * \return the number of cells. */
+    u_int64_t getNbCells ()  { return _samples.getNbItems(); }
+
+    /** Create an iterator over the rows of one partition.
+     * \param[in] partId : index of the partition
+     * \return the iterator. */
+    tools::dp::Iterator<Row>* iterator (size_t partId)
+    {
+        return new RowIterator (_kmers[partId], _rowSizes[partId], _samples[partId], _counts[partId], _nbSamples);
+    }
+
+    /** Create an iterator over the rows of all the partitions.
+     * \return the iterator. */
+    tools::dp::Iterator<Row>* iterator ()
+    {
+        if (getNbPartitions() == 0)  { return new tools::dp::impl::NullIterator<Row> (); }
+
+        std::vector<tools::dp::Iterator<Row>*> iterators;
+        for (size_t i=0; i<getNbPartitions(); i++)  { iterators.push_back (iterator(i)); }
+        return new tools::dp::impl::CompositeIterator<Row> (iterators);
+    }
+
+private:
+
+    tools::storage::impl::Partition<Type>&        _kmers;
+    tools::storage::impl::Partition<RowSize>&     _rowSizes;
+    tools::storage::impl::Partition<SampleId>&    _samples;
+    tools::storage::impl::Partition<SampleCount>& _counts;
+    size_t _nbSamples;
+
+    /** Iterates the four columns of one partition together. */
+    class RowIterator : public tools::dp::Iterator<Row>
+    {
+    public:
+
+        RowIterator (
+            tools::collections::Collection<Type>&        kmers,
+            tools::collections::Collection<RowSize>&     rowSizes,
+            tools::collections::Collection<SampleId>&    samples,
+            tools::collections::Collection<SampleCount>& counts,
+            size_t nbSamples
+        )
+            : _itKmers(0), _itRowSizes(0), _itSamples(0), _itCounts(0), _nbSamples(nbSamples), _isDone(true)
+        {
+            setItKmers    (kmers.iterator());
+            setItRowSizes (rowSizes.iterator());
+            setItSamples  (samples.iterator());
+            setItCounts   (counts.iterator());
+        }
+
+        ~RowIterator ()
+        {
+            setItKmers    (0);
+            setItRowSizes (0);
+            setItSamples  (0);
+            setItCounts   (0);
+        }
+
+        void first ()
+        {
+            _itKmers->first();  _itRowSizes->first();  _itSamples->first();  _itCounts->first();
+            fill ();
+        }
+
+        void next ()
+        {
+            _itKmers->next();  _itRowSizes->next();
+            fill ();
+        }
+
+        bool isDone ()  { return _isDone; }
+
+        Row& item ()  { return *(this->_item); }
+
+    private:
+
+        tools::dp::Iterator<Type>*        _itKmers;
+        tools::dp::Iterator<RowSize>*     _itRowSizes;
+        tools::dp::Iterator<SampleId>*    _itSamples;
+        tools::dp::Iterator<SampleCount>* _itCounts;
+
+        void setItKmers    (tools::dp::Iterator<Type>*        itKmers)     { SP_SETATTR(itKmers);    }
+        void setItRowSizes (tools::dp::Iterator<RowSize>*     itRowSizes)  { SP_SETATTR(itRowSizes); }
+        void setItSamples  (tools::dp::Iterator<SampleId>*    itSamples)   { SP_SETATTR(itSamples);  }
+        void setItCounts   (tools::dp::Iterator<SampleCount>* itCounts)    { SP_SETATTR(itCounts);   }
+
+        size_t _nbSamples;
+        bool   _isDone;
+
+        /** Build the current row from the current kmer and the next cells. */
+        void fill ()
+        {
+            _isDone = _itKmers->isDone() || _itRowSizes->isDone();
+            if (_isDone)  { return; }
+
+            Row& row = *(this->_item);
+            row.kmer = _itKmers->item();
+            row.counts.assign (_nbSamples, 0);
+
+            for (size_t i=0; i<_itRowSizes->item().value; i++)
+            {
+                if (_itSamples->isDone() || _itCounts->isDone())  { throw system::Exception ("Truncated count matrix"); }
+
+                size_t sample = _itSamples->item().value;
+                if (sample >= _nbSamples)  { throw system::Exception ("Bad sample index %ld in count matrix", sample); }
+
+                row.counts[sample] = _itCounts->item().value;
+
+                _itSamples->next();  _itCounts->next();
+            }
+        }
+    };
+};
+
+/********************************************************************************/
+
+/** The CountProcessorMatrix implementation dumps the counts of each kmer in each
+ * bank (ie. each sample) as a sparse kmer x sample matrix; see CountMatrix for the
+ * layout of the matrix and for reading it back.
+ *
+ * Counting N samples together with this processor gives the same matrix as N separate
+ * counting runs, while partitioning the superkmers of the N banks only once.
+ *
+ * Like CountProcessorDump, the number of partitions is received through 'begin' and
+ * a clone instance is dedicated to one partition. It is likely to be used in a
+ * CountProcessorChain after a solidity filter, so that only the rows of solid kmers
+ * are dumped.
+ *
+ * Note that the counts of each bank are available only if the solidity kind is not
+ * 'sum'; otherwise, the matrix has only one column holding the total counts.
+ */
+template<size_t span=KMER_DEFAULT_SPAN>
+class CountProcessorMatrix : public CountProcessorAbstract<span>
+{
+public:
+
+    /** Shortcuts. */
+    typedef typename Kmer<span>::Type Type;
+
+    typedef typename CountMatrix<span>::RowSize     RowSize;
+    typedef typename CountMatrix<span>::SampleId    SampleId;
+    typedef typename CountMatrix<span>::SampleCount SampleCount;
+
+    /** Constructor */
+    CountProcessorMatrix (tools::storage::impl::Group& group, size_t kmerSize)
+        : _group(group), _kmerSize(kmerSize), _nbPartsPerPass(0), _nbSamples(0),
+          _kmers(0), _rowSizes(0), _samples(0), _counts(0),
+          _kmersBag(0), _rowSizesBag(0), _samplesBag(0), _countsBag(0)
+    {
+    }
+
+    /** Destructor */
+    virtual ~CountProcessorMatrix ()
+    {
+        setKmersBag    (0);
+        setRowSizesBag (0);
+        setSamplesBag  (0);
+        setCountsBag   (0);
+    }
+
+    /********************************************************************/
+    /*   METHODS CALLED ON THE PROTOTYPE INSTANCE (in the main thread). */
+    /********************************************************************/
+
+    /** \copydoc ICountProcessor<span>::begin */
+    void begin (const Configuration& config)
+    {
+        _nbPartsPerPass = config._nb_partitions;
+
+        _nbSamples = config._solidityKind == tools::misc::KMER_SOLIDITY_SUM ? 1 : config._nb_banks;
+
+        if (_nbSamples > std::numeric_limits<u_int16_t>::max())
+        {
+            throw system::Exception ("Too many banks (%ld) for a count matrix", _nbSamples);
+        }
+
+        size_t nbTotalPartitions = config._nb_partitions * config._nb_passes;
+
+        _kmers    = & _group.getPartition<Type>        ("kmers",     nbTotalPartitions);
+        _rowSizes = & _group.getPartition<RowSize>     ("row_sizes", nbTotalPartitions);
+        _samples  = & _group.getPartition<SampleId>    ("samples",   nbTotalPartitions);
+        _counts   = & _group.getPartition<SampleCount> ("counts",    nbTotalPartitions);
+
+        _group.addProperty ("kmer_size",  tools::misc::impl::Stringify::format("%d", _kmerSize));
+        _group.addProperty ("nb_samples", tools::misc::impl::Stringify::format("%d", _nbSamples));
+    }
+
+    /** \copydoc ICountProcessor<span>::clones */
+    CountProcessorAbstract<span>* clone ()
+    {
+        CountProcessorMatrix* result = new CountProcessorMatrix (_group, _kmerSize);
+
+        result->_nbPartsPerPass = _nbPartsPerPass;
+        result->_nbSamples      = _nbSamples;
+        result->_kmers          = _kmers;
+        result->_rowSizes       = _rowSizes;
+        result->_samples        = _samples;
+        result->_counts         = _counts;
+
+        return result;
+    }
+
+    /********************************************************************/
+    /*   METHODS CALLED ON ONE CLONED INSTANCE (in a separate thread).  */
+    /********************************************************************/
+
+    /** \copydoc ICountProcessor<span>::beginPart */
+    void beginPart (size_t passId, size_t partId, size_t cacheSize, const char* name)
+    {
+        size_t actualPartId = partId + (passId * _nbPartsPerPass);
+
+        /** The cache is shared between the columns; the cells ones get the biggest part. */
+        size_t rowCacheSize  = std::max (cacheSize / 8, (size_t)1);
+        size_t cellCacheSize = std::max (cacheSize / 4, (size_t)1);
+
+        setKmersBag    (new tools::collections::impl::BagCache<Type>        (& (*_kmers)   [actualPartId], rowCacheSize));
+        setRowSizesBag (new tools::collections::impl::BagCache<RowSize>     (& (*_rowSizes)[actualPartId], rowCacheSize));
+        setSamplesBag  (new tools::collections::impl::BagCache<SampleId>    (& (*_samples) [actualPartId], cellCacheSize));
+        setCountsBag   (new tools::collections::impl::BagCache<SampleCount> (& (*_counts)  [actualPartId], cellCacheSize));
+    }
+
+    /** \copydoc ICountProcessor<span>::endPart */
+    void endPart (size_t passId, size_t partId)
+    {
+        _kmersBag->flush();
+        _rowSizesBag->flush();
+        _samplesBag->flush();
+        _countsBag->flush();
+    }
+
+    /** \copydoc ICountProcessor<span>::process */
+    bool process (size_t partId, const Type& kmer, const CountVector& count, CountNumber sum)
+    {
+        u_int16_t nbCells = 0;
+
+        for (size_t i=0; i<count.size(); i++)
+        {
+            if (count[i] == 0)  { continue; }
+
+            _samplesBag->insert (SampleId    (i));
+            _countsBag->insert  (SampleCount (count[i]));
+            nbCells++;
+        }
+
+        _kmersBag->insert    (kmer);
+        _rowSizesBag->insert (RowSize (nbCells));
+
+        return true;
+    }
+
+    /*****************************************************************/
+    /*                          MISCELLANEOUS.                       */
+    /*****************************************************************/
+
+    /** \copydoc ICountProcessor<span>::getProperties */
+    tools::misc::impl::Properties getProperties() const
+    {
+        tools::misc::impl::Properties result;
+
+        u_int64_t nbKmers = _kmers   ? _kmers->getNbItems()   : 0;
+        u_int64_t nbCells = _samples ? _samples->getNbItems() : 0;
+
+        result.add (0, "matrix");
+        result.add (1, "nb_samples", "%ld",  _nbSamples);
+        result.add (1, "nb_kmers",   "%lld", nbKmers);
+        result.add (1, "nb_cells",   "%lld", nbCells);
+
+        if (nbKmers > 0 && _nbSamples > 0)
+        {
+            result.add (1, "density", "%.3f", (double)nbCells / ((double)nbKmers * (double)_nbSamples));
+        }
+
+        return result;
+    }
+
+private:
+
+    tools::storage::impl::Group& _group;
+
+    size_t _kmerSize;
+    size_t _nbPartsPerPass;
+    size_t _nbSamples;
+
+    /** The partitions are owned by the group; the clones only refer to them. */
+    tools::storage::impl::Partition<Type>*        _kmers;
+    tools::storage::impl::Partition<RowSize>*     _rowSizes;
+    tools::storage::impl::Partition<SampleId>*    _samples;
+    tools::storage::impl::Partition<SampleCount>* _counts;
+
+    tools::collections::Bag<Type>*        _kmersBag;
+    tools::collections::Bag<RowSize>*     _rowSizesBag;
+    tools::collections::Bag<SampleId>*    _samplesBag;
+    tools::collections::Bag<SampleCount>* _countsBag;
+
+    void setKmersBag    (tools::collections::Bag<Type>*        kmersBag)     { SP_SETATTR(kmersBag);    }
+    void setRowSizesBag (tools::collections::Bag<RowSize>*     rowSizesBag)  { SP_SETATTR(rowSizesBag); }
+    void setSamplesBag  (tools::collections::Bag<SampleId>*    samplesBag)   { SP_SETATTR(samplesBag);  }
+    void setCountsBag   (tools::collections::Bag<SampleCount>* countsBag)    { SP_SETATTR(countsBag);   }
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _COUNT_PROCESSOR_MATRIX_HPP_ */
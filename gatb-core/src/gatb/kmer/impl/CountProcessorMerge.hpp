@@ -0,0 +1,255 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef _COUNT_PROCESSOR_MERGE_HPP_
+#define _COUNT_PROCESSOR_MERGE_HPP_
+
+/********************************************************************************/
+
+#include <gatb/kmer/impl/Model.hpp>
+#include <gatb/kmer/impl/CountProcessorAbstract.hpp>
+#include <gatb/tools/storage/impl/Storage.hpp>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+namespace impl      {
+/********************************************************************************/
+
+/** The CountProcessorMerge implementation adds the counts of a previous counting to
+ * the counts of the current one, before giving them to another processor.
+ *
+ * The previous counts are the partitions dumped by a CountProcessorDump for the same
+ * minimizers repartition and the same number of passes, so the kmers of a partition
+ * of the current counting can only be in the same partition of the previous one.
+ * Both are sorted by kmer values, so a clone merges them while the kmers of its current
+ * partition are received; the kmers of the previous partition that are not in the
+ * current one are given when they are reached, or when the method 'endPart' is called.
+ *
+ * The referred processor then sees the merged counts, so its histogram, cutoffs and
+ * solidity are the ones of the previous and current inputs counted together.
+ *
+ * Note that the previous counts hold only one count per kmer, so the merge is only
+ * possible for the 'sum' solidity kind. Note also that the kmers filtered out by the
+ * solidity of the previous counting are lost: the merged counts are exact only if the
+ * previous counting kept all its kmers.
+ */
+template<size_t span=KMER_DEFAULT_SPAN>
+class CountProcessorMerge : public CountProcessorAbstract<span>
+{
+public:
+
+    typedef ICountProcessor<span> CountProcessor;
+    typedef typename Kmer<span>::Type  Type;
+    typedef typename Kmer<span>::Count Count;
+
+    /** Constructor.
+     * \param[in] ref : processor receiving the merged counts
+     * \param[in] previous : counts of the previous counting, one collection per partition
+     * \param[in] nbPartsPerPass : number of partitions per pass */
+    CountProcessorMerge (CountProcessor* ref, tools::storage::impl::Partition<Count>* previous, size_t nbPartsPerPass=0)
+        : CountProcessorAbstract<span>("merge"), _ref(0), _previous(0), _nbPartsPerPass(nbPartsPerPass),
+          _it(0), _hasCurrent(false), _hasPrevious(false), _count(1), _nbPrevious(0), _nbShared(0)
+    {
+        setRef      (ref);
+        setPrevious (previous);
+    }
+
+    /** Destructor. */
+    virtual ~CountProcessorMerge ()
+    {
+        setIt       (0);
+        setRef      (0);
+        setPrevious (0);
+    }
+
+    /********************************************************************/
+    /*   METHODS CALLED ON THE PROTOTYPE INSTANCE (in the main thread). */
+    /********************************************************************/
+
+    /** \copydoc ICountProcessor<span>::begin */
+    void begin (const Configuration& config)
+    {
+        if (_previous->size() != config._nb_partitions * config._nb_passes)
+        {
+            throw system::Exception ("Previous counts have %d partitions, not %d", _previous->size(), config._nb_partitions * config._nb_passes);
+        }
+
+        _nbPartsPerPass = config._nb_partitions;
+        _ref->begin (config);
+    }
+
+    /** \copydoc ICountProcessor<span>::end */
+    void end ()  { _ref->end (); }
+
+    /** \copydoc ICountProcessor<span>::beginPass */
+    void beginPass (size_t passId)  { _ref->beginPass (passId); }
+
+    /** \copydoc ICountProcessor<span>::endPass */
+    void endPass (size_t passId)  { _ref->endPass (passId); }
+
+    /** \copydoc ICountProcessor<span>::clone */
+    CountProcessorAbstract<span>* clone ()
+    {
+        return new CountProcessorMerge (_ref->clone(), _previous, _nbPartsPerPass);
+    }
+
+    /** \copydoc ICountProcessor<span>::finishClones */
+    void finishClones (std::vector<ICountProcessor<span>*>& clones)
+    {
+        std::vector<CountProcessor*> refClones;
+
+        for (size_t i=0; i<clones.size(); i++)
+        {
+            CountProcessorMerge* clone = dynamic_cast<CountProcessorMerge*> (clones[i]);
+            if (clone == 0)  { throw system::Exception ("Error in CountProcessorMerge::finishClones"); }
+
+            refClones.push_back (clone->_ref);
+            _nbPrevious += clone->_nbPrevious;
+            _nbShared   += clone->_nbShared;
+        }
+
+        _ref->finishClones (refClones);
+    }
+
+    /********************************************************************/
+    /*   METHODS CALLED ON ONE CLONED INSTANCE (in a separate thread).  */
+    /********************************************************************/
+
+    /** \copydoc ICountProcessor<span>::beginPart */
+    void beginPart (size_t passId, size_t partId, size_t cacheSize, const char* name)
+    {
+        /** We iterate the previous counts of the same partition. */
+        setIt ((*_previous)[partId + passId*_nbPartsPerPass].iterator());
+        _it->first();
+        _hasCurrent = _hasPrevious = false;
+
+        _ref->beginPart (passId, partId, cacheSize, name);
+    }
+
+    /** \copydoc ICountProcessor<span>::endPart */
+    void endPart (size_t passId, size_t partId)
+    {
+        /** We give the previous kmers beyond the last current one. */
+        for ( ; !_it->isDone(); _it->next())  {  forwardPrevious (partId);  }
+        setIt (0);
+
+        _ref->endPart (passId, partId);
+    }
+
+    /** \copydoc ICountProcessor<span>::process */
+    bool process (size_t partId, const Type& kmer, const CountVector& count, CountNumber sum=0)
+    {
+        checkOrder (kmer, _lastCurrent, _hasCurrent);
+
+        /** We give the previous kmers lower than the current one. */
+        for ( ; !_it->isDone() && _it->item().value < kmer; _it->next())  {  forwardPrevious (partId);  }
+
+        /** With the 'sum' solidity kind, there is one count per kmer. */
+        _count[0] = count[0];
+
+        if (!_it->isDone() && _it->item().value == kmer)
+        {
+            _count[0] += _it->item().abundance;
+            _nbPrevious++;
+            _nbShared++;
+            _it->next();
+        }
+
+        return _ref->process (partId, kmer, _count, _count[0]);
+    }
+
+    /*****************************************************************/
+    /*                          MISCELLANEOUS.                       */
+    /*****************************************************************/
+
+    /** \copydoc ICountProcessor<span>::getName */
+    std::string getName() const  { return _ref->getName(); }
+
+    /** \copydoc ICountProcessor<span>::setName */
+    void setName (const std::string& name)  { _ref->setName (name); }
+
+    /** \copydoc ICountProcessor<span>::getProperties */
+    tools::misc::impl::Properties getProperties() const
+    {
+        tools::misc::impl::Properties result;
+        result.add (0, _ref->getProperties());
+        result.add (0, "merge");
+        result.add (1, "nb_previous", "%lld", _nbPrevious);
+        result.add (1, "nb_shared",   "%lld", _nbShared);
+        return result;
+    }
+
+    /** \copydoc ICountProcessor<span>::getInstances */
+    std::vector<CountProcessor*> getInstances () const
+    {
+        std::vector<CountProcessor*> res = CountProcessorAbstract<span>::getInstances();
+        std::vector<CountProcessor*> c = _ref->getInstances();
+        res.insert (res.end(), c.begin(), c.end());
+        return res;
+    }
+
+private:
+
+    /** Give the current previous kmer alone to the referred processor. */
+    void forwardPrevious (size_t partId)
+    {
+        const Count& item = _it->item();
+        checkOrder (item.value, _lastPrevious, _hasPrevious);
+
+        _count[0] = item.abundance;
+        _ref->process (partId, item.value, _count, item.abundance);
+        _nbPrevious++;
+    }
+
+    /** The merge needs both kmers flows to be sorted; we check it rather than producing wrong counts. */
+    void checkOrder (const Type& kmer, Type& last, bool& hasLast)
+    {
+        if (hasLast && kmer < last)  { throw system::Exception ("Kmers are not sorted, unable to merge with previous counts"); }
+        last    = kmer;
+        hasLast = true;
+    }
+
+    CountProcessor* _ref;
+    void setRef (CountProcessor* ref)  { SP_SETATTR(ref); }
+
+    tools::storage::impl::Partition<Count>* _previous;
+    void setPrevious (tools::storage::impl::Partition<Count>* previous)  { SP_SETATTR(previous); }
+
+    size_t _nbPartsPerPass;
+
+    tools::dp::Iterator<Count>* _it;
+    void setIt (tools::dp::Iterator<Count>* it)  { SP_SETATTR(it); }
+
+    Type        _lastCurrent;
+    Type        _lastPrevious;
+    bool        _hasCurrent;
+    bool        _hasPrevious;
+    CountVector _count;
+
+    u_int64_t _nbPrevious;
+    u_int64_t _nbShared;
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _COUNT_PROCESSOR_MERGE_HPP_ */
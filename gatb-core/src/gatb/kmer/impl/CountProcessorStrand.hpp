@@ -0,0 +1,281 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef _COUNT_PROCESSOR_STRAND_HPP_
+#define _COUNT_PROCESSOR_STRAND_HPP_
+
+/********************************************************************************/
+
+#include <gatb/kmer/impl/CountProcessorAbstract.hpp>
+#include <algorithm>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+namespace impl      {
+/********************************************************************************/
+
+/** The CountProcessorStrand implementation receives the counts of the kmers as they
+ * are read (ie. strand specific kmers) and provides both canonical and stranded counts.
+ *
+ * A kmer and its reverse complement have the same canonical minimizer, so they are
+ * counted in the same partition. A clone gathers the stranded kmers of its current
+ * partition and, when the method 'endPart' is called, sums the counts of each kmer
+ * with the ones of its reverse complement; the canonical kmers and their counts are
+ * then given to the 'canonical' processor. If this processor accepts a canonical kmer
+ * (ie. it is solid), the stranded kmers it comes from are given to the 'stranded'
+ * processor, if any.
+ *
+ * This is used for the 'both' kmer orientation of SortingCountAlgorithm, with for instance:
+ *   canonical : histogram -> solidity -> dump
+ *   stranded  : dump
+ *
+ * Note that a clone holds the kmers of one partition, which is at most the memory used
+ * for counting the partition. Note also that the kmers are given to the sub processors
+ * without the sum of their counts, which is computed by a CountProcessorChain.
+ */
+template<size_t span=KMER_DEFAULT_SPAN>
+class CountProcessorStrand : public CountProcessorAbstract<span>
+{
+public:
+
+    typedef ICountProcessor<span> CountProcessor;
+    typedef typename Kmer<span>::Type Type;
+
+    /** Constructor.
+     * \param[in] canonical : processor of the canonical kmers
+     * \param[in] stranded : processor of the stranded kmers whose canonical kmer is accepted (may be null)
+     * \param[in] kmerSize : size of the kmers */
+    CountProcessorStrand (CountProcessor* canonical, CountProcessor* stranded, size_t kmerSize)
+        : CountProcessorAbstract<span>("strand"), _canonical(0), _stranded(0), _kmerSize(kmerSize), _nbBanks(0)
+    {
+        setCanonical (canonical);
+        setStranded  (stranded);
+    }
+
+    /** Destructor. */
+    virtual ~CountProcessorStrand ()
+    {
+        setCanonical (0);
+        setStranded  (0);
+    }
+
+    /** Get the processor of the canonical kmers.
+     * \return the processor. */
+    CountProcessor* getCanonical () const  { return _canonical; }
+
+    /** Get the processor of the stranded kmers.
+     * \return the processor, null if none. */
+    CountProcessor* getStranded () const  { return _stranded; }
+
+    /********************************************************************/
+    /*   METHODS CALLED ON THE PROTOTYPE INSTANCE (in the main thread). */
+    /********************************************************************/
+
+    /** \copydoc ICountProcessor<span>::begin */
+    void begin (const Configuration& config)
+    {
+        _kmerSize = config._kmerSize;
+        _canonical->begin (config);
+        if (_stranded)  { _stranded->begin (config); }
+    }
+
+    /** \copydoc ICountProcessor<span>::end */
+    void end ()
+    {
+        _canonical->end ();
+        if (_stranded)  { _stranded->end (); }
+    }
+
+    /** \copydoc ICountProcessor<span>::beginPass */
+    void beginPass (size_t passId)
+    {
+        _canonical->beginPass (passId);
+        if (_stranded)  { _stranded->beginPass (passId); }
+    }
+
+    /** \copydoc ICountProcessor<span>::endPass */
+    void endPass (size_t passId)
+    {
+        _canonical->endPass (passId);
+        if (_stranded)  { _stranded->endPass (passId); }
+    }
+
+    /** \copydoc ICountProcessor<span>::clone */
+    CountProcessorAbstract<span>* clone ()
+    {
+        return new CountProcessorStrand (_canonical->clone(), _stranded ? _stranded->clone() : 0, _kmerSize);
+    }
+
+    /** \copydoc ICountProcessor<span>::finishClones */
+    void finishClones (std::vector<ICountProcessor<span>*>& clones)
+    {
+        std::vector<CountProcessor*> canonicalClones, strandedClones;
+
+        for (size_t i=0; i<clones.size(); i++)
+        {
+            CountProcessorStrand* clone = dynamic_cast<CountProcessorStrand*> (clones[i]);
+            if (clone == 0)  { throw system::Exception ("Error in CountProcessorStrand::finishClones"); }
+
+            canonicalClones.push_back (clone->_canonical);
+            if (_stranded)  { strandedClones.push_back (clone->_stranded); }
+        }
+
+        _canonical->finishClones (canonicalClones);
+        if (_stranded)  { _stranded->finishClones (strandedClones); }
+    }
+
+    /********************************************************************/
+    /*   METHODS CALLED ON ONE CLONED INSTANCE (in a separate thread).  */
+    /********************************************************************/
+
+    /** \copydoc ICountProcessor<span>::beginPart */
+    void beginPart (size_t passId, size_t partId, size_t cacheSize, const char* name)
+    {
+        _items.clear();
+        _counts.clear();
+
+        _canonical->beginPart (passId, partId, cacheSize, name);
+        if (_stranded)  { _stranded->beginPart (passId, partId, cacheSize, name); }
+    }
+
+    /** \copydoc ICountProcessor<span>::endPart */
+    void endPart (size_t passId, size_t partId)
+    {
+        /** Now we have all the stranded kmers of the partition, so we can fold them. */
+        fold (partId);
+
+        _canonical->endPart (passId, partId);
+        if (_stranded)  { _stranded->endPart (passId, partId); }
+
+        /** We release the memory of the partition. */
+        std::vector<Item>().swap (_items);
+        CountVector().swap (_counts);
+    }
+
+    /** \copydoc ICountProcessor<span>::process */
+    bool process (size_t partId, const Type& kmer, const CountVector& count, CountNumber sum=0)
+    {
+        _nbBanks = count.size();
+
+        Type rev = revcomp (kmer, _kmerSize);
+        _items.push_back (Item (std::min (kmer, rev), kmer, _counts.size()));
+        _counts.insert (_counts.end(), count.begin(), count.end());
+
+        return true;
+    }
+
+    /*****************************************************************/
+    /*                          MISCELLANEOUS.                       */
+    /*****************************************************************/
+
+    /** \copydoc ICountProcessor<span>::getProperties */
+    tools::misc::impl::Properties getProperties() const
+    {
+        tools::misc::impl::Properties result;
+        result.add (0, _canonical->getProperties());
+        if (_stranded)  { result.add (0, _stranded->getProperties()); }
+        return result;
+    }
+
+    /** \copydoc ICountProcessor<span>::getInstances
+     * Note that the instances of the canonical processor come before the stranded ones. */
+    std::vector<CountProcessor*> getInstances () const
+    {
+        std::vector<CountProcessor*> res = CountProcessorAbstract<span>::getInstances();
+        std::vector<CountProcessor*> c = _canonical->getInstances();
+        res.insert (res.end(), c.begin(), c.end());
+        if (_stranded)
+        {
+            c = _stranded->getInstances();
+            res.insert (res.end(), c.begin(), c.end());
+        }
+        return res;
+    }
+
+private:
+
+    struct Item
+    {
+        Item (const Type& canonical, const Type& kmer, size_t offset) : canonical(canonical), kmer(kmer), offset(offset) {}
+
+        Type   canonical;
+        Type   kmer;
+        size_t offset;
+
+        bool operator< (const Item& other) const
+        {
+            if (canonical != other.canonical)  { return canonical < other.canonical; }
+            return kmer < other.kmer;
+        }
+    };
+
+    /** Give the canonical kmers of the partition to the canonical processor (sorted), and
+     * the stranded kmers of the accepted ones to the stranded processor. */
+    void fold (size_t partId)
+    {
+        std::sort (_items.begin(), _items.end());
+
+        CountVector canonicalCount (_nbBanks);
+        CountVector strandedCount  (_nbBanks);
+
+        for (size_t i=0; i<_items.size(); )
+        {
+            /** A canonical kmer comes from at most two stranded kmers. */
+            size_t j = i+1;
+            while (j<_items.size() && _items[j].canonical == _items[i].canonical)  { j++; }
+
+            for (size_t b=0; b<_nbBanks; b++)
+            {
+                canonicalCount[b] = 0;
+                for (size_t k=i; k<j; k++)  { canonicalCount[b] += _counts[_items[k].offset + b]; }
+            }
+
+            if (_canonical->process (partId, _items[i].canonical, canonicalCount) && _stranded)
+            {
+                for (size_t k=i; k<j; k++)
+                {
+                    std::copy (_counts.begin() + _items[k].offset, _counts.begin() + _items[k].offset + _nbBanks, strandedCount.begin());
+                    _stranded->process (partId, _items[k].kmer, strandedCount);
+                }
+            }
+
+            i = j;
+        }
+    }
+
+    CountProcessor* _canonical;
+    void setCanonical (CountProcessor* canonical)  { SP_SETATTR(canonical); }
+
+    CountProcessor* _stranded;
+    void setStranded (CountProcessor* stranded)  { SP_SETATTR(stranded); }
+
+    size_t _kmerSize;
+    size_t _nbBanks;
+
+    std::vector<Item> _items;
+    CountVector       _counts;
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _COUNT_PROCESSOR_STRAND_HPP_ */
@@ -0,0 +1,172 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef _COUNT_PROCESSOR_STREAM_HPP_
+#define _COUNT_PROCESSOR_STREAM_HPP_
+
+/********************************************************************************/
+
+#include <gatb/kmer/impl/CountProcessorAbstract.hpp>
+#include <gatb/kmer/api/IPartitionListener.hpp>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+namespace impl      {
+/********************************************************************************/
+
+/** The CountProcessorStream implementation publishes each counted partition to a list
+ * of IPartitionListener instances, as soon as the partition is done.
+ *
+ * A clone instance gathers the kmers of its current partition and publishes them when
+ * the method 'endPart' is called; the listeners are shared by all the clones, so the
+ * partitions are published concurrently and out of order.
+ *
+ * The CountProcessorStream implementation is likely to be used in a CountProcessorChain,
+ * like this : solidity -> dump -> stream.  It allows to stream only solid kmers, while
+ * they are still saved in the storage.
+ *
+ * Note that a clone holds the kmers of one partition, which is at most the memory used
+ * for counting the partition.
+ */
+template<size_t span=KMER_DEFAULT_SPAN>
+class CountProcessorStream : public CountProcessorAbstract<span>
+{
+public:
+
+    /** Shortcuts. */
+    typedef typename Kmer<span>::Count Count;
+    typedef typename Kmer<span>::Type  Type;
+    typedef IPartitionListener<span>   Listener;
+
+    /** Constructor.
+     * \param[in] listeners : the consumers of the counted partitions. */
+    CountProcessorStream (const std::vector<Listener*>& listeners = std::vector<Listener*>())
+        : CountProcessorAbstract<span>("stream"), _nbPartitions(0), _nbItems(0)
+    {
+        for (size_t i=0; i<listeners.size(); i++)  {  addListener (listeners[i]);  }
+    }
+
+    /** Destructor */
+    virtual ~CountProcessorStream ()
+    {
+        for (size_t i=0; i<_listeners.size(); i++)  {  _listeners[i]->forget();  }
+    }
+
+    /** Register a consumer of the counted partitions (must be called before the counting).
+     * \param[in] listener : the consumer. */
+    void addListener (Listener* listener)  {  if (listener)  { listener->use();  _listeners.push_back (listener); }  }
+
+    /********************************************************************/
+    /*   METHODS CALLED ON THE PROTOTYPE INSTANCE (in the main thread). */
+    /********************************************************************/
+
+    /** \copydoc ICountProcessor<span>::begin */
+    void begin (const Configuration& config)
+    {
+        for (size_t i=0; i<_listeners.size(); i++)  {  _listeners[i]->begin (config);  }
+    }
+
+    /** \copydoc ICountProcessor<span>::end */
+    void end ()
+    {
+        for (size_t i=0; i<_listeners.size(); i++)  {  _listeners[i]->end ();  }
+    }
+
+    /** \copydoc ICountProcessor<span>::clones */
+    CountProcessorAbstract<span>* clone ()  {  return new CountProcessorStream (_listeners);  }
+
+    /** \copydoc ICountProcessor<span>::finishClones */
+    void finishClones (std::vector<ICountProcessor<span>*>& clones)
+    {
+        for (size_t i=0; i<clones.size(); i++)
+        {
+            /** We have to recover type information. */
+            if (CountProcessorStream* clone = dynamic_cast<CountProcessorStream*> (clones[i]))
+            {
+                _nbPartitions += clone->_nbPartitions;
+                _nbItems      += clone->_nbItems;
+            }
+        }
+    }
+
+    /********************************************************************/
+    /*   METHODS CALLED ON ONE CLONED INSTANCE (in a separate thread).  */
+    /********************************************************************/
+
+    /** \copydoc ICountProcessor<span>::beginPart */
+    void beginPart (size_t passId, size_t partId, size_t cacheSize, const char* name)
+    {
+        _items.clear();
+    }
+
+    /** \copydoc ICountProcessor<span>::endPart */
+    void endPart (size_t passId, size_t partId)
+    {
+        for (size_t i=0; i<_listeners.size(); i++)  {  _listeners[i]->publish (passId, partId, _items);  }
+
+        _nbPartitions ++;
+        _nbItems += _items.size();
+
+        /** We release the memory of the partition. */
+        std::vector<Count>().swap (_items);
+    }
+
+    /** \copydoc ICountProcessor<span>::process */
+    bool process (size_t partId, const Type& kmer, const CountVector& count, CountNumber sum)
+    {
+        _items.push_back (Count(kmer,sum));
+        return true;
+    }
+
+    /*****************************************************************/
+    /*                          MISCELLANEOUS.                       */
+    /*****************************************************************/
+
+    /** \copydoc ICountProcessor<span>::getProperties */
+    tools::misc::impl::Properties getProperties() const
+    {
+        tools::misc::impl::Properties result;
+        result.add (0, "stream");
+        result.add (1, "nb_listeners",  "%ld", _listeners.size());
+        result.add (1, "nb_partitions", "%ld", _nbPartitions);
+        result.add (1, "nb_items",      "%ld", _nbItems);
+        return result;
+    }
+
+    /** Get the number of items published to the listeners.
+     * \return the number of items. */
+    u_int64_t getNbItems () const  { return _nbItems; }
+
+private:
+
+    std::vector<Listener*> _listeners;
+
+    std::vector<Count> _items;
+
+    size_t    _nbPartitions;
+    u_int64_t _nbItems;
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _COUNT_PROCESSOR_STREAM_HPP_ */
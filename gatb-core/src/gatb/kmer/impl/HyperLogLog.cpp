@@ -0,0 +1,108 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <gatb/kmer/impl/HyperLogLog.hpp>
+#include <gatb/system/api/Exception.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace gatb::core::system;
+
+/********************************************************************************/
+namespace gatb  {  namespace core  {   namespace kmer  {   namespace impl {
+/********************************************************************************/
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+HyperLogLog::HyperLogLog (size_t precision)
+    : _precision(precision)
+{
+    if (precision < 4 || precision > 18)  { throw Exception ("bad HyperLogLog precision %d (should be in [4,18])", precision); }
+
+    _registers.assign ((size_t)1 << precision, 0);
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+void HyperLogLog::merge (const HyperLogLog& other)
+{
+    if (other._precision != _precision)  { throw Exception ("can't merge HyperLogLog of different precisions (%d and %d)", _precision, other._precision); }
+
+    for (size_t i=0; i<_registers.size(); i++)  {  _registers[i] = std::max (_registers[i], other._registers[i]);  }
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+u_int64_t HyperLogLog::estimate () const
+{
+    double m = (double) _registers.size();
+
+    double sum    = 0;
+    size_t nbZero = 0;
+    for (size_t i=0; i<_registers.size(); i++)
+    {
+        sum += std::ldexp (1.0, -(int)_registers[i]);
+        if (_registers[i]==0)  { nbZero++; }
+    }
+
+    /** Bias correction constant (Flajolet et al.), for at least 128 registers. */
+    double alpha = _registers.size()==16 ? 0.673 : _registers.size()==32 ? 0.697 : _registers.size()==64 ? 0.709 : 0.7213 / (1.0 + 1.079/m);
+
+    double result = alpha * m * m / sum;
+
+    /** Small range correction : linear counting on the empty registers. */
+    if (result <= 2.5*m && nbZero > 0)  {  result = m * std::log (m / (double)nbZero);  }
+
+    return (u_int64_t) (result + 0.5);
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+double HyperLogLog::getError () const
+{
+    return 1.04 / std::sqrt ((double)_registers.size());
+}
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
@@ -0,0 +1,121 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/** \file HyperLogLog.hpp
+ *  \brief Estimation of a number of distinct items with a HyperLogLog sketch
+ */
+
+#ifndef _GATB_CORE_KMER_IMPL_HYPERLOGLOG_HPP_
+#define _GATB_CORE_KMER_IMPL_HYPERLOGLOG_HPP_
+
+/********************************************************************************/
+
+#include <gatb/system/api/types.hpp>
+#include <vector>
+#include <cstddef>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+namespace impl      {
+/********************************************************************************/
+
+/** \brief HyperLogLog sketch for estimating a number of distinct items
+ *
+ * The items are given as 64 bits hash codes (for instance 'oahash' of a kmer), which are mixed
+ * again before use. The sketch has 2^precision registers of one byte, ie. 16 KBytes for the
+ * default precision, for a relative standard error of 1.04/sqrt(2^precision) (0.8%), whatever
+ * the number of items. Small cardinalities are estimated by linear counting on the empty
+ * registers; there is no need for a large range correction with 64 bits hash codes.
+ *
+ * Sketches with the same precision can be merged, so each thread can fill its own sketch
+ * without synchronization; the merged sketch is the one of the union of the items.
+ *
+ * Example:
+ * \code
+ * HyperLogLog hll;
+ * for (it->first(); !it->isDone(); it->next())  { hll.add (oahash (it->item())); }
+ * std::cout << hll.estimate() << " +/- " << hll.getError() * hll.estimate() << std::endl;
+ * \endcode
+ */
+class HyperLogLog
+{
+public:
+
+    /** Default number of bits of the registers index. */
+    static const size_t DEFAULT_PRECISION = 14;
+
+    /** Constructor.
+     * \param[in] precision : number of bits of the registers index, in [4,18] */
+    HyperLogLog (size_t precision = DEFAULT_PRECISION);
+
+    /** Add an item to the sketch.
+     * \param[in] hash : hash code of the item */
+    void add (u_int64_t hash)
+    {
+        hash = mix (hash);
+
+        size_t    idx  = hash >> (64 - _precision);
+        u_int64_t rest = (hash << _precision) | ((u_int64_t)1 << (_precision-1));
+        u_int8_t  rank = __builtin_clzll (rest) + 1;
+
+        if (rank > _registers[idx])  { _registers[idx] = rank; }
+    }
+
+    /** Merge another sketch into this one.
+     * \param[in] other : sketch to be merged (must have the same precision) */
+    void merge (const HyperLogLog& other);
+
+    /** Estimate the number of distinct items added to the sketch.
+     * \return the estimation. */
+    u_int64_t estimate () const;
+
+    /** Get the relative standard error of the estimation.
+     * \return the error. */
+    double getError () const;
+
+    /** Get the precision of the sketch.
+     * \return the number of bits of the registers index. */
+    size_t getPrecision () const  { return _precision; }
+
+    /** Get the memory used by the registers.
+     * \return the memory (in bytes). */
+    size_t getMemory () const  { return _registers.size(); }
+
+private:
+
+    /** Finalizer of MurmurHash3, so that the weak hash codes also have uniform bits. */
+    static u_int64_t mix (u_int64_t h)
+    {
+        h ^= h >> 33;  h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;  h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t                _precision;
+    std::vector<u_int8_t> _registers;
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _GATB_CORE_KMER_IMPL_HYPERLOGLOG_HPP_ */
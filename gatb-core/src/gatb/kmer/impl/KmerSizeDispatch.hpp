@@ -0,0 +1,100 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/** \file KmerSizeDispatch.hpp
+ *  \brief Dispatch of a runtime kmer size to kernels compiled for a constant kmer size
+ */
+
+#ifndef _GATB_CORE_KMER_IMPL_KMER_SIZE_DISPATCH_HPP_
+#define _GATB_CORE_KMER_IMPL_KMER_SIZE_DISPATCH_HPP_
+
+/********************************************************************************/
+
+#include <gatb/system/api/config.hpp>
+
+#include <boost/mpl/vector.hpp>
+#include <boost/mpl/front.hpp>
+#include <boost/mpl/pop_front.hpp>
+#include <boost/mpl/empty.hpp>
+#include <boost/mpl/int.hpp>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+namespace impl      {
+/********************************************************************************/
+
+/** List of the kmer sizes for which the hot loops are also compiled with a constant kmer size.
+ * It is empty unless the library is configured with 'cmake -DKSIZE_SPECIALIZED="21 31 51 63"'
+ * (see KSIZE_SPECIALIZED_LIST_TYPE in config.hpp). */
+typedef boost::mpl::vector<KSIZE_SPECIALIZED_LIST_TYPE>::type  KmerSizeSpecializedList;
+
+/** \brief Calls a functor with the kmer size as a compile time constant.
+ *
+ * The functor provides a 'Result' type and a 'template<int K> Result operator() ()' method.
+ * If the runtime kmer size is one of the specialized sizes (and fits the span), the functor
+ * is called with K equal to this kmer size, so masks, shifts and loop bounds can be constant
+ * folded; otherwise it is called with K=0, meaning that the kmer size is only known at runtime.
+ *
+ * The recursion follows the one of IntegerTemplate::Apply.
+ */
+template<size_t span, class T=KmerSizeSpecializedList, bool empty=boost::mpl::empty<T>::value>
+struct KmerSizeDispatch  {};
+
+/** Template specialization for a non empty list of kmer sizes. */
+template<size_t span, class T>
+struct KmerSizeDispatch<span, T, false>
+{
+    /** Shortcut : the current kmer size of the list, ignored (ie. 0) if too big for the span. */
+    static const int K = boost::mpl::front<T>::type::value < (int)span ? boost::mpl::front<T>::type::value : 0;
+
+    typedef typename boost::mpl::pop_front<T>::type tail;
+    typedef KmerSizeDispatch<span, tail, boost::mpl::empty<tail>::value> Next;
+
+    /** Tells whether a kernel is compiled for the given kmer size. */
+    static bool isSpecialized (size_t kmerSize)  {  return (K>0 && kmerSize == (size_t)K) || Next::isSpecialized (kmerSize);  }
+
+    template<class Functor>
+    static typename Functor::Result execute (size_t kmerSize, Functor& functor)
+    {
+        if (K>0 && kmerSize == (size_t)K)  {  return functor.template operator()<K> ();  }
+
+        return Next::execute (kmerSize, functor);
+    }
+};
+
+/** Template specialization for an empty list: generic kernel. */
+template<size_t span, class T>
+struct KmerSizeDispatch<span, T, true>
+{
+    static bool isSpecialized (size_t kmerSize)  {  return false;  }
+
+    template<class Functor>
+    static typename Functor::Result execute (size_t kmerSize, Functor& functor)
+    {
+        return functor.template operator()<0> ();
+    }
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _GATB_CORE_KMER_IMPL_KMER_SIZE_DISPATCH_HPP_ */
@@ -40,6 +40,8 @@
 
 #include <gatb/tools/math/Integer.hpp>
 
+#include <gatb/kmer/impl/KmerSizeDispatch.hpp>
+
 #include <gatb/tools/storage/impl/Storage.hpp>
 
 #include <vector>
@@ -182,16 +184,6 @@ struct Kmer
         Type _value;
         bool _isValid;
         friend class ModelDirect;
-
-        /** Extract a mmer from a kmer. This is done by using a mask on the kmer.
-         * \param[in] mask : mask to be applied to the current kmer
-         * \param[in] size : shift size (needed for some kmer classes but not all)
-         * \param[in] mmer_lut : lookup table of minimizers
-         * \return the extracted kmer.
-         */
-
-        KmerDirect extract      (const Type& mask, size_t size, Type * mmer_lut)  {  KmerDirect output;  output.set (mmer_lut[(this->value() & mask).getVal()]);  return output;  }
-        KmerDirect extractShift (const Type& mask, size_t size, Type * mmer_lut)  {  KmerDirect output = extract(mask,size,mmer_lut);  _value = _value >> 2;  return output;  }
     };
 
     /** \brief Kmer type for the ModelCanonical class.
@@ -293,33 +285,6 @@ struct Kmer
         bool _isValid;
         void updateChoice () { choice = (table[0] < table[1]) ? 0 : 1; }
         friend class ModelCanonical;
-
-        /** Extract a mmer from a kmer. This is done by using a mask on the kmer.
-         * \param[in] mask : mask to be applied to the current kmer
-         * \param[in] size : shift size (needed for some kmer classes but not all)
-         * \param[in] mmer_lut : lookup table of minimizers
-         * \return the extracted kmer.
-         */
-        KmerCanonical extract (const Type& mask, size_t size, Type* mmer_lut)
-        {
-
-            KmerCanonical output;
-			
-			output.set(mmer_lut[(this->table[0] & mask).getVal()]); //no need to recomp updateChoice with this
-			//mmer_lut takes care of revcomp and forbidden mmers
-			//output.set (this->table[0] & mask, (this->table[1] >> size) & mask);
-            //output.updateChoice();
-            return output;
-        }
-
-
-        KmerCanonical extractShift (const Type& mask, size_t size, Type * mmer_lut)
-        {
-            KmerCanonical output = extract (mask, size,mmer_lut);
-            table[0] = table[0] >> 2;   table[1] = table[1] << 2;  updateChoice();
-            return output;
-        }
-       
      };
 
     /** \brief Kmer type for the ModelMinimizer class.
@@ -363,6 +328,137 @@ struct Kmer
         friend class ModelMinimizer<Model,Comparator>;
     };
 
+    /** \brief Kmers of a block of sequences, as separate arrays
+     *
+     * A batch holds the kmers of several sequences (for instance the block of sequences that a dispatcher
+     * gives to a thread) as separate arrays rather than as a vector of Kmer objects: forward values,
+     * canonical values, strands and invalid flags (kmers built with unwanted nucleotides like N), the two
+     * last ones as arrays of bits. A loop on one of these attributes (hashing the canonical values for a
+     * Bloom filter for instance) then reads contiguous memory and may be vectorized by the compiler.
+     *
+     * The arrays are aligned on 64 bytes. A batch is filled by the 'build' method of a model and may be
+     * reused from one block to another; its memory is reallocated only when it grows.
+     *
+     * Example of use:
+     * \code
+     *  KmerBatch batch;
+     *  model.build (sequences, batch);
+     *  for (size_t i=0; i<batch.size(); i++)  {  if (batch.isValid(i))  { bloom->insert (batch.canonical()[i]); }  }
+     * \endcode
+     */
+    class KmerBatch
+    {
+    public:
+
+        /** Constructor. */
+        KmerBatch () : _size(0), _capacity(0), _forward(0), _canonical(0), _strands(0), _invalid(0), _buffer(0)  {}
+
+        /** Destructor. */
+        ~KmerBatch ()  {  if (_buffer != 0)  { FREE (_buffer); }  }
+
+        /** Returns the number of kmers in the batch.
+         * \return the number of kmers. */
+        size_t size () const  { return _size; }
+
+        /** Returns the number of sequences whose kmers are in the batch.
+         * \return the number of sequences. */
+        size_t getNbSequences () const  { return _offsets.empty() ? 0 : _offsets.size()-1; }
+
+        /** Returns the index of the first kmer of a sequence; the kmers of the sequence i are in
+         * [getOffset(i), getOffset(i+1)[, which is empty if the sequence is shorter than the kmers.
+         * \param[in] seqIdx : index of the sequence, up to getNbSequences() included.
+         * \return the index of the kmer. */
+        size_t getOffset (size_t seqIdx) const  { return _offsets[seqIdx]; }
+
+        /** Returns the array of the forward values of the kmers.
+         * \return the array of 'size' values. */
+        const Type* forward () const  { return _forward; }
+
+        /** Returns the array of the canonical values of the kmers (the forward values for a direct model).
+         * \return the array of 'size' values. */
+        const Type* canonical () const  { return _canonical; }
+
+        /** Returns the array of strands: the bit i%64 of the word i/64 is set if the canonical value of the
+         * kmer i is its reverse complement.
+         * \return the array of (size+63)/64 words. */
+        const u_int64_t* strands () const  { return _strands; }
+
+        /** Returns the array of invalid flags: the bit i%64 of the word i/64 is set if the kmer i is invalid.
+         * \return the array of (size+63)/64 words. */
+        const u_int64_t* invalid () const  { return _invalid; }
+
+        /** Tells whether a kmer is valid.
+         * \param[in] idx : index of the kmer.
+         * \return true if valid, false otherwise. */
+        bool isValid (size_t idx) const  { return ((_invalid[idx>>6] >> (idx&63)) & 1) == 0; }
+
+        /** Tells which strand is used for the canonical value of a kmer.
+         * \param[in] idx : index of the kmer.
+         * \return the strand. */
+        Strand strand (size_t idx) const  { return ((_strands[idx>>6] >> (idx&63)) & 1) ? STRAND_REVCOMP : STRAND_FORWARD; }
+
+        /** Prepares the batch for the kmers of some sequences; used by the models.
+         * \param[in] nbKmers : number of kmers
+         * \param[in] offsets : index of the first kmer of each sequence, followed by nbKmers. */
+        void reset (size_t nbKmers, const std::vector<size_t>& offsets)
+        {
+            if (nbKmers > _capacity)
+            {
+                if (_buffer != 0)  { FREE (_buffer); }
+
+                _capacity = nbKmers;
+                _buffer   = (char*) MALLOC (4*ALIGNMENT + 2*_capacity*sizeof(Type) + 2*nbWords(_capacity)*sizeof(u_int64_t));
+
+                _forward   = (Type*)      align (_buffer);
+                _canonical = (Type*)      align ((char*) (_forward   + _capacity));
+                _strands   = (u_int64_t*) align ((char*) (_canonical + _capacity));
+                _invalid   = (u_int64_t*) align ((char*) (_strands   + nbWords(_capacity)));
+            }
+
+            _size    = nbKmers;
+            _offsets = offsets;
+
+            memset (_strands, 0, nbWords(_size)*sizeof(u_int64_t));
+            memset (_invalid, 0, nbWords(_size)*sizeof(u_int64_t));
+        }
+
+        /** Sets a kmer of the batch; used by the models.
+         * \param[in] idx : index of the kmer
+         * \param[in] forward : forward value
+         * \param[in] canonical : canonical value
+         * \param[in] revcomp : true if the canonical value is the reverse complement
+         * \param[in] invalid : true if the kmer is invalid */
+        void set (size_t idx, const Type& forward, const Type& canonical, bool revcomp, bool invalid)
+        {
+            _forward  [idx] = forward;
+            _canonical[idx] = canonical;
+            _strands [idx>>6] |= (u_int64_t)revcomp << (idx&63);
+            _invalid [idx>>6] |= (u_int64_t)invalid << (idx&63);
+        }
+
+    private:
+
+        static const size_t ALIGNMENT = 64;
+
+        static size_t nbWords (size_t nbKmers)  { return (nbKmers+63) / 64; }
+
+        static char* align (char* ptr)  { return ptr + (ALIGNMENT - (size_t)ptr % ALIGNMENT) % ALIGNMENT; }
+
+        size_t     _size;
+        size_t     _capacity;
+        Type*      _forward;
+        Type*      _canonical;
+        u_int64_t* _strands;
+        u_int64_t* _invalid;
+        char*      _buffer;
+
+        std::vector<size_t> _offsets;
+
+        /* A batch can't be copied. */
+        KmerBatch (const KmerBatch&);
+        KmerBatch& operator= (const KmerBatch&);
+    };
+
     /** Abstract class that provides kmer management.
      *
      * This class is the base class for kmer management. It provides several services on this purpose
@@ -415,6 +511,9 @@ struct Kmer
             /** The _revcompTable is a shortcut used while computing revcomp recursively. */
             /** Important: don't forget the Type cast, otherwise the result in only on 32 bits. */
             for (size_t i=0; i<4; i++)   {  Type tmp; tmp.setVal(comp_NT[i]);  _revcompTable[i] = tmp << shift;  }
+
+            /** We look whether the kmers iteration can use a kernel compiled for this very kmer size. */
+            _isSpecialized = KmerSizeDispatch<span>::isSpecialized (_kmerSize);
         }
 
         /** Returns the span of the model
@@ -433,6 +532,10 @@ struct Kmer
          * \return the maximum kmer value. */
         const Type& getKmerMax () const { return _kmerMask; }
 
+        /** Tells whether the kmers are iterated with a kernel compiled for this kmer size (see KmerSizeDispatch).
+         * \return true if the kmer size is one of the specialized kmer sizes of the build. */
+        bool isSpecialized () const { return _isSpecialized; }
+
         /** Returns an ascii representation of the kmer value.
          * \param[in] kmer : the kmer we want an ascii representation for
          * \return a string instance holding the ascii representation. */
@@ -512,6 +615,34 @@ struct Kmer
             return true;
         }
 
+        /** Build the kmers of a block of sequences into a batch of separate arrays (see KmerBatch).
+         * \param[in] sequences : container of objects with a 'getData' method, like a vector of Sequence
+         *  (for instance the items retrieved in one block by Iterator::get).
+         * \param[out] batch : the kmers of the sequences, in the order of the sequences.
+         * \return the number of kmers in the batch. */
+        template<class Container>
+        size_t build (Container& sequences, KmerBatch& batch)  const
+        {
+            /** We compute the number of kmers of each sequence, so the batch is allocated once. */
+            std::vector<size_t> offsets (1, 0);
+
+            for (size_t i=0; i<sequences.size(); i++)
+            {
+                int32_t nbKmers = sequences[i].getData().size() - this->getKmerSize() + 1;
+                offsets.push_back (offsets.back() + (nbKmers > 0 ? nbKmers : 0));
+            }
+
+            batch.reset (offsets.back(), offsets);
+
+            /** We fill the arrays through a functor. */
+            for (size_t i=0; i<sequences.size(); i++)
+            {
+                if (offsets[i+1] > offsets[i])  {  this->iterate (sequences[i].getData(), BatchFunctor (batch, offsets[i]));  }
+            }
+
+            return batch.size();
+        }
+
         /** Iterate the neighbors of a given kmer; these neighbors are:
          *  - 4 outgoing neighbors (with nt A,C,T,G)
          *  - 4 incoming neighbors (with nt A,C,T,G)
@@ -632,6 +763,28 @@ struct Kmer
         /* Shortcut for easing/speeding up the recursive revcomp computation. */
         Type _revcompTable[4];
 
+        /* Tells whether the kmer size has a specialized iteration kernel. */
+        bool _isSpecialized;
+
+        /* Kmer mask, either from the attribute (K=0) or constant folded for a compile time kmer size K. */
+        template<int K>
+        Type kmerMask () const
+        {
+            if (K==0)  { return _kmerMask; }
+            Type un;  un.setVal(1);
+            return (un << (2*K)) - un;
+        }
+
+        /* Complement of a nucleotide at the first position of the kmer, either from _revcompTable (K=0)
+         * or constant folded for a compile time kmer size K. */
+        template<int K>
+        Type revcompNucleotide (int c) const
+        {
+            if (K==0)  { return _revcompTable[c]; }
+            Type tmp;  tmp.setVal (comp_NT[c]);
+            return tmp << (2*(K>0 ? K-1 : 0));
+        }
+
         /* \return -1 if valid, otherwise index of the last found bad character. */
         template<class Convert>
         int polynom (const char* seq, Type& kmer, size_t startIndex)  const
@@ -715,6 +868,21 @@ struct Kmer
             }
         };
 
+        /* Adaptor between the 'iterate' method and the KmerSizeDispatch, which provides the kmer size
+         * as a compile time constant K (or K=0 for the generic kernel). */
+        template<typename Callback, typename Convert>
+        struct Functor_iterateKernel
+        {
+            typedef bool Result;
+            const ModelAbstract* model; const char* seq; size_t length; Callback& callback;
+            Functor_iterateKernel (const ModelAbstract* model, const char* seq, size_t length, Callback& callback)
+                : model(model), seq(seq), length(length), callback(callback) {}
+            template<int K>  Result operator() ()
+            {
+                return model->template iterateKernel<Callback, Convert, K> (seq, length, callback);
+            }
+        };
+
         /** Template method that iterates the kmer of a given sequence (provided as a buffer and its length).
          *  Note : we use static polymorphism here (http://en.wikipedia.org/wiki/Template_metaprogramming)
          *  \param[in] seq : the sequence to be iterated
@@ -725,9 +893,23 @@ struct Kmer
         template<typename Callback, typename Convert>
         bool iterate (const char* seq, size_t length, Callback callback) const
         {
+            /** Most of the time, there is no kernel for the kmer size and we go directly to the generic one. */
+            if (_isSpecialized == false)  {  return iterateKernel<Callback, Convert, 0> (seq, length, callback);  }
+
+            Functor_iterateKernel<Callback,Convert> functor (this, seq, length, callback);
+            return KmerSizeDispatch<span>::execute (_kmerSize, functor);
+        }
+
+        /** Implementation of 'iterate' for a kmer size known at compile time (K>0) or at runtime (K=0).
+         * With K>0, the masks, shifts and loop bounds of the model 'next' method are constant folded. */
+        template<typename Callback, typename Convert, int K>
+        bool iterateKernel (const char* seq, size_t length, Callback& callback) const
+        {
+            const size_t kmerSize = K>0 ? K : _kmerSize;
+
             /** We compute the number of kmers for the provided data. Note that we have to check that we have
              * enough nucleotides according to the current kmer size. */
-            int32_t nbKmers = length - _kmerSize + 1;
+            int32_t nbKmers = length - kmerSize + 1;
             if (nbKmers <= 0)  { return false; }
 
             /** We create a result instance. */
@@ -744,18 +926,18 @@ struct Kmer
 
             /** We compute the following kmers from the first one.
              * We have consumed 'kmerSize' nucleotides so far for computing the first kmer,
-             * so we start the loop with idx=_kmerSize.
+             * so we start the loop with idx=kmerSize.
              */
-            for (size_t idx=_kmerSize; idx<length; idx++)
+            for (size_t idx=kmerSize; idx<length; idx++)
             {
                 /** We get the current nucleotide. */
                 ConvertChar c = Convert::get (seq, idx);
 
-                if (c.second)  { indexBadChar = _kmerSize-1; }
+                if (c.second)  { indexBadChar = kmerSize-1; }
                 else           { indexBadChar--;     }
 
                 /** We compute the next kmer from the previous one. */
-                static_cast<const ModelImpl*>(this)->template next<Convert> (c.first, result, indexBadChar<0);
+                static_cast<const ModelImpl*>(this)->template next<Convert,K> (c.first, result, indexBadChar<0);
 
                 /** We notify the result. */
                 this->notification<Callback> (result, ++idxComputed, callback);
@@ -775,6 +957,17 @@ struct Kmer
             BuildFunctor (std::vector<Type>& kmersBuffer) : kmersBuffer(kmersBuffer) {}
             void operator() (const Type& kmer, size_t idx)  {  kmersBuffer[idx] = kmer;  }
         };
+
+        /** */
+        struct BatchFunctor
+        {
+            KmerBatch& batch;  size_t offset;
+            BatchFunctor (KmerBatch& batch, size_t offset) : batch(batch), offset(offset) {}
+            void operator() (const Kmer& kmer, size_t idx)
+            {
+                batch.set (offset+idx, kmer.forward(), kmer.value(), !kmer.which(), !kmer.isValid());
+            }
+        };
 		
     };
 
@@ -820,11 +1013,12 @@ struct Kmer
          * \param[in] c : next nucleotide
          * \param[out] value : kmer to be updated with the provided next nucleotide
          * \param[in] isValid : tells whether the updated kmer is valid or not
+         * The K template parameter, if not 0, is the kmer size known at compile time.
          */
-        template <class Convert>
+        template <class Convert, int K=0>
         void  next (char c, Kmer& value, bool isValid)   const
         {
-            value._value   = ( (value._value << 2) +  c) & this->_kmerMask;
+            value._value   = ( (value._value << 2) +  c) & this->template kmerMask<K>();
             value._isValid = isValid;
         }
 	};
@@ -872,12 +1066,13 @@ struct Kmer
          * \param[in] c : next nucleotide
          * \param[out] value : kmer to be updated with the provided next nucleotide
          * \param[in] isValid : tells whether the updated kmer is valid or not
+         * The K template parameter, if not 0, is the kmer size known at compile time.
          */
-        template <class Convert>
+        template <class Convert, int K=0>
         void  next (char c, Kmer& value, bool isValid)   const
         {
-            value.table[0] = ( (value.table[0] << 2) +  c                          ) & this->_kmerMask;
-            value.table[1] = ( (value.table[1] >> 2) +  this->_revcompTable[(int)c]) & this->_kmerMask;
+            value.table[0] = ( (value.table[0] << 2) +  c                                            ) & this->template kmerMask<K>();
+            value.table[1] = ( (value.table[1] >> 2) +  this->template revcompNucleotide<K>((int)c)) & this->template kmerMask<K>();
             value._isValid = isValid;
 
             value.updateChoice();
@@ -1012,6 +1207,7 @@ struct Kmer
               _kmerModel(kmerSize), _miniModel(minimizerSize), _cmp(cmp), _freq_order(freq_order)
         {
             if (kmerSize < minimizerSize)  { throw system::Exception ("Bad values for kmer %d and minimizer %d", kmerSize, minimizerSize); }
+            if (minimizerSize > 31)        { throw system::Exception ("Minimizer size %d is too large (max 31)", minimizerSize); }
 
             _minimizerSize = minimizerSize;
 			
@@ -1020,8 +1216,13 @@ struct Kmer
 
             /** We need a mask to extract a mmer from a kmer. */
 
-            _mask.setVal(((u_int64_t)1 << (2*_minimizerSize)) - 1);
-            _shift = 2*(_nbMinimizers-1);
+            _mmerMask = ((u_int64_t)1 << (2*_minimizerSize)) - 1;
+
+            /** We need a mask to find the AA dinucleotides of a mmer, except at its beginning (see is_allowed).
+             * Every minimizer is allowed in frequency order. */
+            //       A C T G        00   01   10   11
+            //       m = 8 gives    00 00 01 01 01 01 01 01
+            _mmerMaskAA = (freq_order || _minimizerSize < 2) ? 0 : 0x5555555555555555ULL & (((u_int64_t)1 << ((_minimizerSize-2)*2)) - 1);
 
             /** We initialize the default value of the minimizer.
              * The value is actually set by the Comparator instance provided as a template of the class. */
@@ -1029,39 +1230,30 @@ struct Kmer
             _cmp.template init<ModelType> (getMmersModel(), tmp);
             _minimizerDefault.set (tmp); //////////max value of minim
 			
-			u_int64_t nbminims_total = ((u_int64_t)1 << (2*_minimizerSize));
-			_mmer_lut = (Type *) MALLOC(sizeof(Type) * nbminims_total ); //free that in destructor
-                
             /* if it's ModelDirect, don't do a revcomp; also, use slow method */
             ModelCanonical* isModelCanonical_p = dynamic_cast<ModelCanonical*>(&_kmerModel);
             bool isModelCanonical = isModelCanonical_p != NULL;
             _defaultFast = isModelCanonical;
 
-			for(u_int64_t ii=0; ii< nbminims_total; ii++)
-			{
-				Type mmer;
-				mmer.setVal(ii);
-				
-				// if(!is_allowed(mmer.getVal(),minimizerSize)) mmer = _mask;
-				// if(!is_allowed(rev_mmer.getVal(),minimizerSize)) rev_mmer = _mask;
-				
-				if (isModelCanonical)
-				{
-					Type rev_mmer = revcomp(mmer, minimizerSize);
-					if(rev_mmer < mmer) mmer = rev_mmer;
-					
-					//may be cleaner with this
-					//if (_cmp (rev_mmer, mmer ) == true)
-					//	mmer = rev_mmer;
-				}
-				
-				//std:: cout << "ii " << ii << " is allowed " << is_allowed(mmer.getVal(),minimizerSize) <<  " mmer getval " << mmer.getVal() << " is model canonical " << isModelCanonical << std::endl;
-				
-				if (!is_allowed(mmer.getVal(),minimizerSize))
-					mmer = _mask;
-				
-				_mmer_lut[ii] = mmer;
-			}
+            /** For small mmers, a table of the 4^m mmers fits in the caches and is faster than computing them. */
+            if (_minimizerSize <= 8)
+            {
+                _mmerTable.resize ((size_t)1 << (2*_minimizerSize));
+
+                for (u_int64_t ii=0; ii<_mmerTable.size(); ii++)
+                {
+                    Type mmer;  mmer.setVal (ii);
+                    u_int64_t value = ii;
+
+                    if (isModelCanonical)
+                    {
+                        u_int64_t rev = revcomp (mmer, minimizerSize).getVal();
+                        if (rev < value)  { value = rev; }
+                    }
+
+                    _mmerTable[ii] = is_allowed (value) ? value : _mmerMask;
+                }
+            }
 
             if (freq_order)
                 setMinimizersFrequency(freq_order);
@@ -1070,13 +1262,6 @@ struct Kmer
         }
 
 
-
-        /** Destructor */
-        ~ModelMinimizer ()
-        {
-            if (_mmer_lut != 0)  { FREE (_mmer_lut); }
-        }
-
         /** Computes a kmer from a buffer holding nucleotides encoded in some format.
          * The way to interpret the buffer is done through the provided Convert template class.
          * \param[in] seq : holds the nucleotides sequence from which the kmer has to be computed
@@ -1102,18 +1287,19 @@ struct Kmer
          * \param[in] c : next nucleotide
          * \param[out] kmer : kmer to be updated with the provided next nucleotide
          * \param[in] isValid : tells whether the updated kmer is valid or not
+         * The K template parameter, if not 0, is the kmer size known at compile time.
          */
-        template <class Convert>
+        template <class Convert, int K=0>
         void  next (char c, Kmer& kmer, bool isValid) const
         {
             /** We compute the next kmer. */
-            _kmerModel.template next<Convert> (c, kmer, isValid);
+            _kmerModel.template next<Convert,K> (c, kmer, isValid);
 
             /** We set the valid status according to the Convert result. */
             kmer._isValid = isValid;
 
-            /** We extract the new mmer from the kmer. also applies the mmer_lut */
-            typename ModelType::Kmer mmer = kmer.extract (this->_mask, this->_shift,_mmer_lut);
+            /** We extract the new mmer from the kmer (with its revcomp and forbidden mmers handled by getMmer). */
+            typename ModelType::Kmer mmer;  mmer.set (getMmer (kmer, _nbMinimizers-1));
 
             /** We update the position of the previous minimizer. */
             kmer._position--;
@@ -1205,10 +1391,10 @@ struct Kmer
         size_t     _minimizerSize;
         Comparator _cmp;
         size_t     _nbMinimizers;
-        Type       _mask;
 
-		Type * _mmer_lut;
-        size_t     _shift;
+        u_int64_t  _mmerMask;
+        u_int64_t  _mmerMaskAA;
+        std::vector<u_int32_t> _mmerTable;
         typename ModelType::Kmer _minimizerDefault;
         bool       _defaultFast;
 
@@ -1217,23 +1403,12 @@ struct Kmer
 
         /** Tells whether a minimizer is valid or not, in order to skip minimizers
          *  that are too frequent. */
-        bool is_allowed (uint32_t mmer, uint32_t len)
+        bool is_allowed (u_int64_t mmer) const
 		{
-			if (_freq_order) return true; // every minimizer is allowed in freq order
-			
-			u_int64_t  _mmask_m1  ;
-			u_int64_t  _mask_0101 ;
-			u_int64_t  _mask_ma1 ;
-			
 			//code to ban mmer with AA inside except if at the beginnning
-			// A C T G        00   01   10   11
-			_mmask_m1  = (1 << ((len-2)*2)) -1 ; //vire 2 premieres lettres m = 8  donne    00 00 11 11 11 11 11 11
-			_mask_0101 = 0x5555555555555555  ; //         01 01 01 01 01 01 01 01
-			_mask_ma1  = _mask_0101 & _mmask_m1;//        00 00 01 01 01 01 01 01
-			
 			u_int64_t a1 = mmer; //
 			a1 =   ~(( a1 )   | (  a1 >>2 ));  //
-			a1 =((a1 >>1) & a1) & _mask_ma1 ;  //
+			a1 =((a1 >>1) & a1) & _mmerMaskAA ;  //
 			
 			if(a1 != 0) return false;
 			
@@ -1249,7 +1424,36 @@ struct Kmer
 			
 			return true;
 		}
-		
+
+        /** Returns the mmer at the given position of a canonical kmer: the lowest of its forward and
+         * reverse complement values, or the mask if it is not allowed. Except for small mmers, they are
+         * computed from the kmer rather than looked up in a table of 4^m mmers, which would not fit in the caches. */
+        Type getMmer (const KmerMinimizer<ModelCanonical, Comparator>& kmer, size_t idx) const
+        {
+            Type result;
+
+            u_int64_t forward = (kmer.value(0) >> (2*(_nbMinimizers-1-idx))).getVal() & _mmerMask;
+            if (!_mmerTable.empty())  {  result.setVal (_mmerTable[forward]);  return result;  }
+
+            u_int64_t revcomp = (kmer.value(1) >> (2*idx)).getVal() & _mmerMask;
+            u_int64_t mmer    = revcomp < forward ? revcomp : forward;
+
+            result.setVal (is_allowed (mmer) ? mmer : _mmerMask);
+            return result;
+        }
+
+        /** Returns the mmer at the given position of a direct kmer, or the mask if it is not allowed. */
+        Type getMmer (const KmerMinimizer<ModelDirect, Comparator>& kmer, size_t idx) const
+        {
+            Type result;
+
+            u_int64_t mmer = (kmer.value(0) >> (2*(_nbMinimizers-1-idx))).getVal() & _mmerMask;
+            if (!_mmerTable.empty())  {  result.setVal (_mmerTable[mmer]);  return result;  }
+
+            result.setVal (is_allowed (mmer) ? mmer : _mmerMask);
+            return result;
+        }
+
         /** Returns the minimizer of the provided vector of mmers. */
         void computeNewMinimizerOriginal(Kmer& kmer) const
         {
@@ -1264,13 +1468,12 @@ struct Kmer
             /** We compute each mmer and memorize the minimizer among them. */
 
             Type kmer_minimizer_value = kmer._minimizer.value();
-            Type val = kmer.value(0);
 
             for (int16_t idx=_nbMinimizers-1; idx>=0; idx--)
             {
 
                 /** We extract the most left mmer in the kmer. */
-                Type candidate_minim = _mmer_lut[(val & _mask).getVal()];
+                Type candidate_minim = getMmer (kmer, idx);
 				
 
                 /** We check whether this mmer is the new minimizer. */
@@ -1281,8 +1484,6 @@ struct Kmer
                     kmer._position = idx; 
                     kmer_minimizer_value = candidate_minim; 
                 }
-            
-                val >>= 2;    
             }
         }
    
@@ -18,10 +18,14 @@
 *****************************************************************************/
 
 #include <gatb/kmer/impl/PartiInfo.hpp>
+#include <gatb/tools/misc/impl/Stringify.hpp>
 #include <algorithm>
+#include <stdlib.h>
 
 // We use the required packages
 using namespace std;
+using namespace gatb::core::tools::storage::impl;
+using namespace gatb::core::tools::misc::impl;
 
 #define DEBUG(a) //printf a
 // wanted to debug separately, DEBUG has more output than debug2
@@ -294,6 +298,75 @@ void Repartitor::save (tools::storage::impl::Group& group)
     }
 }
 
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+void Repartitor::save (Group& group, size_t kmerSize)
+{
+    save (group);
+
+    /** We add what is needed for checking that the table can be used by another run. */
+    group.setProperty ("kmer_size",      Stringify::format ("%ld", kmerSize));
+    group.setProperty ("minimizer_type", _freq_order != 0 ? "1" : "0");
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+void Repartitor::save (const std::string& uri, size_t kmerSize)
+{
+    Storage* storage = StorageFactory(STORAGE_HDF5).create (uri, true, false);
+    LOCAL (storage);
+
+    save (storage->getGroup ("minimizers"), kmerSize);
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+void Repartitor::load (const std::string& uri, size_t kmerSize, size_t minimizerSize, size_t minimizerType)
+{
+    if (StorageFactory(STORAGE_HDF5).exists (uri) == false)  {  throw system::Exception ("Unable to find repartition file '%s'", uri.c_str());  }
+
+    Storage* storage = StorageFactory(STORAGE_HDF5).load (uri);
+    LOCAL (storage);
+
+    Group& group = storage->getGroup ("minimizers");
+
+    size_t fileKmerSize = atol (group.getProperty ("kmer_size").c_str());
+    if (fileKmerSize != kmerSize)
+    {
+        throw system::Exception ("Repartition file '%s' was computed for kmer size %d, not %d", uri.c_str(), fileKmerSize, kmerSize);
+    }
+
+    load (group);
+
+    if (_mm != minimizerSize)
+    {
+        throw system::Exception ("Repartition file '%s' was computed for minimizer size %d, not %d", uri.c_str(), _mm, minimizerSize);
+    }
+
+    if ((_freq_order != 0) != (minimizerType == 1))
+    {
+        throw system::Exception ("Repartition file '%s' was computed for minimizer type %d, not %d", uri.c_str(), _freq_order != 0 ? 1 : 0, minimizerType);
+    }
+}
+
 /*********************************************************************
 ** METHOD  :
 ** PURPOSE :
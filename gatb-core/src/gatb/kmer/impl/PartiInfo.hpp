@@ -25,6 +25,8 @@
 #include <gatb/kmer/impl/Model.hpp>
 #include <gatb/tools/storage/impl/Storage.hpp>
 #include <queue>
+#include <algorithm>
+#include <cmath>
 
 /********************************************************************************/
 namespace gatb      {
@@ -64,6 +66,19 @@ public:
         _kmer_per_mmer_bin[numbin]+= val *superksize;
     }
 
+    /** Record a kmer for the estimation of the number of distinct kmers of a partition : only
+     * the kmers whose hash falls in the sample are recorded, into a linear counting bitmap.
+     * \param[in] numpart : index of the partition of the kmer
+     * \param[in] hash : hash value of the kmer */
+    inline void incDistinct (int numpart, u_int64_t hash)
+    {
+        if ((hash & DISTINCT_SAMPLE_MASK) == 0)
+        {
+            u_int64_t bit = (hash >> DISTINCT_SAMPLE_BITS) & (DISTINCT_NBBITS-1);
+            _distinct_bitmap[numpart*DISTINCT_NBWORDS + (bit>>6)] |= ((u_int64_t)1 << (bit & 63));
+        }
+    }
+
     //kxmer count (regardless of x size), used for ram
     inline void incKxmer_per_minimBin(int numbin, u_int64_t val=1)
     {
@@ -95,6 +110,11 @@ public:
 
             __sync_fetch_and_add (_nb_kmers_per_parti  + np, other.getNbKmer      (np));
             __sync_fetch_and_add (_nb_kxmers_per_parti + np, other.getNbSuperKmer (np));
+
+            for (size_t w=np*DISTINCT_NBWORDS; w<(np+1)*DISTINCT_NBWORDS; w++)
+            {
+                if (other._distinct_bitmap[w])  {  __sync_fetch_and_or (_distinct_bitmap + w, other._distinct_bitmap[w]);  }
+            }
         }
 
         for (u_int64_t ii=0; ii< _num_mm_bins; ii++)
@@ -129,6 +149,24 @@ public:
         return _nb_kxmers_per_parti[numpart];
     }
 	
+    /** Get an estimation of the number of distinct kmers of a partition (linear counting on a
+     * sample of the kmers). If the bitmap is empty or saturated, we can't estimate it and we return
+     * the number of kmers.
+     * \param[in] numpart : index of the partition
+     * \return the estimated number of distinct kmers. */
+    u_int64_t getNbDistinctKmer (int numpart) const
+    {
+        u_int64_t nbZeros = 0;
+        for (size_t w=numpart*DISTINCT_NBWORDS; w<(numpart+1)*DISTINCT_NBWORDS; w++)  {  nbZeros += 64 - __builtin_popcountll (_distinct_bitmap[w]);  }
+
+        if (nbZeros == 0 || nbZeros == DISTINCT_NBBITS)  { return getNbKmer(numpart); }
+
+        double nbSampled = - (double)DISTINCT_NBBITS * log ((double)nbZeros / (double)DISTINCT_NBBITS);
+        u_int64_t result = (u_int64_t) (nbSampled * (DISTINCT_SAMPLE_MASK+1));
+
+        return std::min (std::max (result, (u_int64_t)1), getNbKmer(numpart));
+    }
+
 	inline  u_int64_t   getNbSuperKmerTotal() const
 	{
 		return _nb_superk_total;
@@ -164,6 +202,7 @@ public:
         memset (_superk_per_mmer_bin, 0, _num_mm_bins * sizeof(u_int64_t));
         memset (_kmer_per_mmer_bin,   0, _num_mm_bins * sizeof(u_int64_t));
         memset (_kxmer_per_mmer_bin,  0, _num_mm_bins * sizeof(u_int64_t));
+        memset (_distinct_bitmap,     0, _nbpart * DISTINCT_NBWORDS * sizeof(u_int64_t));
 
         for (size_t xx=0; xx<xmer; xx++)
         {
@@ -235,6 +274,7 @@ public:
         _superk_per_mmer_bin = (u_int64_t*) CALLOC (_num_mm_bins, sizeof(u_int64_t));
         _kmer_per_mmer_bin   = (u_int64_t*) CALLOC (_num_mm_bins, sizeof(u_int64_t));
         _kxmer_per_mmer_bin  = (u_int64_t*) CALLOC (_num_mm_bins, sizeof(u_int64_t));
+        _distinct_bitmap     = (u_int64_t*) CALLOC (_nbpart * DISTINCT_NBWORDS, sizeof(u_int64_t));
 
         for(size_t xx=0; xx<xmer; xx++)
         {
@@ -260,6 +300,7 @@ public:
         _superk_per_mmer_bin = (u_int64_t*) CALLOC (_num_mm_bins, sizeof(u_int64_t));
         _kmer_per_mmer_bin   = (u_int64_t*) CALLOC (_num_mm_bins, sizeof(u_int64_t));
         _kxmer_per_mmer_bin  = (u_int64_t*) CALLOC (_num_mm_bins, sizeof(u_int64_t));
+        _distinct_bitmap     = (u_int64_t*) CALLOC (_nbpart * DISTINCT_NBWORDS, sizeof(u_int64_t));
 
         for(size_t xx=0; xx<xmer; xx++)
         {
@@ -281,6 +322,7 @@ public:
         FREE (_superk_per_mmer_bin);
         FREE (_kmer_per_mmer_bin);
         FREE (_kxmer_per_mmer_bin);
+        FREE (_distinct_bitmap);
 
         for(size_t xx=0; xx<xmer; xx++)  {  for(int ii=0; ii<256; ii++)  {  FREE(_nbk_per_radix_per_part[xx][ii]);  }  }
 
@@ -298,6 +340,13 @@ private:
     u_int64_t* _kxmer_per_mmer_bin;
 
     u_int64_t* _nbk_per_radix_per_part[xmer][256];//number of kxmer per parti per rad
+
+    /** Sampling (1 kmer out of 2^DISTINCT_SAMPLE_BITS) and size of the bitmaps for estimating the distinct kmers. */
+    static const int       DISTINCT_SAMPLE_BITS = 6;
+    static const u_int64_t DISTINCT_SAMPLE_MASK = (1 << DISTINCT_SAMPLE_BITS) - 1;
+    static const u_int64_t DISTINCT_NBBITS      = 1 << 13;
+    static const u_int64_t DISTINCT_NBWORDS     = DISTINCT_NBBITS / 64;
+    u_int64_t* _distinct_bitmap;
     u_int64_t _num_mm_bins;
 
     int _nbpart;
@@ -362,6 +411,29 @@ public:
      * \param[in] group : group where the repartition table has to be saved */
     void save (tools::storage::impl::Group& group);
 
+    /** Save the repartition table into a storage object, with what is needed for checking that
+     * other runs can use it (see 'load' with an uri).
+     * \param[in] group : group where the repartition table has to be saved
+     * \param[in] kmerSize : size of the kmers for which the table was computed */
+    void save (tools::storage::impl::Group& group, size_t kmerSize);
+
+    /** Save the repartition table (and the minimizers frequencies if any) into a standalone storage,
+     * so that it can be loaded by other runs (see 'load' with an uri).
+     * \param[in] uri : uri of the storage to be created
+     * \param[in] kmerSize : size of the kmers for which the table was computed */
+    void save (const std::string& uri, size_t kmerSize);
+
+    /** Load the repartition table from a storage created by 'save' with an uri, or from the output
+     * of a counting run. An exception is thrown if the table doesn't match the given parameters.
+     * \param[in] uri : uri of the storage
+     * \param[in] kmerSize : size of the kmers to be partitioned
+     * \param[in] minimizerSize : size of the minimizers
+     * \param[in] minimizerType : type of the minimizers (0=lexicographic, 1=frequency) */
+    void load (const std::string& uri, size_t kmerSize, size_t minimizerSize, size_t minimizerType);
+
+    /** Get the number of partitions of the repartition table. */
+    size_t getNbPartitions () const { return _nbpart; }
+
     /** For debug purpose. */
     void printInfo ();
 
@@ -0,0 +1,214 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <gatb/kmer/impl/PartitionCostModel.hpp>
+#include <gatb/system/impl/System.hpp>
+#include <gatb/tools/misc/impl/Stringify.hpp>
+
+using namespace gatb::core::system;
+using namespace gatb::core::system::impl;
+using namespace gatb::core::tools::misc::impl;
+
+/** Minimal time (in ms) measured for a strategy before trusting its cost. */
+#define MIN_SIGNIFICANT_TIME  20
+
+/********************************************************************************/
+namespace gatb  {  namespace core  {   namespace kmer  {   namespace impl {
+/********************************************************************************/
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+PartitionCostModel::PartitionCostModel (bool sortAllowed, bool hashAllowed)
+    : _sortAllowed(sortAllowed), _hashAllowed(hashAllowed), _nbProbes(0), _synchro(System::thread().newSynchronizer())
+{
+    _synchro->use();
+
+    for (size_t b=0; b<NB_BUCKETS; b++)  {  for (size_t s=0; s<NB_STRATEGIES; s++)  {  _probing[b][s] = false;  }  }
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+PartitionCostModel::~PartitionCostModel ()
+{
+    _synchro->forget();
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+size_t PartitionCostModel::getBucket (u_int64_t nbKmers, u_int64_t nbDistinct)
+{
+    u_int64_t multiplicity = nbDistinct > 0 ? nbKmers / nbDistinct : 1;
+
+    size_t result = 0;
+    while (multiplicity > 1 && result < NB_BUCKETS-1)  {  multiplicity >>= 1;  result++;  }
+
+    return result;
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+double PartitionCostModel::getCost (Strategy strategy, u_int64_t nbKmers, u_int64_t nbDistinct) const
+{
+    const Stats& stats = _stats [getBucket(nbKmers,nbDistinct)][strategy];
+
+    if (stats.time < MIN_SIGNIFICANT_TIME || stats.nbKmers == 0)  { return -1; }
+
+    return 1000.0*1000.0 * (double)stats.time / (double)stats.nbKmers;
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+PartitionCostModel::Strategy PartitionCostModel::choose (u_int64_t nbKmers, u_int64_t nbDistinct, u_int64_t meanKmers)
+{
+    if (_hashAllowed==false || nbKmers==0)  { return SORT; }
+    if (_sortAllowed==false)                { return HASH; }
+
+    LocalSynchronizer ls (_synchro);
+
+    double costSort = getCost (SORT, nbKmers, nbDistinct);
+    double costHash = getCost (HASH, nbKmers, nbDistinct);
+
+    /** Both costs are known for this multiplicity : we take the cheapest strategy. */
+    if (costSort >= 0 && costHash >= 0)  {  return costHash < costSort ? HASH : SORT;  }
+
+    Strategy byDefault = nbKmers >= HASH_MIN_MULTIPLICITY*nbDistinct ? HASH : SORT;
+    Strategy other     = byDefault==HASH ? SORT : HASH;
+
+    /** We use a small partition for timing the strategy that has not been timed yet. */
+    size_t b = getBucket (nbKmers, nbDistinct);
+    if (getCost (other, nbKmers, nbDistinct) < 0  &&  _probing[b][other]==false  &&  nbKmers <= meanKmers/2)
+    {
+        _probing[b][other] = true;
+        _nbProbes ++;
+        return other;
+    }
+
+    return byDefault;
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+void PartitionCostModel::update (Strategy strategy, u_int64_t nbKmers, u_int64_t nbDistinct, u_int64_t time)
+{
+    LocalSynchronizer ls (_synchro);
+
+    size_t b = getBucket (nbKmers, nbDistinct);
+
+    _stats[b][strategy].nbPartitions ++;
+    _stats[b][strategy].nbKmers += nbKmers;
+    _stats[b][strategy].time    += time;
+
+    /** The strategy may be probed again if the partition was too small for being timed. */
+    _probing[b][strategy] = false;
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+Properties PartitionCostModel::getProperties () const
+{
+    Properties result;
+
+    Stats total[NB_STRATEGIES];
+    for (size_t b=0; b<NB_BUCKETS; b++)
+    {
+        for (size_t s=0; s<NB_STRATEGIES; s++)
+        {
+            total[s].nbPartitions += _stats[b][s].nbPartitions;
+            total[s].nbKmers      += _stats[b][s].nbKmers;
+            total[s].time         += _stats[b][s].time;
+        }
+    }
+
+    result.add (0, "count_strategy");
+    for (size_t s=0; s<NB_STRATEGIES; s++)
+    {
+        const char* name = toString ((Strategy)s);
+        result.add (1, Stringify::format ("nb_parts_%s", name), "%lld", total[s].nbPartitions);
+        result.add (1, Stringify::format ("time_%s",     name), "%lld", total[s].time);
+    }
+    result.add (1, "nb_probes", "%lld", _nbProbes);
+
+    for (size_t b=0; b<NB_BUCKETS; b++)
+    {
+        if (_stats[b][SORT].nbPartitions + _stats[b][HASH].nbPartitions == 0)  { continue; }
+
+        result.add (1, "multiplicity", "%lld", (u_int64_t)1 << b);
+        for (size_t s=0; s<NB_STRATEGIES; s++)
+        {
+            const Stats& stats = _stats[b][s];
+            const char*  name  = toString ((Strategy)s);
+
+            result.add (2, Stringify::format ("nb_parts_%s", name), "%lld", stats.nbPartitions);
+            if (stats.nbKmers > 0)
+            {
+                result.add (2, Stringify::format ("%s_ns_per_kmer", name), "%.1f",
+                    1000.0*1000.0 * (double)stats.time / (double)stats.nbKmers
+                );
+            }
+        }
+    }
+
+    return result;
+}
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
@@ -0,0 +1,137 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/** \file PartitionCostModel.hpp
+ *  \brief Choice of the counting strategy of a partition
+ */
+
+#ifndef _GATB_CORE_KMER_IMPL_PARTITION_COST_MODEL_HPP_
+#define _GATB_CORE_KMER_IMPL_PARTITION_COST_MODEL_HPP_
+
+/********************************************************************************/
+
+#include <gatb/system/api/IThread.hpp>
+#include <gatb/system/api/types.hpp>
+#include <gatb/tools/misc/impl/Property.hpp>
+#include <cstddef>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+namespace impl      {
+/********************************************************************************/
+
+/** \brief Cost model choosing between hashing and sorting for counting a partition
+ *
+ * A partition can be counted either by sorting its kmers (PartitionsByVectorCommand) or by
+ * inserting them into a hash table (PartitionsByHashCommand). Sorting has a cost linear in the
+ * number of kmers whatever their redundancy, whereas the hash table works on the distinct kmers
+ * only: hashing wins on highly redundant partitions and sorting wins on diverse ones.
+ *
+ * The partitions are classified by their multiplicity (number of kmers / number of distinct
+ * kmers, the latter being estimated during the partitioning, see PartiInfo::getNbDistinctKmer),
+ * in buckets of powers of 2. For each bucket, the model learns the cost (in ns per kmer) of each
+ * strategy from the timings of the partitions already counted; the cheapest one is chosen when
+ * both costs are known. Otherwise, the default rule is used (hashing from a multiplicity of
+ * HASH_MIN_MULTIPLICITY), except for small partitions, which are used for trying the strategy
+ * not yet timed in their bucket.
+ *
+ * The model is shared by the counting threads and kept from one pass to the next one.
+ */
+class PartitionCostModel
+{
+public:
+
+    /** Strategies for counting a partition. */
+    enum Strategy  {  SORT=0, HASH=1, NB_STRATEGIES=2  };
+
+    /** Constructor. If only one strategy is allowed, it is always chosen.
+     * \param[in] sortAllowed : false if only the hashing strategy can be used.
+     * \param[in] hashAllowed : false if only the sorting strategy can be used. */
+    PartitionCostModel (bool sortAllowed=true, bool hashAllowed=true);
+
+    /** Destructor. */
+    ~PartitionCostModel ();
+
+    /** Choose the strategy for counting a partition.
+     * \param[in] nbKmers : number of kmers of the partition
+     * \param[in] nbDistinct : estimated number of distinct kmers of the partition
+     * \param[in] meanKmers : mean number of kmers of the partitions of the pass
+     * \return the strategy */
+    Strategy choose (u_int64_t nbKmers, u_int64_t nbDistinct, u_int64_t meanKmers);
+
+    /** Learn from the counting of a partition.
+     * \param[in] strategy : strategy used for counting the partition
+     * \param[in] nbKmers : number of kmers of the partition
+     * \param[in] nbDistinct : estimated number of distinct kmers of the partition
+     * \param[in] time : time (in ms) for counting the partition */
+    void update (Strategy strategy, u_int64_t nbKmers, u_int64_t nbDistinct, u_int64_t time);
+
+    /** Get the estimated cost of a strategy for a multiplicity.
+     * \param[in] strategy : the strategy
+     * \param[in] nbKmers : number of kmers
+     * \param[in] nbDistinct : estimated number of distinct kmers
+     * \return the cost in ns per kmer, or a negative value if unknown. */
+    double getCost (Strategy strategy, u_int64_t nbKmers, u_int64_t nbDistinct) const;
+
+    /** Get the decisions and timings of the model.
+     * \return the properties. */
+    tools::misc::impl::Properties getProperties () const;
+
+    /** Partitions whose multiplicity is at least this value are hashed by default. */
+    static const u_int64_t HASH_MIN_MULTIPLICITY = 4;
+
+    /** Name of a strategy.
+     * \param[in] strategy : the strategy
+     * \return the name */
+    static const char* toString (Strategy strategy)  {  return strategy==HASH ? "hash" : "sort";  }
+
+private:
+
+    /** Number of multiplicity buckets (the last one gathering the biggest multiplicities). */
+    static const size_t NB_BUCKETS = 12;
+
+    /** Get the multiplicity bucket of a partition. */
+    static size_t getBucket (u_int64_t nbKmers, u_int64_t nbDistinct);
+
+    struct Stats
+    {
+        Stats() : nbPartitions(0), nbKmers(0), time(0) {}
+        u_int64_t nbPartitions;
+        u_int64_t nbKmers;
+        u_int64_t time;
+    };
+
+    bool _sortAllowed;
+    bool _hashAllowed;
+
+    Stats _stats   [NB_BUCKETS][NB_STRATEGIES];
+    bool  _probing [NB_BUCKETS][NB_STRATEGIES];
+
+    u_int64_t _nbProbes;
+
+    system::ISynchronizer* _synchro;
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _GATB_CORE_KMER_IMPL_PARTITION_COST_MODEL_HPP_ */
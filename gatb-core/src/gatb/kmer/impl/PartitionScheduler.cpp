@@ -0,0 +1,221 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <gatb/kmer/impl/PartitionScheduler.hpp>
+#include <gatb/system/impl/System.hpp>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using namespace gatb::core::system;
+using namespace gatb::core::system::impl;
+
+/********************************************************************************/
+namespace gatb  {  namespace core  {   namespace kmer  {   namespace impl {
+/********************************************************************************/
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+PartitionScheduler::PartitionScheduler (u_int64_t maxMemory, size_t nbWorkers, size_t nbCores)
+    : _maxMemory(maxMemory), _nbWorkers(std::max (nbWorkers, (size_t)1)), _nbCores(std::max (nbCores, (size_t)1)),
+      _first(0), _usedMemory(0), _memoryPeak(0), _nbActiveWorkers(_nbWorkers), _nbWaits(0),
+      _synchro(System::thread().newSynchronizer())
+{
+    _synchro->use();
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+PartitionScheduler::~PartitionScheduler ()
+{
+    _synchro->forget();
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+void PartitionScheduler::add (size_t partition, u_int64_t memory, bool exclusive)
+{
+    _jobs.push_back (Job (partition, memory, exclusive));
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+void PartitionScheduler::start ()
+{
+    std::sort (_jobs.begin(), _jobs.end());
+    _taken.assign (_jobs.size(), false);
+    _first = 0;
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+size_t PartitionScheduler::find (u_int64_t held)
+{
+    /** The worker is alone if the only accounted memory is its own one. */
+    bool alone = (_usedMemory == held);
+
+    for (size_t i=_first; i<_jobs.size(); i++)
+    {
+        if (_taken[i])  { continue; }
+
+        const Job& job = _jobs[i];
+
+        if (job.exclusive)
+        {
+            if (alone)  { return i; }
+            continue;
+        }
+
+        u_int64_t delta = job.memory > held ? job.memory - held : 0;
+        if (alone || _usedMemory + delta <= _maxMemory)  { return i; }
+    }
+
+    return _jobs.size();
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+bool PartitionScheduler::next (Job& job, u_int64_t& held)
+{
+    while (true)
+    {
+        {
+            LocalSynchronizer ls (_synchro);
+
+            size_t idx = find (held);
+
+            /** Nothing fits : we may find something if the worker releases its own memory. */
+            if (idx == _jobs.size() && held > 0)
+            {
+                _usedMemory -= held;
+                held = 0;
+                idx = find (held);
+            }
+
+            if (idx < _jobs.size())
+            {
+                job = _jobs[idx];
+                _taken[idx] = true;
+                while (_first < _jobs.size() && _taken[_first])  { _first++; }
+
+                if (job.exclusive)
+                {
+                    /** The partition uses its own memory, not the one of the worker. */
+                    _usedMemory -= held;
+                    held = 0;
+                    _usedMemory += job.memory;
+                }
+                else if (job.memory > held)
+                {
+                    _usedMemory += job.memory - held;
+                    held = job.memory;
+                }
+
+                _memoryPeak = std::max (_memoryPeak, _usedMemory);
+
+                return true;
+            }
+
+            /** No more partition : the worker stops and its cores may be given to the other ones. */
+            if (_first >= _jobs.size())
+            {
+                _nbActiveWorkers--;
+                return false;
+            }
+
+            /** Some partitions remain but they don't fit the memory currently used by the other workers.
+             * Note that a worker alone always gets a partition, so we can't wait forever. */
+            _nbWaits++;
+        }
+
+        std::this_thread::sleep_for (std::chrono::milliseconds (WAIT_DELAY_MS));
+    }
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+void PartitionScheduler::done (const Job& job)
+{
+    LocalSynchronizer ls (_synchro);
+
+    if (job.exclusive)  {  _usedMemory -= job.memory;  }
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+size_t PartitionScheduler::getNbCores ()
+{
+    LocalSynchronizer ls (_synchro);
+
+    size_t nbWorkers = std::max (_nbActiveWorkers, (size_t)1);
+
+    return std::max (_nbCores / nbWorkers, (size_t)1);
+}
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
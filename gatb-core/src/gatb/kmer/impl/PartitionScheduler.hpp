@@ -0,0 +1,165 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/** \file PartitionScheduler.hpp
+ *  \brief Dynamic scheduling of the partitions to be counted
+ */
+
+#ifndef _GATB_CORE_KMER_IMPL_PARTITION_SCHEDULER_HPP_
+#define _GATB_CORE_KMER_IMPL_PARTITION_SCHEDULER_HPP_
+
+/********************************************************************************/
+
+#include <gatb/system/api/IThread.hpp>
+#include <gatb/system/api/types.hpp>
+#include <vector>
+#include <cstddef>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+namespace impl      {
+/********************************************************************************/
+
+/** \brief Memory aware scheduler of the partitions to be counted
+ *
+ * Each counting thread (a worker) asks the scheduler for its next partition. The partitions are
+ * given largest first, so the big ones don't end up alone at the end of the pass.
+ *
+ * A partition is given to a worker only if its memory fits into the remaining memory, in which
+ * case the scheduler looks for the largest partition that fits. Each worker keeps the memory of
+ * its biggest partition (it is used as a pool for the next partitions), which is accounted until
+ * the worker has to wait or stops. An 'exclusive' partition (one that is counted by hashing with all the memory)
+ * can be given only to a worker alone.
+ *
+ * A worker that finds no partition fitting the memory waits for the other workers to release some
+ * memory; note that a worker alone always gets a partition, whatever its memory. When no partition
+ * remains, the worker stops and its cores are given to the partitions launched afterwards (see
+ * getNbCores), which are the smallest ones of the pass.
+ *
+ * Example:
+ * \code
+ * PartitionScheduler scheduler (maxMemory, nbWorkers, nbCores);
+ * for (size_t p=0; p<nbPartitions; p++)  { scheduler.add (p, memory[p]); }
+ * scheduler.start ();
+ *
+ * // in each worker thread
+ * u_int64_t held = 0;
+ * PartitionScheduler::Job job;
+ * while (scheduler.next (job, held))
+ * {
+ *     // count partition 'job.partition' with 'scheduler.getNbCores()' cores
+ *     scheduler.done (job);
+ * }
+ * \endcode
+ */
+class PartitionScheduler
+{
+public:
+
+    /** A partition to be counted. */
+    struct Job
+    {
+        Job (size_t partition=0, u_int64_t memory=0, bool exclusive=false)
+            : partition(partition), memory(memory), exclusive(exclusive) {}
+
+        size_t    partition;
+        u_int64_t memory;
+        bool      exclusive;
+
+        /** Largest first. */
+        bool operator< (const Job& other) const
+        {
+            if (memory != other.memory)  {  return memory > other.memory;  }
+            return partition < other.partition;
+        }
+    };
+
+    /** Constructor.
+     * \param[in] maxMemory : memory (in bytes) to be shared by the workers
+     * \param[in] nbWorkers : number of workers
+     * \param[in] nbCores : total number of cores */
+    PartitionScheduler (u_int64_t maxMemory, size_t nbWorkers, size_t nbCores);
+
+    /** Destructor. */
+    ~PartitionScheduler ();
+
+    /** Add a partition to be counted (must be called before 'start').
+     * \param[in] partition : index of the partition
+     * \param[in] memory : memory (in bytes) needed for counting the partition
+     * \param[in] exclusive : true if the partition must be counted with no other partition. */
+    void add (size_t partition, u_int64_t memory, bool exclusive=false);
+
+    /** Sort the partitions; must be called before the workers are launched. */
+    void start ();
+
+    /** Get the next partition for a worker.
+     * \param[out] job : the partition to be counted
+     * \param[in,out] held : memory held by the worker; it is updated if the worker has to grow or release its memory.
+     * \return false if the worker must stop (ie. no partition remains). */
+    bool next (Job& job, u_int64_t& held);
+
+    /** Tell that a partition has been counted.
+     * \param[in] job : the counted partition */
+    void done (const Job& job);
+
+    /** Get the number of cores for a partition that is going to be launched, according to the
+     * number of workers still running.
+     * \return the number of cores. */
+    size_t getNbCores ();
+
+    /** Get the max memory used at a same time (in bytes).
+     * \return the memory peak. */
+    u_int64_t getMemoryPeak () const  { return _memoryPeak; }
+
+    /** Get the number of times a worker had to wait for memory.
+     * \return the number of waits. */
+    size_t getNbWaits () const  { return _nbWaits; }
+
+private:
+
+    /** Delay (in ms) before a waiting worker looks again for a partition. */
+    static const int WAIT_DELAY_MS = 5;
+
+    /** Look for the largest partition that can be counted by a worker (must be called with the lock).
+     * \return the index of the job in the list, or the list size if none. */
+    size_t find (u_int64_t held);
+
+    u_int64_t _maxMemory;
+    size_t    _nbWorkers;
+    size_t    _nbCores;
+
+    std::vector<Job> _jobs;
+    std::vector<bool> _taken;
+    size_t _first;
+
+    u_int64_t _usedMemory;
+    u_int64_t _memoryPeak;
+    size_t    _nbActiveWorkers;
+    size_t    _nbWaits;
+
+    system::ISynchronizer* _synchro;
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _GATB_CORE_KMER_IMPL_PARTITION_SCHEDULER_HPP_ */
@@ -21,6 +21,9 @@
 #include <gatb/tools/collections/impl/OAHash.hpp>
 #include <gatb/tools/collections/impl/Hash16.hpp>
 #include <gatb/tools/misc/impl/Stringify.hpp>
+#include <gatb/tools/math/RadixSort.hpp>
+#include <gatb/kmer/impl/SuperKmerDecoder.hpp>
+#include <gatb/kmer/impl/KmerSizeDispatch.hpp>
 
 
 using namespace std;
@@ -68,8 +71,8 @@ PartitionsCommand<span>:: PartitionsCommand (
     size_t              nbCores,
     size_t              kmerSize,
     MemAllocator&       pool,
-	tools::storage::impl::SuperKmerBinFiles* 		superKstorage
-
+	tools::storage::impl::SuperKmerBinFiles* 		superKstorage,
+    bool                canonical
 )
     :
      // _partition(partition),
@@ -83,7 +86,8 @@ PartitionsCommand<span>:: PartitionsCommand (
       _pool(pool),
       _globalTimeInfo(timeInfo),
       _processor(0),
-	  _superKstorage(superKstorage)
+	  _superKstorage(superKstorage),
+      _canonical(canonical)
 {
     setProcessor      (processor);
 }
@@ -134,7 +138,8 @@ PartitionsCommand_multibank<span>:: PartitionsCommand_multibank (
 											 int                 parti,
 											 size_t              nbCores,
 											 size_t              kmerSize,
-											 MemAllocator&       pool
+											 MemAllocator&       pool,
+											 bool                canonical
 											 )
 :
 _partition(partition),
@@ -147,7 +152,8 @@ _kmerSize(kmerSize),
 _cacheSize(cacheSize),
 _pool(pool),
 _globalTimeInfo(timeInfo),
-_processor(0)
+_processor(0),
+_canonical(canonical)
 {
 	setProcessor      (processor);
 }
@@ -203,10 +209,10 @@ PartitionsByHashCommand<span>:: PartitionsByHashCommand (
     size_t                  kmerSize,
     MemAllocator&           pool,
     u_int64_t               hashMemory,
-	tools::storage::impl::SuperKmerBinFiles* 		superKstorage
-
+	tools::storage::impl::SuperKmerBinFiles* 		superKstorage,
+    bool                    canonical
 )
-    : PartitionsCommand<span> (/*partition,*/ processor, cacheSize, progress, timeInfo, pInfo, passi, parti,nbCores,kmerSize,pool,superKstorage),
+    : PartitionsCommand<span> (/*partition,*/ processor, cacheSize, progress, timeInfo, pInfo, passi, parti,nbCores,kmerSize,pool,superKstorage,canonical),
      _hashMemory(hashMemory)
 {
 }
@@ -412,6 +418,10 @@ void PartitionsByHashCommand<span>:: execute ()
 		int _fileId = this->_parti_num;
 		unsigned char * _buffer = 0 ;
 		unsigned int _buffer_size = 0;
+
+		/** Unpacked nucleotides of the current superkmer (and their complement). */
+		std::vector<u_int8_t> forward    (ks + 256);
+		std::vector<u_int8_t> complement (ks + 256);
 		
 		
 
@@ -427,32 +437,24 @@ void PartitionsByHashCommand<span>:: execute ()
 			{
 				//decode a superkmer
 				nbK = *ptr; ptr++;
-				//int nb_bytes_superk = (this->_kmerSize + nbK -1 +3) /4  ;
-				
+
+				/** We unpack all the nucleotides of the superkmer at once. */
+				size_t nbNt = ks + nbK - 1;
+				unsigned char* next_superk = ptr + (nbNt+3)/4;
+				SuperKmerDecoder::unpack (ptr, nbNt, &forward[0], &complement[0]);
+
 				int rem_size = this->_kmerSize;
 				
 				Type Tnewbyte;
 				int nbr=0;
 				_seedk.setVal(0);
-				while(rem_size>=4)
+				while(rem_size>0)
 				{
 					newbyte = *ptr ; ptr++;
 					Tnewbyte.setVal(newbyte);
 					_seedk =  _seedk  |  (Tnewbyte  << (8*nbr)) ;
 					rem_size -= 4; nbr++;
 				}
-				
-				int uid = 4; //uid = nb nt used in current newbyte
-				
-				//reste du seed kmer
-				if(rem_size>0)
-				{
-					newbyte = *ptr ; ptr++;
-					Tnewbyte.setVal(newbyte);
-					
-					_seedk = ( _seedk  |  (Tnewbyte  << (8*nbr)) ) ;
-					uid = rem_size;
-				}
 				_seedk = _seedk & kmerMask;
 				
 				
@@ -468,11 +470,7 @@ void PartitionsByHashCommand<span>:: execute ()
 				for (int ii=0; ii< nbK; ii++,rem--)
 				{
 					
-#ifdef NONCANONICAL
-					mink = temp;
-#else
-					mink = std::min (rev_temp, temp);
-#endif
+					mink = this->_canonical ? std::min (rev_temp, temp) : temp;
 					
 					
 					/** We insert the kmer into the hash. */
@@ -483,21 +481,15 @@ void PartitionsByHashCommand<span>:: execute ()
 					
 					////////now decode next kmer of this superkmer ///////
 					
-					if(uid>=4) //read next byte
-					{
-						newbyte = *ptr ; ptr++;
-						Tnewbyte.setVal(newbyte);
-						uid =0;
-					}
-					
-					newnt = (Tnewbyte >> (2*uid))& 3; uid++;
+					newnt.setVal (forward[ks+ii]);
 					temp = ((temp << 2 ) |  newnt   ) & kmerMask;
 					
-					newnt.setVal(comp_NT[newnt.getVal()]) ;
+					newnt.setVal (complement[ks+ii]);
 					rev_temp = ((rev_temp >> 2 ) |  (newnt << shift) ) & kmerMask;
 				}
 				
-				//now go to next superk of this block, ptr should point to beginning of next superk
+				//now go to next superk of this block
+				ptr = next_superk;
 			}
 			
 			//check if hashtable is getting too big : in that case dump it disk and resume with the emptied hashtable
@@ -765,108 +757,137 @@ public:
 		else
 		{
 			_seedk = elem;
-			
-			Type compactedK;
-			
-			compactedK =  _superk;
-			u_int8_t nbK = (compactedK >> _shift_val).getVal()  & 255; // 8 bits poids fort = cpt
-			u_int8_t rem = nbK;
-			
-			Type temp = _seedk;
-			Type rev_temp = revcomp(temp,_kmerSize);
-			Type newnt ;
-			Type mink, prev_mink; prev_mink.setVal(0);
-			uint64_t idx;
-			
-#ifdef NONCANONICAL
-            bool prev_which = true;
-#else
-			bool prev_which =  (temp < rev_temp );
-#endif
+
+			/** We process the superkmer with a kernel compiled for the kmer size, if any (see KmerSizeDispatch). */
+			if (_isSpecialized)  {  KmerSizeDispatch<span>::execute (_kmerSize, *this);  }
+			else                 {  readSuperKmer<0> ();  }
+
+			_first = true;
+		}
+	}
+
+	/** Adaptor for KmerSizeDispatch. */
+	typedef void Result;
+	template<int K>  void operator() ()  {  readSuperKmer<K> ();  }
+
+	/** Splits the current superkmer into kxmers and inserts them into the radix arrays.
+	 * K is the kmer size if known at compile time, 0 otherwise. */
+	template<int K>
+	void readSuperKmer ()
+	{
+		/** The kmer size and what depends on it are either constants (K>0) or the attributes (K=0). */
+		const size_t kmerSize    = K>0 ? K : _kmerSize;
+		const size_t shift       = K>0 ? 2*(kmerSize-1)   : _shift;
+		const size_t shift_radix = K>0 ? (kmerSize - 4)*2 : _shift_radix;
+		Type kmerMask   = _kmerMask;
+		Type mask_radix = _mask_radix;
+		if (K>0)
+		{
+			Type un;  un.setVal(1);
+			kmerMask = (un << (kmerSize*2)) - 1;
+			mask_radix.setVal((int64_t) 255);
+			mask_radix = mask_radix << shift_radix;
+		}
+
+		
+		Type compactedK;
+		
+		compactedK =  _superk;
+		u_int8_t nbK = (compactedK >> _shift_val).getVal()  & 255; // 8 bits poids fort = cpt
+		u_int8_t rem = nbK;
+
+		/** We unpack the nucleotides of the superkmer at once: the nucleotide for 'rem' is at index rem-2. */
+		u_int8_t packed[sizeof(Type)];
+		size_t   nbNt = nbK>0 ? nbK-1 : 0;
+		for (size_t b=0; b<(nbNt+3)/4; b++)  {  packed[b] = tools::math::radixByte (_superk, b);  }
+		SuperKmerDecoder::unpack (packed, nbNt, _forward, _complement);
+		
+		Type temp = _seedk;
+		Type rev_temp = revcomp(temp,kmerSize);
+		Type newnt ;
+		Type mink, prev_mink; prev_mink.setVal(0);
+		uint64_t idx;
+		
+		bool prev_which =  !_canonical || (temp < rev_temp );
             
-			int kx_size = -1; //next loop start at ii=0, first kmer will put it at 0
-			Type radix_kxmer_forward =  (temp & _mask_radix) >> ((_kmerSize - 4)*2);
-			Type  first_revk, kinsert,radix_kxmer;
+		int kx_size = -1; //next loop start at ii=0, first kmer will put it at 0
+		Type radix_kxmer_forward =  (temp & mask_radix) >> shift_radix;
+		Type  first_revk, kinsert,radix_kxmer;
             first_revk.setVal(0);
-			
-			if(!prev_which) first_revk = rev_temp;
-			
-			u_int8_t rid;
+		
+		if(!prev_which) first_revk = rev_temp;
+		
+		u_int8_t rid;
 
-			for (int ii=0; ii< nbK; ii++,rem--)
+		for (int ii=0; ii< nbK; ii++,rem--)
+		{
+			bool which =  !_canonical || (temp < rev_temp );
+			mink = which ? temp : rev_temp;
+
+			if (which != prev_which || kx_size >= _kx) // kxmer_size = 1
 			{
-#ifdef NONCANONICAL
-                bool which = true;
-                mink = temp;
-#else
-				bool which =  (temp < rev_temp );
-				mink = which ? temp : rev_temp;
-#endif
-
-				if (which != prev_which || kx_size >= _kx) // kxmer_size = 1
+				//output kxmer size kx_size,radix_kxmer
+				//kx mer is composed of superKp[ii-1] superKp[ii-2] .. superKp[ii-n] with nb elems  n  == kxmer_size +1  (un seul kmer ==k+0)
+				
+				if(prev_which)
 				{
-					//output kxmer size kx_size,radix_kxmer
-					//kx mer is composed of superKp[ii-1] superKp[ii-2] .. superKp[ii-n] with nb elems  n  == kxmer_size +1  (un seul kmer ==k+0)
-					
-					if(prev_which)
-					{
-						radix_kxmer = radix_kxmer_forward;
-						kinsert = prev_mink;
-					}
-					else // si revcomp, le radix du kxmer est le debut du dernier kmer
-					{
-						//previous mink
-						radix_kxmer =  (prev_mink & _mask_radix) >> _shift_radix;
-						kinsert = first_revk;
-					}
-					
-					//record kxmer
-					rid = radix_kxmer.getVal();
-					//idx = _r_idx[IX(kx_size,rid)]++;
-					idx = __sync_fetch_and_add( _r_idx +  IX(kx_size,rid) ,1); // si le sync fetch est couteux, faire un mini buffer par thread
-					
-					_radix_kmers [IX(kx_size,rid)][ idx] = kinsert << ((4-kx_size)*2);  //[kx_size][rid]
-					if (_bankIdMatrix)  { _bankIdMatrix[IX(kx_size,rid)][ idx] = _bankId; }
-					
-					radix_kxmer_forward =  (mink & _mask_radix) >> _shift_radix;
-					kx_size =0;
-					
-					if(!which) first_revk = rev_temp;
+					radix_kxmer = radix_kxmer_forward;
+					kinsert = prev_mink;
 				}
-				else
+				else // si revcomp, le radix du kxmer est le debut du dernier kmer
 				{
-					kx_size++;
+					//previous mink
+					radix_kxmer =  (prev_mink & mask_radix) >> shift_radix;
+					kinsert = first_revk;
 				}
-			
-				prev_which = which ;
-				prev_mink = mink;
 				
-				if(rem < 2) break; //no more kmers in this superkmer, the last one has just been eaten
-				newnt =  ( _superk >> ( 2*(rem-2)) ) & 3 ;
+				//record kxmer
+				rid = radix_kxmer.getVal();
+				//idx = _r_idx[IX(kx_size,rid)]++;
+				idx = __sync_fetch_and_add( _r_idx +  IX(kx_size,rid) ,1); // si le sync fetch est couteux, faire un mini buffer par thread
+				
+				_radix_kmers [IX(kx_size,rid)][ idx] = kinsert << ((4-kx_size)*2);  //[kx_size][rid]
+				if (_bankIdMatrix)  { _bankIdMatrix[IX(kx_size,rid)][ idx] = _bankId; }
 				
-				temp = ((temp << 2 ) |  newnt   ) & _kmerMask;
-				newnt.setVal(comp_NT[newnt.getVal()]) ;
-				rev_temp = ((rev_temp >> 2 ) |  (newnt << _shift) ) & _kmerMask;
-			}
-			
-			//record last kxmer prev_mink et monk ?
-			if(prev_which)
-			{
-				radix_kxmer = radix_kxmer_forward;
-				kinsert = prev_mink;
+				radix_kxmer_forward =  (mink & mask_radix) >> shift_radix;
+				kx_size =0;
+				
+				if(!which) first_revk = rev_temp;
 			}
-			else // si revcomp, le radix du kxmer est le debut du dernier kmer
+			else
 			{
-				//previous mink
-				radix_kxmer =  (prev_mink & _mask_radix) >> _shift_radix;
-				kinsert = first_revk;
+				kx_size++;
 			}
+		
+			prev_which = which ;
+			prev_mink = mink;
 			
-			//record kxmer
-			rid = radix_kxmer.getVal();
-			//idx = _r_idx[IX(kx_size,rid)]++;
-			idx = __sync_fetch_and_add( _r_idx +  IX(kx_size,rid) ,1); // si le sync fetch est couteux, faire un mini buffer par thread
-					
+			if(rem < 2) break; //no more kmers in this superkmer, the last one has just been eaten
+			newnt.setVal (_forward[rem-2]);
+			
+			temp = ((temp << 2 ) |  newnt   ) & kmerMask;
+			newnt.setVal (_complement[rem-2]);
+			rev_temp = ((rev_temp >> 2 ) |  (newnt << shift) ) & kmerMask;
+		}
+		
+		//record last kxmer prev_mink et monk ?
+		if(prev_which)
+		{
+			radix_kxmer = radix_kxmer_forward;
+			kinsert = prev_mink;
+		}
+		else // si revcomp, le radix du kxmer est le debut du dernier kmer
+		{
+			//previous mink
+			radix_kxmer =  (prev_mink & mask_radix) >> shift_radix;
+			kinsert = first_revk;
+		}
+		
+		//record kxmer
+		rid = radix_kxmer.getVal();
+		//idx = _r_idx[IX(kx_size,rid)]++;
+		idx = __sync_fetch_and_add( _r_idx +  IX(kx_size,rid) ,1); // si le sync fetch est couteux, faire un mini buffer par thread
+				
 
             
 //                        if (idx >= _radix_sizes[IX(kx_size,rid)] ||  _radix_sizes[IX(kx_size,rid)]  == 0)
@@ -876,14 +897,11 @@ public:
                         _radix_kmers [IX(kx_size,rid)][ idx] = kinsert << ((4-kx_size)*2);   // [kx_size][rid]
                     //cout << "went okay " << idx << endl;
 
-			if (_bankIdMatrix)  { _bankIdMatrix[IX(kx_size,rid)][ idx] = _bankId; }
-
-			_first = true;
-		}
+		if (_bankIdMatrix)  { _bankIdMatrix[IX(kx_size,rid)][ idx] = _bankId; }
 	}
 	
-	SuperKReader (size_t kmerSize,  uint64_t * r_idx, Type** radix_kmers, uint64_t* radix_sizes, bank::BankIdType** bankIdMatrix, size_t bankId=0)
-	: _kmerSize (kmerSize), _kx(4), _radix_kmers(radix_kmers), _radix_sizes(radix_sizes), _bankIdMatrix(bankIdMatrix), _r_idx (r_idx), _first(true), _bankId(bankId)
+	SuperKReader (size_t kmerSize,  uint64_t * r_idx, Type** radix_kmers, uint64_t* radix_sizes, bank::BankIdType** bankIdMatrix, size_t bankId=0, bool canonical=true)
+	: _kmerSize (kmerSize), _kx(4), _radix_kmers(radix_kmers), _radix_sizes(radix_sizes), _bankIdMatrix(bankIdMatrix), _r_idx (r_idx), _first(true), _bankId(bankId), _canonical(canonical)
 	 {
 		 Type un;
          un.setVal(1);
@@ -893,6 +911,7 @@ public:
 		 _shift       = 2*(kmerSize-1);
 		 _shift_val   = un.getSize() -8;
 		 _shift_radix = ((kmerSize - 4)*2); // radix is 4 nt long
+		 _isSpecialized = KmerSizeDispatch<span>::isSpecialized (kmerSize);
 	}
 	
 private :
@@ -912,6 +931,12 @@ private :
 	Type _radix, _mask_radix ;
 	Type _kmerMask;
 	size_t _bankId;
+	bool   _canonical;
+	bool   _isSpecialized;
+
+	/** Unpacked nucleotides of the current superkmer (and their complement). */
+	u_int8_t _forward   [4*sizeof(Type)];
+	u_int8_t _complement[4*sizeof(Type)];
 };
 
 	
@@ -927,8 +952,9 @@ class ReadSuperKCommand : public gatb::core::tools::dp::ICommand, public system:
 	
 public:
 	ReadSuperKCommand(tools::storage::impl::SuperKmerBinFiles* superKstorage, int fileId, int kmerSize,
-					  uint64_t * r_idx, Type** radix_kmers, uint64_t* radix_sizes, bank::BankIdType** bankIdMatrix)
-	: _superKstorage(superKstorage), _fileId(fileId),_buffer(0),_buffer_size(0), _kmerSize(kmerSize),_radix_kmers(radix_kmers), _radix_sizes(radix_sizes), _bankIdMatrix(bankIdMatrix), _r_idx (r_idx)
+					  uint64_t * r_idx, Type** radix_kmers, uint64_t* radix_sizes, bank::BankIdType** bankIdMatrix, bool canonical=true)
+	: _superKstorage(superKstorage), _fileId(fileId),_buffer(0),_buffer_size(0), _kmerSize(kmerSize),_radix_kmers(radix_kmers), _radix_sizes(radix_sizes), _bankIdMatrix(bankIdMatrix), _r_idx (r_idx),
+	  _canonical(canonical), _forward(kmerSize+256), _complement(kmerSize+256)
 	{
 		_kx=4;
 		Type un;
@@ -956,34 +982,24 @@ public:
 			{
 				//decode a superkmer
 				nbK = *ptr; ptr++;
-				//int nb_bytes_superk = (_kmerSize + nbK -1 +3) /4  ;
-				
+
+				/** We unpack all the nucleotides of the superkmer at once. */
+				size_t nbNt = _kmerSize + nbK - 1;
+				unsigned char* next_superk = ptr + (nbNt+3)/4;
+				SuperKmerDecoder::unpack (ptr, nbNt, &_forward[0], &_complement[0]);
+
 				int rem_size = _kmerSize;
 				
 				Type Tnewbyte;
 				int nbr=0;
 				_seedk.setVal(0);
-				while(rem_size>=4)
+				while(rem_size>0)
 				{
 					newbyte = *ptr ; ptr++;
 					Tnewbyte.setVal(newbyte);
-					
-					
 					_seedk =  _seedk  |  (Tnewbyte  << (8*nbr)) ;
 					rem_size -= 4; nbr++;
 				}
-				
-				int uid = 4; //uid = nb nt used in current newbyte
-				
-				//reste du seed kmer
-				if(rem_size>0)
-				{
-					newbyte = *ptr ; ptr++;
-					Tnewbyte.setVal(newbyte);
-					
-					_seedk = ( _seedk  |  (Tnewbyte  << (8*nbr)) ) ;
-					uid = rem_size;
-				}
 				_seedk = _seedk & _kmerMask;
 				
 				
@@ -999,11 +1015,7 @@ public:
 				Type mink, prev_mink; prev_mink.setVal(0);
 				uint64_t idx;
 				
-#ifdef NONCANONICAL
-				bool prev_which = true;
-#else
-				bool prev_which =  (temp < rev_temp );
-#endif
+				bool prev_which =  !_canonical || (temp < rev_temp );
 				
 				int kx_size = -1; //next loop start at ii=0, first kmer will put it at 0
 				Type radix_kxmer_forward =  (temp & _mask_radix) >> ((_kmerSize - 4)*2);
@@ -1016,13 +1028,8 @@ public:
 				
 				for (int ii=0; ii< nbK; ii++,rem--)
 				{
-#ifdef NONCANONICAL
-					bool which = true;
-					mink = temp;
-#else
-					bool which =  (temp < rev_temp );
+					bool which =  !_canonical || (temp < rev_temp );
 					mink = which ? temp : rev_temp;
-#endif
 					
 					if (which != prev_which || kx_size >= _kx) // kxmer_size = 1
 					{
@@ -1066,18 +1073,10 @@ public:
 					
 					//////////////////////////////now decode next kmer of this superkmer //////////////////////////////////////////////
 					
-					if(uid>=4) //read next byte
-					{
-						newbyte = *ptr ; ptr++;
-						Tnewbyte.setVal(newbyte);
-						uid =0;
-					}
-					
-					newnt = (Tnewbyte >> (2*uid))& 3; uid++;
-					
+					newnt.setVal (_forward[_kmerSize+ii]);
 					temp = ((temp << 2 ) |  newnt   ) & _kmerMask;
 					
-					newnt.setVal(comp_NT[newnt.getVal()]) ;
+					newnt.setVal (_complement[_kmerSize+ii]);
 					rev_temp = ((rev_temp >> 2 ) |  (newnt << _shift) ) & _kmerMask;
 					
 					///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1111,9 +1110,9 @@ public:
 				
 				
 				//////////////////////////////////////////////////////////
-				//ptr+=nb_bytes_superk;
 				
-				//now go to next superk of this block, ptr should point to beginning of next superk
+				//now go to next superk of this block
+				ptr = next_superk;
 				nbsuperkmer_read++;
 				/////////
 			}
@@ -1146,7 +1145,12 @@ private:
 	size_t _shift_val ;
 	size_t _shift_radix ;
 	size_t _bankId;
-	
+	bool   _canonical;
+	bool   _isSpecialized;
+
+	/** Unpacked nucleotides of the current superkmer (and their complement). */
+	std::vector<u_int8_t> _forward;
+	std::vector<u_int8_t> _complement;
 };
 	
 /*********************************************************************
@@ -1172,9 +1176,10 @@ PartitionsByVectorCommand<span>:: PartitionsByVectorCommand (
     size_t              kmerSize,
     MemAllocator&       pool,
     vector<size_t>&     offsets,
-	tools::storage::impl::SuperKmerBinFiles* 		superKstorage
+	tools::storage::impl::SuperKmerBinFiles* 		superKstorage,
+    bool                canonical
 )
-    : PartitionsCommand<span> (/*partition,*/ processor, cacheSize,  progress, timeInfo, pInfo, passi, parti,nbCores,kmerSize,pool,superKstorage),
+    : PartitionsCommand<span> (/*partition,*/ processor, cacheSize,  progress, timeInfo, pInfo, passi, parti,nbCores,kmerSize,pool,superKstorage,canonical),
         _radix_kmers (0), _bankIdMatrix(0), _radix_sizes(0), _r_idx(0), _nbItemsPerBankPerPart(offsets)
 {
     _dispatcher = new Dispatcher (this->_nbCores);
@@ -1359,7 +1364,8 @@ void PartitionsByVectorCommand<span>::executeRead ()
 															this->_superKstorage,
 															this->_parti_num,
 															this->_kmerSize,
-															_r_idx, _radix_kmers, _radix_sizes, 0
+															_r_idx, _radix_kmers, _radix_sizes, 0,
+															this->_canonical
 															)
 							   );
 			}
@@ -1392,9 +1398,15 @@ class SortCommand : public gatb::core::tools::dp::ICommand, public system::Smart
 public:
     typedef typename Kmer<span>::Type  Type;
 
-    /** Constructor. */
-    SortCommand (Type** kmervec, bank::BankIdType** bankIdMatrix, int begin, int end, uint64_t* radix_sizes)
-        : _deb(begin), _fin(end), _radix_kmers(kmervec), _bankIdMatrix(bankIdMatrix), _radix_sizes(radix_sizes) {}
+    /** Constructor.
+     * \param[in] buckets : indexes of the radix buckets to be sorted, shared by all the SortCommand instances
+     * \param[in] next : index of the next bucket to be sorted in 'buckets', shared by all the SortCommand instances
+     * \param[in] nbBytes : number of significant bytes of the kmers (for the radix sort) */
+    SortCommand (Type** kmervec, bank::BankIdType** bankIdMatrix, uint64_t* radix_sizes,
+        const vector<size_t>& buckets, size_t* next, size_t nbBytes
+    )
+        : _radix_kmers(kmervec), _bankIdMatrix(bankIdMatrix), _radix_sizes(radix_sizes),
+          _buckets(buckets), _next(next), _nbBytes(nbBytes) {}
 
     /** */
     void execute ()
@@ -1402,45 +1414,46 @@ public:
         vector<size_t> idx;
         vector<Tmp>    tmp;
 
-        for (int ii=_deb; ii <=_fin; ii++)
+        /** Each thread takes the next bucket to be sorted until there is no more bucket, so a thread
+         * that finishes early gets more work instead of waiting for the others. */
+        for (size_t n = __sync_fetch_and_add (_next, 1);  n < _buckets.size();  n = __sync_fetch_and_add (_next, 1))
         {
-            if (_radix_sizes[ii] > 0)
+            size_t ii = _buckets[n];
+
+            /** Shortcuts. */
+            Type* kmers = _radix_kmers  [ii];
+
+            if (_bankIdMatrix)
             {
-                /** Shortcuts. */
-                Type* kmers = _radix_kmers  [ii];
+                /** NOT OPTIMAL AT ALL... in particular we have to use 'idx' and 'tmp' vectors
+                 * which may use (a lot of ?) memory. */
 
-                if (_bankIdMatrix)
+                /** Shortcut. */
+                bank::BankIdType* banksId = _bankIdMatrix [ii];
+
+                /** NOTE: we sort the indexes, not the items. */
+                idx.resize (_radix_sizes[ii]);
+                for (size_t i=0; i<idx.size(); i++)  { idx[i]=i; }
+
+                std::sort (idx.begin(), idx.end(), Cmp(kmers));
+
+                /** Now, we have to reorder the two provided vectors with the same order. */
+                tmp.resize (idx.size());
+                for (size_t i=0; i<idx.size(); i++)
                 {
-                    /** NOT OPTIMAL AT ALL... in particular we have to use 'idx' and 'tmp' vectors
-                     * which may use (a lot of ?) memory. */
-
-                    /** Shortcut. */
-                    bank::BankIdType* banksId = _bankIdMatrix [ii];
-
-                    /** NOTE: we sort the indexes, not the items. */
-                    idx.resize (_radix_sizes[ii]);
-                    for (size_t i=0; i<idx.size(); i++)  { idx[i]=i; }
-
-                    std::sort (idx.begin(), idx.end(), Cmp(kmers));
-
-                    /** Now, we have to reorder the two provided vectors with the same order. */
-                    tmp.resize (idx.size());
-                    for (size_t i=0; i<idx.size(); i++)
-                    {
-                        tmp[i].kmer = kmers  [idx[i]];
-                        tmp[i].id   = banksId[idx[i]];
-                    }
-                    for (size_t i=0; i<idx.size(); i++)
-                    {
-                        kmers  [i] = tmp[i].kmer;
-                        banksId[i] = tmp[i].id;
-                    }
+                    tmp[i].kmer = kmers  [idx[i]];
+                    tmp[i].id   = banksId[idx[i]];
                 }
-                else
+                for (size_t i=0; i<idx.size(); i++)
                 {
-                    std::sort (&kmers[0] , &kmers[ _radix_sizes[ii]]);
+                    kmers  [i] = tmp[i].kmer;
+                    banksId[i] = tmp[i].id;
                 }
             }
+            else
+            {
+                tools::math::RadixSort<Type>::sort (&kmers[0] , &kmers[ _radix_sizes[ii]], _nbBytes);
+            }
         }
     }
 
@@ -1455,52 +1468,76 @@ private :
         bool operator() (size_t a, size_t b)  { return _kmers[a] < _kmers[b]; }
     };
 
-    int        _deb;
-    int        _fin;
     Type**     _radix_kmers;
     bank::BankIdType** _bankIdMatrix;
     uint64_t*  _radix_sizes;
+    const vector<size_t>& _buckets;
+    size_t*    _next;
+    size_t     _nbBytes;
 };
 
 /*********************************************************************
 ** METHOD  :
-** PURPOSE :
+** PURPOSE : sort the radix buckets of a partition with several threads
 ** INPUT   :
 ** OUTPUT  :
 ** RETURN  :
-** REMARKS :
+** REMARKS : the buckets are given to the threads from the biggest to the smallest one
 *********************************************************************/
+struct CmpBucketSize
+{
+    uint64_t* _sizes;
+    CmpBucketSize (uint64_t* sizes) : _sizes(sizes) {}
+    bool operator() (size_t a, size_t b)  { return _sizes[a] > _sizes[b]; }
+};
+
 template<size_t span>
-void PartitionsByVectorCommand<span>::executeSort ()
+static void sortRadixBuckets (
+    IDispatcher*                  dispatcher,
+    size_t                        nbCores,
+    typename Kmer<span>::Type**   radix_kmers,
+    bank::BankIdType**            bankIdMatrix,
+    uint64_t*                     radix_sizes,
+    size_t                        nbBuckets,
+    size_t                        kmerSize,
+    size_t                        kx
+)
 {
-    TIME_INFO (this->_timeInfo, "2.sort");
+    typedef typename Kmer<span>::Type  Type;
 
-    vector<ICommand*> cmds;
+    vector<size_t> buckets;
+    for (size_t i=0; i<nbBuckets; i++)  {  if (radix_sizes[i] > 1)  { buckets.push_back(i); }  }
 
-    int nwork = 256 / this->_nbCores;
+    std::sort (buckets.begin(), buckets.end(), CmpBucketSize(radix_sizes));
 
-    for (size_t xx=0; xx < (KX+1); xx++)
-    {
-        cmds.clear();
+    /** The items of the buckets are kxmers of at most kmerSize+kx nucleotides. */
+    size_t nbBytes = std::min ((2*(kmerSize+kx)+7)/8, Type::getSize()/8);
 
-        //fill cmd work vector
-        for (size_t tid=0; tid < this->_nbCores; tid++)
-        {
-            int deb = 0 + tid * nwork;
-            int fin = (tid+1) * nwork -1; // thread will do inclusive range [begin -- end ]
-            if(tid == this->_nbCores-1)  { fin = 255; }
-
-            // mettre dans le  SortCommand le master radix_kmers et range a traiter
-            cmds.push_back (new SortCommand<span> (
-                _radix_kmers+ IX(xx,0),
-                (_bankIdMatrix ? _bankIdMatrix+ IX(xx,0) : 0),
-                deb, fin,
-                _radix_sizes + IX(xx,0)
-            ));
-        }
+    size_t next = 0;
 
-        _dispatcher->dispatchCommands (cmds, 0);
+    vector<ICommand*> cmds;
+    for (size_t tid=0; tid < nbCores; tid++)
+    {
+        cmds.push_back (new SortCommand<span> (radix_kmers, bankIdMatrix, radix_sizes, buckets, &next, nbBytes));
     }
+
+    dispatcher->dispatchCommands (cmds, 0);
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+template<size_t span>
+void PartitionsByVectorCommand<span>::executeSort ()
+{
+    TIME_INFO (this->_timeInfo, "2.sort");
+
+    sortRadixBuckets<span> (_dispatcher, this->_nbCores, _radix_kmers, _bankIdMatrix, _radix_sizes, 256*(KX+1), this->_kmerSize, KX);
 }
 
 /*********************************************************************
@@ -1821,9 +1858,10 @@ PartitionsByVectorCommand_multibank<span>:: PartitionsByVectorCommand_multibank
 																				 size_t              nbCores,
 																				 size_t              kmerSize,
 																				 MemAllocator&       pool,
-																				 vector<size_t>&     offsets
+																				 vector<size_t>&     offsets,
+																				 bool                canonical
 																				 )
-: PartitionsCommand_multibank<span> (partition, processor, cacheSize,  progress, timeInfo, pInfo, passi, parti,nbCores,kmerSize,pool),
+: PartitionsCommand_multibank<span> (partition, processor, cacheSize,  progress, timeInfo, pInfo, passi, parti,nbCores,kmerSize,pool,canonical),
 _radix_kmers (0), _bankIdMatrix(0), _radix_sizes(0), _r_idx(0), _nbItemsPerBankPerPart(offsets)
 {
 	_dispatcher = new Dispatcher (this->_nbCores);
@@ -1974,7 +2012,7 @@ void PartitionsByVectorCommand_multibank<span>::executeRead ()
 			LOCAL (itLocal);
 			
 			/** We iterate this local iterator. */
-			_dispatcher->iterate (itLocal, SuperKReader<span>  (this->_kmerSize, _r_idx, _radix_kmers, _radix_sizes, _bankIdMatrix, b), 10000); //must be even , reading by pairs
+			_dispatcher->iterate (itLocal, SuperKReader<span>  (this->_kmerSize, _r_idx, _radix_kmers, _radix_sizes, _bankIdMatrix, b, this->_canonical), 10000); //must be even , reading by pairs
 		}
 		
 		/** We check that the global iterator is finished. */
@@ -1984,7 +2022,7 @@ void PartitionsByVectorCommand_multibank<span>::executeRead ()
 	{
 		/** We iterate the superkmers. */
 
-			_dispatcher->iterate (this->_partition.iterator(), SuperKReader<span>  (this->_kmerSize, _r_idx, _radix_kmers, _radix_sizes, 0, 0), 10000); //must be even , reading by pairs
+			_dispatcher->iterate (this->_partition.iterator(), SuperKReader<span>  (this->_kmerSize, _r_idx, _radix_kmers, _radix_sizes, 0, 0, this->_canonical), 10000); //must be even , reading by pairs
 		
 		
 		
@@ -2001,32 +2039,7 @@ void PartitionsByVectorCommand_multibank<span>::executeSort ()
 {
 	TIME_INFO (this->_timeInfo, "2.sort");
 	
-	vector<ICommand*> cmds;
-	
-	int nwork = 256 / this->_nbCores;
-	
-	for (size_t xx=0; xx < (KX+1); xx++)
-	{
-		cmds.clear();
-		
-		//fill cmd work vector
-		for (size_t tid=0; tid < this->_nbCores; tid++)
-		{
-			int deb = 0 + tid * nwork;
-			int fin = (tid+1) * nwork -1; // thread will do inclusive range [begin -- end ]
-			if(tid == this->_nbCores-1)  { fin = 255; }
-			
-			// mettre dans le  SortCommand le master radix_kmers et range a traiter
-			cmds.push_back (new SortCommand<span> (
-			_radix_kmers+ IX(xx,0),
-			(_bankIdMatrix ? _bankIdMatrix+ IX(xx,0) : 0),
-			deb, fin,
-			_radix_sizes + IX(xx,0)
-												   ));
-		}
-		
-		_dispatcher->dispatchCommands (cmds, 0);
-	}
+	sortRadixBuckets<span> (_dispatcher, this->_nbCores, _radix_kmers, _bankIdMatrix, _radix_sizes, 256*(KX+1), this->_kmerSize, KX);
 }
 
 template<size_t span>
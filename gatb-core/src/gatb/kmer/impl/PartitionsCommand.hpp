@@ -128,7 +128,8 @@ public:
 		size_t                                          nbCores,
 		size_t                                          kmerSize,
 		gatb::core::tools::misc::impl::MemAllocator&    pool,
-		tools::storage::impl::SuperKmerBinFiles* 		superKstorage
+		tools::storage::impl::SuperKmerBinFiles* 		superKstorage,
+		bool                                            canonical = true
     );
 
     /** Destructor. */
@@ -158,6 +159,8 @@ protected:
 	
 	tools::storage::impl::SuperKmerBinFiles* 				_superKstorage;
 
+    /** True if the kmers are counted as canonical kmers, false if counted as read (ie. strand specific). */
+    bool _canonical;
 };
 
 /********************************************************************************/
@@ -186,7 +189,8 @@ public:
         size_t                                          kmerSize,
         gatb::core::tools::misc::impl::MemAllocator&    pool,
         u_int64_t                                       hashMemory,
-		tools::storage::impl::SuperKmerBinFiles* 		superKstorage
+		tools::storage::impl::SuperKmerBinFiles* 		superKstorage,
+        bool                                            canonical = true
     );
 
     /** Get the class name (for statistics). */
@@ -239,8 +243,8 @@ public:
 							   size_t                                          kmerSize,
 							   gatb::core::tools::misc::impl::MemAllocator&    pool,
 							   std::vector<size_t>&                            offsets,
-							   tools::storage::impl::SuperKmerBinFiles* 		superKstorage
-							   
+							   tools::storage::impl::SuperKmerBinFiles* 		superKstorage,
+							   bool                                            canonical = true
 							   );
 	
 	/** Destructor. */
@@ -299,7 +303,8 @@ public:
 								 int                                             parti,
 								 size_t                                          nbCores,
 								 size_t                                          kmerSize,
-								 gatb::core::tools::misc::impl::MemAllocator&    pool
+								 gatb::core::tools::misc::impl::MemAllocator&    pool,
+								 bool                                            canonical = true
 								 );
 	
 	/** Destructor. */
@@ -326,6 +331,9 @@ protected:
 	
 	CountProcessor* _processor;
 	void setProcessor (CountProcessor* processor)  { SP_SETATTR(processor); }
+
+	/** True if the kmers are counted as canonical kmers, false if counted as read (ie. strand specific). */
+	bool _canonical;
 };
 
 
@@ -360,7 +368,8 @@ public:
 										 size_t                                          nbCores,
 										 size_t                                          kmerSize,
 										 gatb::core::tools::misc::impl::MemAllocator&    pool,
-										 std::vector<size_t>&                            offsets
+										 std::vector<size_t>&                            offsets,
+										 bool                                            canonical = true
 										 );
 	
 	/** Destructor. */
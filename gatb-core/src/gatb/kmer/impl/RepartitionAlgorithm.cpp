@@ -85,7 +85,8 @@ using namespace gatb::core::tools::math;
 namespace gatb  {  namespace core  {   namespace kmer  {   namespace impl {
 /********************************************************************************/
 
-static const char* progressFormat0 = "DSK: Collecting stats on %s ";
+/** Minimum size of the parts of a file sampled in parallel for computing the repartition. */
+static const u_int64_t MIN_SAMPLE_CHUNK_SIZE = 4*1024*1024;
 
 
 /********************************************************************************/
@@ -228,11 +229,12 @@ public:
         bool *            cancelIterator,
         size_t            nbSeqsToSee,
         BankStats&        bankStats,
-        PartiInfo<5>&     pInfo
+        PartiInfo<5>&     pInfo,
+        ISynchronizer*    synchro = 0
     )
     :   Sequence2SuperKmer<span> (model, nbPasses, currentPass, nbPartitions, progress, bankStats)
         ,_kx(4), _extern_pInfo(pInfo), _local_pInfo(config._nb_partitions, model.getMmersModel().getKmerSize()),
-        _cancelIterator(cancelIterator), _nbSeqsToSee(nbSeqsToSee), _nbSuperKmersSeenSoFar(0)
+        _cancelIterator(cancelIterator), _nbSeqsToSee(nbSeqsToSee), _nbSuperKmersSeenSoFar(0), _synchro(synchro)
     {
     }
 
@@ -240,7 +242,9 @@ public:
     ~SampleRepart ()
     {
         //add to global parti_info
+        if (_synchro)  { _synchro->lock();   }
         _extern_pInfo += _local_pInfo;
+        if (_synchro)  { _synchro->unlock(); }
     }
 
 
@@ -251,8 +255,111 @@ private:
     bool*         _cancelIterator;
     size_t        _nbSeqsToSee;
     size_t        _nbSuperKmersSeenSoFar;
+    ISynchronizer* _synchro;
 };
 
+/********************************************************************************/
+/* Part of a bank to be sampled: the sequences are read from some position of the
+ * bank (only for a FASTA/FASTQ file) until some number of sequences is reached. */
+struct SampleChunk
+{
+    SampleChunk (IBank* bank=0, u_int64_t offset=0, u_int64_t nbSeqs=0) : bank(bank), offset(offset), nbSeqs(nbSeqs) {}
+
+    IBank*    bank;
+    u_int64_t offset;
+    u_int64_t nbSeqs;
+};
+
+/********************************************************************************/
+/* This functor class samples chunks of the banks through a SampleRepart object.
+ * It is copied for each thread of the dispatcher; each copy has its own SampleRepart,
+ * whose distribution of minimizers is added to the global one when the copy is deleted.
+ * The sampling stops for all the threads once the deadline (if any) is reached.
+ */
+template<size_t span>
+class SampleChunks
+{
+public:
+
+    /** Shortcut. */
+    typedef typename RepartitorAlgorithm<span>::Model Model;
+
+    /** */
+    void operator() (SampleChunk& chunk)
+    {
+        if (isExpired())  { return; }
+
+        if (_sampleRepart == 0)
+        {
+            _sampleRepart = new SampleRepart<span> (
+                _model,
+                _config,
+                1, // we don't care about the actual number of passes, we just use 1
+                0, // we don't care about the actual number of passes, the current one is 0
+                _config._nb_partitions,
+                NULL,
+                &_dummyCancel,  // the number of sequences to be sampled is checked here
+                ~0,
+                _bankStats,
+                _pInfo,
+                _synchro
+            );
+        }
+
+        /** We start reading a FASTA/FASTQ file at the offset of the chunk; other banks are read from the beginning. */
+        BankFasta* fasta = dynamic_cast<BankFasta*> (chunk.bank);
+        Iterator<Sequence>* it = (fasta != 0 && chunk.offset > 0) ? fasta->iterator (chunk.offset) : chunk.bank->iterator();
+        LOCAL (it);
+
+        u_int64_t nbSeqs = 0;
+        for (it->first(); !it->isDone() && nbSeqs < chunk.nbSeqs; it->next())
+        {
+            (*_sampleRepart) (it->item());
+
+            if ((++nbSeqs % 256)==0 && isExpired())  { break; }
+        }
+
+        __sync_fetch_and_add (&_nbSampled, nbSeqs);
+    }
+
+    /** Constructor. */
+    SampleChunks (Model& model, Configuration& config, ITime::Value deadline, ISynchronizer* synchro, PartiInfo<5>& pInfo, u_int64_t& nbSampled)
+        : _model(model), _config(config), _deadline(deadline), _synchro(synchro), _pInfo(pInfo), _nbSampled(nbSampled),
+          _sampleRepart(0), _dummyCancel(false)  {}
+
+    /** Copy constructor. */
+    SampleChunks (const SampleChunks& other)
+        : _model(other._model), _config(other._config), _deadline(other._deadline), _synchro(other._synchro),
+          _pInfo(other._pInfo), _nbSampled(other._nbSampled), _sampleRepart(0), _dummyCancel(false)  {}
+
+    /** Destructor. */
+    ~SampleChunks ()  {  delete _sampleRepart;  }
+
+private:
+
+    bool isExpired ()  {  return _deadline > 0  &&  System::time().getTimeStamp() >= _deadline;  }
+
+    Model&              _model;
+    Configuration&      _config;
+    ITime::Value        _deadline;
+    ISynchronizer*      _synchro;
+    PartiInfo<5>&       _pInfo;
+    u_int64_t&          _nbSampled;
+    BankStats           _bankStats;
+    SampleRepart<span>* _sampleRepart;
+    bool                _dummyCancel;
+};
+
+/********************************************************************************/
+/* Get the banks that are not composite (ie. the input files) of a bank. */
+static void getLeafBanks (IBank* bank, vector<IBank*>& leaves)
+{
+    vector<IBank*> banks = bank->getBanks();
+
+    if (banks.size()==1 && banks[0]==bank)  {  leaves.push_back (bank);  }
+    else  {  for (size_t i=0; i<banks.size(); i++)  {  getLeafBanks (banks[i], leaves);  }  }
+}
+
 /*********************************************************************
 ** METHOD  :
 ** PURPOSE :
@@ -297,6 +404,23 @@ RepartitorAlgorithm<span>::~RepartitorAlgorithm ()
 template<size_t span>
 void RepartitorAlgorithm<span>::execute ()
 {
+    /** We may use the repartition of a previous run, so we don't need to sample the input. */
+    if (!_config._repartitionIn.empty())
+    {
+        Repartitor repartitor;
+        repartitor.load (_config._repartitionIn, _config._kmerSize, _config._minim_size, _config._minimizerType);
+
+        if (repartitor.getNbPartitions() != _config._nb_partitions)
+        {
+            throw Exception ("Repartition file '%s' has %d partitions, not %d", _config._repartitionIn.c_str(), repartitor.getNbPartitions(), _config._nb_partitions);
+        }
+
+        repartitor.save (getGroup(), _config._kmerSize);
+
+        getInfo()->add (1, "repartition_in", "%s", _config._repartitionIn.c_str());
+        return;
+    }
+
     /** We compute the distribution of the minimizers. As a result, we will have a hash function
      * that gives a hash code for a minimizer value.
      * IMPORTANT ! we have to give the passes number because it has impact on the computation. */
@@ -308,6 +432,9 @@ void RepartitorAlgorithm<span>::execute ()
     if (_config._minimizerType == 1)  {  computeFrequencies (repartitor);  }
 
     computeRepartition (repartitor);
+
+    /** We may save the repartition for later runs. */
+    if (!_config._repartitionOut.empty())  {  repartitor.save (_config._repartitionOut, _config._kmerSize);  }
 }
 
 /*********************************************************************
@@ -411,120 +538,72 @@ void RepartitorAlgorithm<span>::computeRepartition (Repartitor& repartitor)
 
     PartiInfo<5> sample_info (_config._nb_partitions, mmsize);
 
-    string bankShortName = System::file().getBaseName(_bank->getId());
-
-    // In case of multi bank counting, we get a sample from each bank
-    if(_bank->getCompositionNb() > 1){
-
-    	//cout << _bank->getCompositionNb() << endl;
-    	SerialDispatcher serialDispatcher;
-        BankStats bstatsDummy;
-
-        u_int64_t nbseq_sample = (_config._estimateSeqNb / _config._nb_banks) * 0.01;
-        nbseq_sample = max((u_int64_t)nbseq_sample, (u_int64_t)100000);
-
-        Iterator<Sequence>* it = _bank->iterator(); LOCAL (it);
-        std::vector<Iterator<Sequence>*> itBanks =  it->getComposition(); 
-
-        /*
-        bool dummyBoolean = false;
-        SampleRepart<span> sampleRepart (
-            	        model,
-            	        _config,
-            	        1, // we don't care about the actual number of passes, we just use 1
-            	        0, // we don't care about the actual number of passes, the current one is 0
-            	        _config._nb_partitions,
-            	        NULL,
-            	        &dummyBoolean, // will be set to true when iteration needs to be stopped
-            	        nbseq_sample, // how many sequences we need to see
-            	        bstatsDummy,
-            	        sample_info
-            	    );*/
-
-		//SerialDispatcher serialDispatcher;
-		//BankStats bstatsDummy;
-
-        for(size_t i=0; i<_config._nb_banks; i++){
-        	//cout << i << endl;
-        	//u_int64_t nbseq_sample_ = min(nbseq_sample, u_int64_t (500000));
-        	//TruncateIterator<Sequence>* it = new TruncateIterator<Sequence> (*(itBanks[i]), nbseq_sample_);
-        	//LOCAL(it);
-    	    //serialDispatcher.iterate (it, sampleRepart);
-        	//Iterator<Sequence>* bankit = itBanks[i];
-        	//LOCAL(bankit);
-            CancellableIterator<Sequence>* cancellable_it = new CancellableIterator<Sequence> (*itBanks[i]);
-            LOCAL(cancellable_it);
-
-        	//cout << nbseq_sample << endl;
-    		/** We create a sequence iterator and give it a progress message */
-    		//Iterator<Sequence>* it_all_reads = createIterator<Sequence> (
-            //		cancellable_it,
-            //		_bank->getNbItems(),
-            //		Stringify::format (progressFormat0, bankShortName.c_str()).c_str()
-            //		);
-            //LOCAL (it_all_reads);
-
-
-
-    		/** We compute a distribution of Superkmers from a part of the bank. */
-    		serialDispatcher.iterate (cancellable_it, SampleRepart<span> (
-    			model,
-    			_config,
-    			1, // we don't care about the actual number of passes, we just use 1
-    			0, // we don't care about the actual number of passes, the current one is 0
-    			_config._nb_partitions,
-    			NULL,
-    			&(cancellable_it->_cancel), // will be set to true when iteration needs to be stopped
-    			nbseq_sample, // how many sequences we need to see
-    			bstatsDummy,
-    			sample_info
-    		));
-
-    		//cout << "end" << endl;
-    		//it_all_reads->finalize() ;
-    		//cancellable_it->finalize() ;
-    		itBanks[i]->finalize();
-    		//delete cancellable_it;
+    /** We get the input files (or more generally the non composite banks) to be sampled. */
+    vector<IBank*> banks;
+    getLeafBanks (_bank, banks);
+
+    /** We compute how many sequences we need to see; by default, at least 1M sequences for one bank,
+     * and 100K sequences per bank for several banks. */
+    u_int64_t nbSeqsToSample = _config._repartitionSampleSize;
+    if (nbSeqsToSample == 0)
+    {
+        if (_bank->getCompositionNb() > 1)
+        {
+            u_int64_t nbSeqsPerBank = (_config._estimateSeqNb / _config._nb_banks) * 0.01;
+            nbSeqsToSample = max (nbSeqsPerBank, (u_int64_t)100000) * _config._nb_banks;
+        }
+        else
+        {
+            nbSeqsToSample = std::max (u_int64_t (_config._estimateSeqNb * 0.05), u_int64_t (1000000ULL));
         }
     }
-    else{
-
-        Iterator<Sequence>* it = _bank->iterator();      LOCAL (it);
-        CancellableIterator<Sequence>* cancellable_it = new CancellableIterator<Sequence> (*(it));
-        LOCAL(cancellable_it);
-
-
-		// how many seqs we need to see
-		u_int64_t nbseq_sample = std::max ( u_int64_t (_config._estimateSeqNb * 0.05) ,u_int64_t( 1000000ULL) ) ;
-
-    	//cout << nbseq_sample << endl;
-		/** We create a sequence iterator and give it a progress message */
-		Iterator<Sequence>* it_all_reads = createIterator<Sequence> (
-				cancellable_it,
-				_bank->getNbItems(),
-				Stringify::format (progressFormat0, bankShortName.c_str()).c_str()
-				);
-		LOCAL (it_all_reads);
-
-
-		BankStats bstatsDummy;
-
-		/** We compute a distribution of Superkmers from a part of the bank. */
-		SerialDispatcher serialDispatcher;
-		serialDispatcher.iterate (it_all_reads, SampleRepart<span> (
-			model,
-			_config,
-			1, // we don't care about the actual number of passes, we just use 1
-			0, // we don't care about the actual number of passes, the current one is 0
-			_config._nb_partitions,
-			NULL,
-			&(cancellable_it->_cancel), // will be set to true when iteration needs to be stopped
-			nbseq_sample, // how many sequences we need to see
-			bstatsDummy,
-			sample_info
-		));
+
+    /** We split the sampling of each uncompressed FASTA/FASTQ file into chunks starting at evenly spaced
+     * positions of the file, so the sample is representative of the whole file and is read in parallel.
+     * Other banks (and compressed files, since seeking into them means uncompressing) are read from the
+     * beginning. */
+    size_t maxNbChunks = 4 * getDispatcher()->getExecutionUnitsNumber();
+
+    vector<SampleChunk> chunks;
+    for (size_t i=0; i<banks.size(); i++)
+    {
+        u_int64_t nbSeqsPerBank = std::max (nbSeqsToSample / banks.size(), (u_int64_t)1);
+
+        BankFasta* fasta = dynamic_cast<BankFasta*> (banks[i]);
+
+        u_int64_t fileSize = (fasta != 0 && !fasta->isCompressed()) ? System::file().getSize (fasta->getId()) : 0;
+        size_t    nbChunks = std::max (std::min ((u_int64_t)maxNbChunks, fileSize / MIN_SAMPLE_CHUNK_SIZE), (u_int64_t)1);
+
+        /** A chunk is read until its number of sequences is reached, so we don't read more than the
+         * sequences expected in the chunk; otherwise the chunks of a small file would overlap. */
+        if (nbChunks > 1)  {  nbSeqsPerBank = std::min (nbSeqsPerBank, (u_int64_t)banks[i]->estimateNbItems());  }
+
+        for (size_t j=0; j<nbChunks; j++)
+        {
+            chunks.push_back (SampleChunk (banks[i], (fileSize / nbChunks) * j, std::max (nbSeqsPerBank / nbChunks, (u_int64_t)1)));
+        }
+    }
+
+    /** The sampling may also be bounded in time. */
+    ITime::Value deadline = _config._repartitionSampleTime > 0 ?  System::time().getTimeStamp() + 1000*_config._repartitionSampleTime : 0;
+
+    u_int64_t nbSampled = 0;
+    {
+        TIME_INFO (getTimeInfo(), "sample");
+
+        ISynchronizer* synchro = System::thread().newSynchronizer();
+        LOCAL (synchro);
+
+        /** We compute a distribution of Superkmers from a part of the banks. */
+        getDispatcher()->iterate (new VectorIterator2<SampleChunk> (chunks), SampleChunks<span> (
+            model, _config, deadline, synchro, sample_info, nbSampled
+        ), 1, true);
     }
 
+    getInfo()->add (1, "sample");
+    getInfo()->add (2, "nb_chunks",    "%ld", chunks.size());
+    getInfo()->add (2, "nb_sequences", "%ld", nbSampled);
+
     if (_config._minimizerType == 1)
     {
         repartitor.justGroup (sample_info, _counts);
@@ -539,7 +618,7 @@ void RepartitorAlgorithm<span>::computeRepartition (Repartitor& repartitor)
     }
 
     /** We save the distribution (may be useful for debloom for instance). */
-    repartitor.save (getGroup());
+    repartitor.save (getGroup(), _config._kmerSize);
 }
 
 /********************************************************************************/
@@ -27,6 +27,8 @@
 #include <gatb/kmer/impl/ConfigurationAlgorithm.hpp>
 #include <gatb/tools/misc/impl/Stringify.hpp>
 #include <gatb/kmer/impl/PartitionsCommand.hpp>
+#include <gatb/kmer/impl/PartitionScheduler.hpp>
+#include <gatb/kmer/impl/PartitionCostModel.hpp>
 #include <gatb/kmer/impl/RepartitionAlgorithm.hpp>
 #include <gatb/tools/misc/impl/Progress.hpp>
 #include <gatb/bank/impl/Bank.hpp>
@@ -83,6 +85,12 @@ static const char* progressFormat1 = "DSK: Pass %d/%d, Step 1: partitioning    "
 static const char* progressFormat2 = "DSK: Pass %d/%d, Step 2: counting kmers  ";
 static const char* progressFormat4 = "DSK: nb solid kmers found : %-9ld  ";
 
+/** Uri of a storage without its ".h5" extension, for comparing uris of storages. */
+static string withoutExtension (const string& uri)
+{
+    return (uri.size() > 3 && uri.compare (uri.size()-3, 3, ".h5") == 0) ? uri.substr (0, uri.size()-3) : uri;
+}
+
 /*********************************************************************
 ** METHOD  :
 ** PURPOSE :
@@ -95,7 +103,7 @@ template<size_t span>
 SortingCountAlgorithm<span>::SortingCountAlgorithm (IProperties* params)
   : Algorithm("dsk", -1, params),
     _bank(0), _repartitor(0),
-    _progress (0), _tmpPartitionsStorage(0), _tmpPartitions(0), _storage(0),_superKstorage(0)
+    _progress (0), _tmpPartitionsStorage(0), _tmpPartitions(0), _storage(0), _previousStorage(0), _superKstorage(0), _costModel(0)
 {
 }
 
@@ -111,7 +119,7 @@ template<size_t span>
 SortingCountAlgorithm<span>::SortingCountAlgorithm (IBank* bank, IProperties* params)
   : Algorithm("dsk", -1, params),
     _bank(0), _repartitor(0),
-    _progress (0),_tmpPartitionsStorage(0), _tmpPartitions(0), _storage(0),_superKstorage(0)
+    _progress (0),_tmpPartitionsStorage(0), _tmpPartitions(0), _storage(0), _previousStorage(0), _superKstorage(0), _costModel(0)
 {
     setBank (bank);
 }
@@ -135,7 +143,7 @@ SortingCountAlgorithm<span>::SortingCountAlgorithm (
 )
   : Algorithm("dsk", config._nbCores, params),
     _config(config), _bank(0), _repartitor(0),
-    _progress (0),_tmpPartitionsStorage(0), _tmpPartitions(0), _storage(0),_superKstorage(0)
+    _progress (0),_tmpPartitionsStorage(0), _tmpPartitions(0), _storage(0), _previousStorage(0), _superKstorage(0), _costModel(0)
 {
     setBank       (bank);
     setRepartitor (repartitor);
@@ -160,8 +168,11 @@ SortingCountAlgorithm<span>::~SortingCountAlgorithm ()
  //   setPartitionsStorage    (0);
  //   setPartitions           (0);
     setStorage              (0);
+    setPreviousStorage      (0);
+    setCostModel            (0);
 
     for (size_t i=0; i<_processors.size(); i++)  { _processors[i]->forget(); }
+    for (size_t i=0; i<_listeners.size();  i++)  { _listeners[i]->forget();  }
 }
 
 /*********************************************************************
@@ -212,11 +223,18 @@ IOptionsParser* SortingCountAlgorithm<span>::getOptionsParser (bool mandatory)
     parser->push_back (new OptionOneParam (STR_KMER_ABUNDANCE_MIN_THRESHOLD,"min abundance hard threshold (only used when min abundance is \"auto\")",false, "2"));
     parser->push_back (new OptionOneParam (STR_HISTOGRAM_MAX,     "max number of values in kmers histogram",        false, "10000"));
     parser->push_back (new OptionOneParam (STR_SOLIDITY_KIND,     "way to compute counts of several files (sum, min, max, one, all, custom)",false, "sum"));
+#ifdef NONCANONICAL
+    parser->push_back (new OptionOneParam (STR_KMER_ORIENTATION,  "orientation of the counted kmers (canonical, direct, both)", false, "direct"));
+#else
+    parser->push_back (new OptionOneParam (STR_KMER_ORIENTATION,  "orientation of the counted kmers (canonical, direct, both)", false, "canonical"));
+#endif
 	parser->push_back (new OptionOneParam (STR_SOLIDITY_CUSTOM,   "when solidity-kind is cutom, specifies list of files where kmer must be present",false, ""));
+    parser->push_back (new OptionOneParam (STR_COUNT_MATRIX,      "dump the counts of the solid kmers in each file as a kmer x file matrix (0=no, 1=yes)", false, "0"));
     parser->push_back (new OptionOneParam (STR_MAX_MEMORY,        "max memory (in MBytes)",                         false, "5000"));
     parser->push_back (new OptionOneParam (STR_MAX_DISK,          "max disk   (in MBytes)",                         false, "0"));
     parser->push_back (new OptionOneParam (STR_URI_SOLID_KMERS,   "output file for solid kmers (only when constructing a graph)", false));
     parser->push_back (new OptionOneParam (STR_URI_OUTPUT,        "output file",                                    false));
+    parser->push_back (new OptionOneParam (STR_INCREMENTAL_IN,    "output of a previous run (with abundance-min 1) whose counts are added to the ones of the input", false));
     parser->push_back (new OptionOneParam (STR_URI_OUTPUT_DIR,    "output directory",                               false, "."));
     parser->push_back (new OptionOneParam (STR_URI_OUTPUT_TMP,    "output directory for temporary files",           false, "."));
     parser->push_back (new OptionOneParam (STR_COMPRESS_LEVEL,    "h5 compression level (0:none, 9:best)",          false, "0"));
@@ -227,6 +245,15 @@ IOptionsParser* SortingCountAlgorithm<span>::getOptionsParser (bool mandatory)
     devParser->push_back (new OptionOneParam (STR_MINIMIZER_TYPE,    "minimizer type (0=lexi, 1=freq)",                false, "0"));
     devParser->push_back (new OptionOneParam (STR_MINIMIZER_SIZE,    "size of a minimizer",                            false, "10"));
     devParser->push_back (new OptionOneParam (STR_REPARTITION_TYPE,  "minimizer repartition (0=unordered, 1=ordered)", false, "0"));
+    devParser->push_back (new OptionOneParam (STR_REPARTITION_SAMPLE_SIZE, "max number of sequences sampled for the minimizer repartition (0=automatic)", false, "0"));
+    devParser->push_back (new OptionOneParam (STR_REPARTITION_SAMPLE_TIME, "max time (in seconds) of the sampling for the minimizer repartition (0=no limit)", false, "0"));
+    devParser->push_back (new OptionOneParam (STR_REPARTITION_IN,    "minimizer repartition file of a previous run to be used instead of sampling the input", false));
+    devParser->push_back (new OptionOneParam (STR_REPARTITION_OUT,   "save the minimizer repartition into a file, for use by later runs", false));
+    devParser->push_back (new OptionOneParam (STR_PIPELINE_PASSES,   "partition pass N+1 while counting pass N (0=no, 1=yes)", false, "0"));
+    devParser->push_back (new OptionOneParam (STR_SUPERK_COMPRESS,   "compress the superkmers temporary files (0=no, 1=yes)", false, "0"));
+    devParser->push_back (new OptionOneParam (STR_SUPERK_IN_MEMORY,  "keep the superkmers in memory, spilling to disk beyond half the max memory (0=no, 1=yes)", false, "0"));
+    devParser->push_back (new OptionOneParam (STR_ESTIMATE_DISTINCT, "estimate the number of distinct kmers with a HyperLogLog sketch, reading the whole input once more (0=no, 1=yes)", false, "0"));
+    devParser->push_back (new OptionOneParam (STR_COUNT_STRATEGY,    "way to count a partition (auto, sort, hash); 'auto' chooses per partition from its kmers redundancy", false, "auto"));
     parser->push_back (devParser);
 
     return parser;
@@ -260,7 +287,8 @@ template<size_t span>
 ICountProcessor<span>* SortingCountAlgorithm<span>::getDefaultProcessor (
     tools::misc::IProperties*       params,
     tools::storage::impl::Storage*  dskStorage,
-    tools::storage::impl::Storage*  otherStorage
+    tools::storage::impl::Storage*  otherStorage,
+    const vector<IPartitionListener<span>*>& listeners
 )
 {
     CountProcessor* result = 0;
@@ -273,7 +301,21 @@ ICountProcessor<span>* SortingCountAlgorithm<span>::getDefaultProcessor (
      *      1) histogram
      *      2) solidity filter
      *      3) if solidity filter passed, dump to file system
+     *      4) if asked, dump the counts of each bank of the solid kmers as a count matrix
+     *      5) if some listeners are provided, publish the solid kmers to them
+     *
+     * For the 'both' kmers orientation, the chain receives the canonical kmers and the strand
+     * specific kmers of the solid ones are dumped into the 'dsk_stranded' group.
      */
+    CountProcessor* matrix = 0;
+    if (params->get(STR_COUNT_MATRIX) && params->getInt(STR_COUNT_MATRIX))
+    {
+        matrix = new CountProcessorMatrix<span> (dskStorage->getGroup("matrix"), params->getInt(STR_KMER_SIZE));
+    }
+
+    CountProcessor* stream = listeners.empty() ? NULL : new CountProcessorStream<span> (listeners);
+
+    /** Note: the chain ends at the first null item, so the optional processors are packed at its end. */
     result = new CountProcessorChain<span> (
 
         new CountProcessorHistogram<span> (
@@ -288,12 +330,33 @@ ICountProcessor<span>* SortingCountAlgorithm<span>::getDefaultProcessor (
             dskStorage->getGroup("dsk"),
             params->getInt(STR_KMER_SIZE)
         ),
+
+        matrix != NULL ? matrix : stream,
+        matrix != NULL ? stream : NULL,
         NULL
     );
 
     /** We set some name. */
     result->setName ("dsk");
 
+    KmerOrientation orientation = KMER_ORIENTATION_CANONICAL;
+    if (params->get(STR_KMER_ORIENTATION))  {  parse (params->getStr(STR_KMER_ORIENTATION), orientation);  }
+
+    if (orientation == KMER_ORIENTATION_BOTH)
+    {
+        CountProcessor* stranded = new CountProcessorChain<span> (
+            new CountProcessorDump <span> (
+                dskStorage->getGroup("dsk_stranded"),
+                params->getInt(STR_KMER_SIZE)
+            ),
+            NULL
+        );
+        stranded->setName ("dsk_stranded");
+
+        result = new CountProcessorStrand<span> (result, stranded, params->getInt(STR_KMER_SIZE));
+        result->setName ("dsk");
+    }
+
     return result;
 }
 
@@ -348,12 +411,13 @@ vector<ICountProcessor<span>*> SortingCountAlgorithm<span>::getDefaultProcessorV
     Configuration&  config,
     IProperties*    params,
     Storage*        dskStorage,
-    Storage*        otherStorage
+    Storage*        otherStorage,
+    const vector<IPartitionListener<span>*>& listeners
 )
 {
     vector<ICountProcessor<span>*> result;
 
-    ICountProcessor<span>* dskProcessor = getDefaultProcessor (params, dskStorage, otherStorage);
+    ICountProcessor<span>* dskProcessor = getDefaultProcessor (params, dskStorage, otherStorage, listeners);
 
     /** Now, we define the vector of count processors to be given to the SortingCountAlgorithm.
      * The choice depends on the presence of "auto" min abundance in the configuration. */
@@ -449,6 +513,13 @@ void SortingCountAlgorithm<span>::configure ()
             {std::cout << "Error: unknown storage type specified: " << storage_type << std::endl; exit(1); }
         }
 
+        /** The output of a previous run to be merged must not be overwritten by the output of this one. */
+        string incrementalIn = _config._isComputed ? _config._incrementalIn : (getInput()->get(STR_INCREMENTAL_IN) ? getInput()->getStr(STR_INCREMENTAL_IN) : "");
+        if (!incrementalIn.empty() && withoutExtension(incrementalIn) == withoutExtension(output))
+        {
+            throw Exception ("Output '%s' would overwrite the previous counts to be merged", output.c_str());
+        }
+
         storage = StorageFactory(_storage_type).create (output, true, false); //// this is the storage for the output (kmer counts), formerly fixed to HDF5
     }
 
@@ -480,7 +551,43 @@ void SortingCountAlgorithm<span>::configure ()
     }
 
 	/** We check that the processor is ok, otherwise we build one. */
-    if (_processors.size() == 0)  { _processors = getDefaultProcessorVector(_config, getInput(), storage, storage);  };
+    if (_processors.size() == 0)
+    {
+        vector<CountProcessor*> processors = getDefaultProcessorVector(_config, getInput(), storage, storage, _listeners);
+        for (size_t i=0; i<processors.size(); i++)  {  addProcessor (processors[i]);  }
+    }
+
+    /** For an incremental counting, the processors receive the counts of the input added to the
+     * ones of the previous run, partition by partition. */
+    if (!_config._incrementalIn.empty())
+    {
+        setPreviousStorage (StorageFactory(STORAGE_HDF5).load (_config._incrementalIn));
+        Partition<Count>* previous = & _previousStorage->getGroup("dsk").getPartition<Count> ("solid");
+
+        for (size_t i=0; i<_processors.size(); i++)
+        {
+            CountProcessor* merge = new CountProcessorMerge<span> (_processors[i], previous, _config._nb_partitions);
+            merge->use();
+            _processors[i]->forget();
+            _processors[i] = merge;
+        }
+    }
+
+    /** For the 'both' kmers orientation, the kmers are counted as read and the processors expect
+     * canonical kmers, so we fold the strand specific counts for the processors that don't do it. */
+    if (_config._orientation == KMER_ORIENTATION_BOTH)
+    {
+        for (size_t i=0; i<_processors.size(); i++)
+        {
+            if (dynamic_cast<CountProcessorStrand<span>*> (_processors[i]) != 0)  { continue; }
+
+            CountProcessor* strand = new CountProcessorStrand<span> (_processors[i], 0, _config._kmerSize);
+            strand->setName (_processors[i]->getName());
+            strand->use();
+            _processors[i]->forget();
+            _processors[i] = strand;
+        }
+    }
 
     DEBUG (("SortingCountAlgorithm<span>::configure  END  _bank=%p  _config.isComputed=%d  _repartitor=%p  storage=%p\n",
         _bank, _config._isComputed, _repartitor, storage
@@ -531,25 +638,27 @@ void SortingCountAlgorithm<span>::execute ()
     /** We create the PartiInfo instance. */
     PartiInfo<5> pInfo (_config._nb_partitions, _config._minim_size);
 
+    /** We create the model choosing how to count each partition. Note that hashing is possible only
+     * with the superkmers storage, ie. for the 'sum' solidity kind. */
+    string countStrategy = getInput()->get(STR_COUNT_STRATEGY) ? getInput()->getStr(STR_COUNT_STRATEGY) : "auto";
+    if (countStrategy!="auto" && countStrategy!="sort" && countStrategy!="hash")
+    {
+        throw Exception ("bad count strategy '%s' (should be auto, sort or hash)", countStrategy.c_str());
+    }
+    bool hashAllowed = _config._solidityKind == KMER_SOLIDITY_SUM;
+    setCostModel (new PartitionCostModel (countStrategy!="hash" || !hashAllowed, countStrategy!="sort" && hashAllowed));
+
     /** We notify the count processor about the start of the main loop. */
     for (size_t i=0; i<_processors.size(); i++)  {  _processors[i]->begin (_config); }
 
     /*************************************************************/
     /*                         MAIN LOOP                         */
     /*************************************************************/
-    /** We loop N times the bank. For each pass, we will consider a subset of the whole kmers set of the bank. */
-    for (size_t current_pass=0; current_pass < _config._nb_passes; current_pass++)
-    {
-        DEBUG (("SortingCountAlgorithm<span>::execute  pass [%ld,%d] \n", current_pass+1, _config._nb_passes));
-
-        pInfo.clear();
+    bool pipelined = canPipelinePasses();
 
-        /** 1) We fill the partition files. */
-        fillPartitions (current_pass, itSeq, pInfo);
-
-        /** 2) We fill the kmers solid file from the partition files. */
-        fillSolidKmers (current_pass, pInfo);
-    }
+    /** We loop N times the bank. For each pass, we will consider a subset of the whole kmers set of the bank. */
+    if (pipelined)  {  executePipelined  (itSeq, pInfo);  }
+    else            {  executeSequential (itSeq, pInfo);  }
 
     /** We notify the count processor about the stop of the main loop. */
     for (size_t i=0; i<_processors.size(); i++)  {  _processors[i]->end (); }
@@ -571,10 +680,18 @@ void SortingCountAlgorithm<span>::execute ()
 	if(_config._solidityKind != KMER_SOLIDITY_SUM)
      _tmpPartitions->remove ();
 
-	u_int64_t totaltmp, biggesttmp, smallesttmp;
+	u_int64_t totaltmp, biggesttmp, smallesttmp, rawtmp, memtmp;
 	float meantmp;
+	bool compressedtmp = false;
+	int ondisktmp = 0;
 	if(_config._solidityKind == KMER_SOLIDITY_SUM)
+	{
 		_superKstorage->getFilesStats(totaltmp,biggesttmp,smallesttmp, meantmp);
+		rawtmp = _superKstorage->getRawFilesSize();
+		compressedtmp = _superKstorage->isCompressed();
+		memtmp = _superKstorage->getMemoryUsage();
+		ondisktmp = _superKstorage->getNbFilesOnDisk();
+	}
 
 
 	if(_superKstorage!=0)
@@ -615,6 +732,7 @@ void SortingCountAlgorithm<span>::execute ()
     getInfo()->add (1, "stats");
 	
 	getInfo()->add (2, "temp_files");
+	getInfo()->add (3, "pipelined_passes","%d",pipelined);
 	getInfo()->add (3, "nb_superkmers","%lld",nbtotalsuperk);
 	getInfo()->add (3, "avg_superk_length","%.2f",(nbtotalk/(float) nbtotalsuperk));
 	getInfo()->add (3, "minimizer_density","%.2f",(nbtotalsuperk/(float)nbtotalk)*(_config._kmerSize - _config._minim_size +2));
@@ -625,6 +743,13 @@ void SortingCountAlgorithm<span>::execute ()
 		getInfo()->add (3, "tmp_file_biggest_(MB)","%lld",biggesttmp/1024LL/1024LL);
 		getInfo()->add (3, "tmp_file_smallest_(MB)","%lld",smallesttmp/1024LL/1024LL);
 		getInfo()->add (3, "tmp_file_mean_(MB)","%.1f",meantmp/1024LL/1024LL);
+		getInfo()->add (3, "in_memory_(MB)","%lld",memtmp/1024LL/1024LL);
+		getInfo()->add (3, "nb_files_on_disk","%d",ondisktmp);
+		if(compressedtmp)
+		{
+			getInfo()->add (3, "raw_size_(MB)","%lld",rawtmp/1024LL/1024LL);
+			getInfo()->add (3, "compression_ratio","%.3f",rawtmp>0 ? totaltmp/(float)rawtmp : 1.0);
+		}
 	}
     /** We dump information about count processors. */
     if (_processors.size()==1)  {  getInfo()->add (2, _processors[0]->getProperties()); }
@@ -640,6 +765,9 @@ void SortingCountAlgorithm<span>::execute ()
     _fillTimeInfo /= getDispatcher()->getExecutionUnitsNumber();
     getInfo()->add (2, _fillTimeInfo.getProperties("fillsolid_time"));
 
+    /** We dump the choices made for counting the partitions. */
+    getInfo()->add (2, _costModel->getProperties());
+
     getInfo()->add (1, getTimeInfo().getProperties("time"));
 }
 
@@ -827,17 +955,17 @@ public:
             /*********************************************/
 
             Type radix_kxmer_forward ,radix_kxmer ;
-            bool prev_which = superKmer[0].which();
+            bool prev_which = which (superKmer[0]);
             size_t kx_size =0;
 
-            radix_kxmer_forward = getHeavyWeight (superKmer[0].value());
+            radix_kxmer_forward = getHeavyWeight (counted (superKmer[0]));
 
             for (size_t ii=1 ; ii < superKmer.size(); ii++)
             {
                 //compute here stats on  kx mer
                 //tant que tai <= xmer et which kmer[ii] == which kmer [ii-1] --> cest un kxmer
                 //do the same in sampling : gives ram estimation
-                if (superKmer[ii].which() != prev_which || kx_size >= this->_kx) // kxmer_size = 1 //cost should diminish with larger kxmer
+                if (which (superKmer[ii]) != prev_which || kx_size >= this->_kx) // kxmer_size = 1 //cost should diminish with larger kxmer
                 {
                     //output kxmer size kx_size,radix_kxmer
                     //kx mer is composed of _superKp[ii-1] _superKp[ii-2] .. _superKp[ii-n] with nb elems  n  == kxmer_size +1  (un seul kmer ==k+0)
@@ -847,12 +975,12 @@ public:
                     }
                     else // si revcomp, le radix du kxmer est le debut du dernier kmer
                     {
-                        radix_kxmer = getHeavyWeight (superKmer[ii-1].value());
+                        radix_kxmer = getHeavyWeight (counted (superKmer[ii-1]));
                     }
 
                     this->_local_pInfo.incKmer_and_rad (p, radix_kxmer.getVal(), kx_size); //nb of superkmer per x per parti per radix
 
-                    radix_kxmer_forward =  getHeavyWeight (superKmer[ii].value());
+                    radix_kxmer_forward =  getHeavyWeight (counted (superKmer[ii]));
                     kx_size =0;
                 }
                 else
@@ -860,7 +988,7 @@ public:
                     kx_size++;
                 }
 
-                prev_which = superKmer[ii].which() ;
+                prev_which = which (superKmer[ii]) ;
             }
 
             //record last kx mer
@@ -870,7 +998,7 @@ public:
             }
             else // si revcomp, le radix du kxmer est le debut du dernier kmer
             {
-                radix_kxmer =  getHeavyWeight (superKmer[superKmer.size()-1].value());
+                radix_kxmer =  getHeavyWeight (counted (superKmer[superKmer.size()-1]));
             }
 
             this->_local_pInfo.incKmer_and_rad(p, radix_kxmer.getVal(),kx_size );
@@ -892,12 +1020,13 @@ public:
         Partition<Type>*   partition,
         Repartitor&        repartition,
         PartiInfo<5>&      pInfo,
-		SuperKmerBinFiles* superKstorage
+		SuperKmerBinFiles* superKstorage,
+        bool               canonical
     )
     :   Sequence2SuperKmer<span> (model, nbPasses, currentPass, nbPartitions, progress, bankStats),
         _kx(4),
         _extern_pInfo(pInfo) , _local_pInfo(nbPartitions,model.getMmersModel().getKmerSize()),
-        _repartition (repartition)
+        _repartition (repartition), _canonical(canonical)
 	    ,_partition (*partition, nbCacheItems, 0)/*, _superkmerFiles(superKstorage,nbCacheItems* sizeof(Type))*/
     {
         _mask_radix.setVal((int64_t) 255);
@@ -921,6 +1050,7 @@ private:
     PartiInfo<5>  _local_pInfo;
     Type          _mask_radix;
     Repartitor&   _repartition;
+    bool          _canonical;
 	
     /** Shared resources (must support concurrent accesses). */
     PartitionCacheType <Type> _partition;
@@ -929,6 +1059,10 @@ private:
 	
 
     Type getHeavyWeight (const Type& kmer) const  {  return (kmer & this->_mask_radix) >> ((this->_kmersize - 4)*2);  }
+
+    /** Kmer as it is counted (canonical or as read), and whether it is read in the forward strand. */
+    const Type& counted (const KmerType& kmer) const  {  return _canonical ? kmer.value() : kmer.forward();  }
+    bool        which   (const KmerType& kmer) const  {  return !_canonical || kmer.which();  }
 };
 
 	
@@ -963,17 +1097,17 @@ private:
 				/*********************************************/
 				
 				Type radix_kxmer_forward ,radix_kxmer ;
-				bool prev_which = superKmer[0].which();
+				bool prev_which = which (superKmer[0]);
 				size_t kx_size =0;
 				
-				radix_kxmer_forward = getHeavyWeight (superKmer[0].value());
+				radix_kxmer_forward = getHeavyWeight (counted (superKmer[0]));
 				
 				for (size_t ii=1 ; ii < superKmer.size(); ii++)
 				{
 					//compute here stats on  kx mer
 					//tant que tai <= xmer et which kmer[ii] == which kmer [ii-1] --> cest un kxmer
 					//do the same in sampling : gives ram estimation
-					if (superKmer[ii].which() != prev_which || kx_size >= this->_kx) // kxmer_size = 1 //cost should diminish with larger kxmer
+					if (which (superKmer[ii]) != prev_which || kx_size >= this->_kx) // kxmer_size = 1 //cost should diminish with larger kxmer
 					{
 						//output kxmer size kx_size,radix_kxmer
 						//kx mer is composed of _superKp[ii-1] _superKp[ii-2] .. _superKp[ii-n] with nb elems  n  == kxmer_size +1  (un seul kmer ==k+0)
@@ -983,12 +1117,12 @@ private:
 						}
 						else // si revcomp, le radix du kxmer est le debut du dernier kmer
 						{
-							radix_kxmer = getHeavyWeight (superKmer[ii-1].value());
+							radix_kxmer = getHeavyWeight (counted (superKmer[ii-1]));
 						}
 						
 						this->_local_pInfo.incKmer_and_rad (p, radix_kxmer.getVal(), kx_size); //nb of superkmer per x per parti per radix
 						
-						radix_kxmer_forward =  getHeavyWeight (superKmer[ii].value());
+						radix_kxmer_forward =  getHeavyWeight (counted (superKmer[ii]));
 						kx_size =0;
 					}
 					else
@@ -996,7 +1130,7 @@ private:
 						kx_size++;
 					}
 					
-					prev_which = superKmer[ii].which() ;
+					prev_which = which (superKmer[ii]) ;
 				}
 				
 				//record last kx mer
@@ -1006,10 +1140,13 @@ private:
 				}
 				else // si revcomp, le radix du kxmer est le debut du dernier kmer
 				{
-					radix_kxmer =  getHeavyWeight (superKmer[superKmer.size()-1].value());
+					radix_kxmer =  getHeavyWeight (counted (superKmer[superKmer.size()-1]));
 				}
 				
 				this->_local_pInfo.incKmer_and_rad(p, radix_kxmer.getVal(),kx_size );
+
+				/** We sample the kmers for estimating the number of distinct kmers of the partition. */
+				for (size_t ii=0 ; ii < superKmer.size(); ii++)  {  this->_local_pInfo.incDistinct (p, oahash (counted (superKmer[ii])));  }
 				
 				/** We update progression information. */
 				this->_nbWrittenKmers += superKmer.size();
@@ -1028,12 +1165,13 @@ private:
 						Partition<Type>*   partition,
 						Repartitor&        repartition,
 						PartiInfo<5>&      pInfo,
-						SuperKmerBinFiles* superKstorage
+						SuperKmerBinFiles* superKstorage,
+						bool               canonical
 						)
 		:   Sequence2SuperKmer<span> (model, nbPasses, currentPass, nbPartitions, progress, bankStats),
 		_kx(4),
 		_extern_pInfo(pInfo) , _local_pInfo(nbPartitions,model.getMmersModel().getKmerSize()),
-		_repartition (repartition)
+		_repartition (repartition), _canonical(canonical)
 		,/*_partition (*partition, nbCacheItems, 0),*/ _superkmerFiles(superKstorage,nbCacheItems* sizeof(Type))
 		{
 			_mask_radix.setVal((int64_t) 255);
@@ -1057,6 +1195,7 @@ private:
 		PartiInfo<5>  _local_pInfo;
 		Type          _mask_radix;
 		Repartitor&   _repartition;
+		bool          _canonical;
 		
 		/** Shared resources (must support concurrent accesses). */
 		//PartitionCacheType <Type> _partition;
@@ -1065,8 +1204,251 @@ private:
 		
 		
 		Type getHeavyWeight (const Type& kmer) const  {  return (kmer & this->_mask_radix) >> ((this->_kmersize - 4)*2);  }
+
+		/** Kmer as it is counted (canonical or as read), and whether it is read in the forward strand. */
+		const Type& counted (const KmerType& kmer) const  {  return _canonical ? kmer.value() : kmer.forward();  }
+		bool        which   (const KmerType& kmer) const  {  return !_canonical || kmer.which();  }
 	};
 	
+/********************************************************************************/
+template<size_t span>
+class SortingCountAlgorithm<span>::FillPartitionsCommand : public ICommand, public system::SmartPointer
+{
+public:
+    FillPartitionsCommand (SortingCountAlgorithm<span>& algo, size_t pass, Iterator<Sequence>* itSeq, PartiInfo<5>& pInfo, SuperKmerBinFiles* superKstorage)
+        : _algo(algo), _pass(pass), _itSeq(itSeq), _pInfo(pInfo), _superKstorage(superKstorage)  {}
+
+    void execute ()  {  _algo.fillPartitions (_pass, _itSeq, _pInfo, _superKstorage);  }
+
+private:
+    SortingCountAlgorithm<span>& _algo;
+    size_t                       _pass;
+    Iterator<Sequence>*          _itSeq;
+    PartiInfo<5>&                _pInfo;
+    SuperKmerBinFiles*           _superKstorage;
+};
+
+/********************************************************************************/
+template<size_t span>
+class SortingCountAlgorithm<span>::FillSolidKmersCommand : public ICommand, public system::SmartPointer
+{
+public:
+    FillSolidKmersCommand (SortingCountAlgorithm<span>& algo, size_t pass, PartiInfo<5>& pInfo, SuperKmerBinFiles* superKstorage, u_int64_t maxMemory)
+        : _algo(algo), _pass(pass), _pInfo(pInfo), _superKstorage(superKstorage), _maxMemory(maxMemory)  {}
+
+    void execute ()  {  _algo.fillSolidKmers (_pass, _pInfo, _superKstorage, _maxMemory);  }
+
+private:
+    SortingCountAlgorithm<span>& _algo;
+    size_t                       _pass;
+    PartiInfo<5>&                _pInfo;
+    SuperKmerBinFiles*           _superKstorage;
+    u_int64_t                    _maxMemory;
+};
+
+/********************************************************************************/
+template<size_t span>
+class SortingCountAlgorithm<span>::CountPartitionsCommand : public ICommand, public system::SmartPointer
+{
+public:
+    CountPartitionsCommand (SortingCountAlgorithm<span>& algo, CountProcessor* processor, size_t pass, PartiInfo<5>& pInfo,
+        SuperKmerBinFiles* superKstorage, u_int64_t maxMemory, PartitionScheduler& scheduler, ISynchronizer* synchro, u_int64_t meanKmers
+    )
+        : _algo(algo), _processor(processor), _pass(pass), _pInfo(pInfo), _superKstorage(superKstorage),
+          _maxMemory(maxMemory), _scheduler(scheduler), _synchro(synchro), _meanKmers(meanKmers)  {}
+
+    void execute ()
+    {
+        /** Each thread has its own memory pool, kept from one partition to the next one. */
+        MemAllocator pool (_algo._config._nbCores);
+        u_int64_t    poolSize = 0;
+        u_int64_t    held     = 0;
+
+        PartitionScheduler::Job job;
+
+        while (_scheduler.next (job, held))
+        {
+            if (held != poolSize)
+            {
+                pool.reserve (0);
+                if (held > 0)  {  pool.reserve (held);  }
+                poolSize = held;
+            }
+
+            /** We clone the prototype count processor instance for the current partition. */
+            CountProcessor* clone = 0;
+            {
+                LocalSynchronizer ls (_synchro);
+                clone = _processor->clone ();
+            }
+            LOCAL (clone);
+
+            /** We choose how to count the partition, a partition too large for being sorted being hashed. */
+            u_int64_t nbKmers    = _pInfo.getNbKmer (job.partition);
+            u_int64_t nbDistinct = _pInfo.getNbDistinctKmer (job.partition);
+
+            PartitionCostModel::Strategy strategy = job.exclusive ?
+                PartitionCostModel::HASH :
+                _algo._costModel->choose (nbKmers, nbDistinct, _meanKmers);
+
+            ICommand* cmd = createCommand (clone, job, strategy, nbDistinct, pool, _scheduler.getNbCores());
+            LOCAL (cmd);
+
+            ITime::Value t0 = System::time().getTimeStamp();
+            cmd->execute ();
+            ITime::Value t1 = System::time().getTimeStamp();
+
+            _algo._costModel->update (strategy, nbKmers, nbDistinct, t1-t0);
+
+            pool.free_all ();
+            _scheduler.done (job);
+
+            /** The clone has done its job; the prototype can gather its information. */
+            {
+                LocalSynchronizer ls (_synchro);
+                vector<CountProcessor*> clones (1, clone);
+                _processor->finishClones (clones);
+            }
+        }
+    }
+
+private:
+
+    ICommand* createCommand (CountProcessor* processorClone, const PartitionScheduler::Job& job, PartitionCostModel::Strategy strategy,
+        u_int64_t nbDistinct, MemAllocator& pool, size_t nbCores
+    )
+    {
+        SortingCountAlgorithm<span>& a = _algo;
+        size_t p = job.partition;
+
+        /** We need to cache the solid kmers partitions.
+         *  NOTE : it is important to save solid kmers by big chunks (ie cache size) in each partition.
+         *  Indeed, if we directly iterate the solid kmers through a Partition::iterator() object,
+         *  one partition is iterated after another one, which doesn't reflect the way they are in filesystem,
+         *  (ie by chunks of solid kmers) which may lead to many moves into the global HDF5 file.
+         *  One solution is to make sure that the written chunks of solid kmers are big enough: here
+         *  we accept to provide at most 2% of the memory of one thread, or chunks of 200.000 items.
+         */
+        u_int64_t mem = (_maxMemory*MBYTE) / a._config._nb_partitions_in_parallel;
+        size_t cacheSize = std::min ((u_int64_t)(200*1000), mem/(50*sizeof(Count)));
+
+        DEBUG (("SortingCountAlgorithm::CountPartitionsCommand:  parti %zu  (%llu MB)  cores %zu  %s\n",
+            p, job.memory/MBYTE, nbCores, PartitionCostModel::toString(strategy)
+        ));
+
+        /** Note that the kmers are counted as read (ie. strand specific) for the 'both' orientation. */
+        bool canonical = a._config._orientation == KMER_ORIENTATION_CANONICAL;
+
+        if (strategy == PartitionCostModel::HASH)
+        {
+            /** A partition counted alone gets all the memory; otherwise the hash table is sized from the
+             * distinct kmers, within the memory granted by the scheduler (it spills to disk if too small). */
+            u_int64_t hashMemory = _maxMemory*MBYTE;
+            if (!job.exclusive)
+            {
+                u_int64_t needed = std::max (nbDistinct * (sizeof(Type) + 8) * 5 / 4, (u_int64_t)MBYTE);
+                hashMemory = std::min (hashMemory, std::min (needed, std::max (job.memory, (u_int64_t)MBYTE)));
+            }
+
+            return new PartitionsByHashCommand<span>   (
+                processorClone, cacheSize, a._progress, a._fillTimeInfo,
+                _pInfo, _pass, p, nbCores, a._config._kmerSize, pool, hashMemory, _superKstorage, canonical
+            );
+        }
+
+        /** Recall that we got the following matrix in _nbKmersPerPartitionPerBank
+         *
+         *           part0  part1  part2 ... partJ
+         *   bank0    xxx    xxx    xxx       xxx
+         *   bank1    xxx    xxx    xxx       xxx
+         *    ...
+         *   bankI    xxx    xxx    xxx       xxx
+         *
+         *   Now, for the current partition p, we want the number of items found for each bank.
+         *
+         *              bank0   bank1   ...   bankI
+         *   offsets :   xxx     xxx           xxx
+         */
+        vector<size_t> nbItemsPerBankPerPart;
+        if (a._config._solidityKind != KMER_SOLIDITY_SUM)
+        {
+            for (size_t i=0; i<a._nbKmersPerPartitionPerBank.size(); i++)
+            {
+                nbItemsPerBankPerPart.push_back (a._nbKmersPerPartitionPerBank[i][p] - (i==0 ? 0 : a._nbKmersPerPartitionPerBank[i-1][p]) );
+            }
+        }
+
+        if (a._config._solidityKind == KMER_SOLIDITY_SUM)
+        {
+            return new PartitionsByVectorCommand<span> (
+                processorClone, cacheSize, a._progress, a._fillTimeInfo,
+                _pInfo, _pass, p, nbCores, a._config._kmerSize, pool, nbItemsPerBankPerPart, _superKstorage, canonical
+            );
+        }
+        else
+        {
+            return new PartitionsByVectorCommand_multibank<span> (
+                (*a._tmpPartitions)[p], processorClone, cacheSize, a._progress, a._fillTimeInfo,
+                _pInfo, _pass, p, nbCores, a._config._kmerSize, pool, nbItemsPerBankPerPart, canonical
+            );
+        }
+    }
+
+    SortingCountAlgorithm<span>& _algo;
+    CountProcessor*              _processor;
+    size_t                       _pass;
+    PartiInfo<5>&                _pInfo;
+    SuperKmerBinFiles*           _superKstorage;
+    u_int64_t                    _maxMemory;
+    PartitionScheduler&          _scheduler;
+    ISynchronizer*               _synchro;
+    u_int64_t                    _meanKmers;
+};
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+template<size_t span>
+SuperKmerBinFiles* SortingCountAlgorithm<span>::createSuperKmerStorage (size_t pass, u_int64_t maxMemory)
+{
+    /** We build the temporary storage name from the output storage name. Note that we suffix it with
+     * the pass number since the files of two consecutive passes may live at the same time. */
+    _tmpStorageName_superK = getInput()->getStr(STR_URI_OUTPUT_TMP) + "/"
+        + System::file().getTemporaryFilename("superK_partitions") + Stringify::format ("_pass%d", pass);
+
+    bool compress = getInput()->get(STR_SUPERK_COMPRESS) && getInput()->getInt(STR_SUPERK_COMPRESS)!=0;
+
+    return new SuperKmerBinFiles (_tmpStorageName_superK, "superKparts", _config._nb_partitions, compress, maxMemory*MBYTE);
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS : the superkmers kept in memory are alive while counting, so we give them
+**           at most half of the memory left by the partition caches.
+*********************************************************************/
+template<size_t span>
+u_int64_t SortingCountAlgorithm<span>::getSuperKmerMemory () const
+{
+    if (_config._solidityKind != KMER_SOLIDITY_SUM)  { return 0; }
+
+    IProperties* input = const_cast<SortingCountAlgorithm<span>*>(this)->getInput();
+    if (input->get(STR_SUPERK_IN_MEMORY)==0 || input->getInt(STR_SUPERK_IN_MEMORY)==0)  { return 0; }
+
+    u_int64_t fillMemory = getFillMemory();
+    if (fillMemory >= _config._max_memory)  { return 0; }
+
+    return (_config._max_memory - fillMemory) / 2;
+}
+
 /*********************************************************************
 ** METHOD  :
 ** PURPOSE :
@@ -1076,7 +1458,148 @@ private:
 ** REMARKS :
 *********************************************************************/
 template<size_t span>
-void SortingCountAlgorithm<span>::fillPartitions (size_t pass, Iterator<Sequence>* itSeq, PartiInfo<5>& pInfo)
+u_int64_t SortingCountAlgorithm<span>::getFillMemory () const
+{
+    /** Same computation as in ConfigurationAlgorithm for the partition caches. */
+    u_int64_t memoryUsageCachedItems = 1LL * _config._nb_cached_items_per_core_per_part * _config._nb_partitions * _config._nbCores * sizeof(Type);
+
+    return memoryUsageCachedItems / MBYTE + 1;
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+template<size_t span>
+bool SortingCountAlgorithm<span>::canPipelinePasses () const
+{
+    /** Only the superkmers storage (ie. 'sum' solidity) has one distinct set of files per pass. */
+    if (_config._solidityKind != KMER_SOLIDITY_SUM || _config._nb_passes <= 1)  { return false; }
+
+    IProperties* input = const_cast<SortingCountAlgorithm<span>*>(this)->getInput();
+    if (input->get(STR_PIPELINE_PASSES)==0 || input->getInt(STR_PIPELINE_PASSES)==0)  { return false; }
+
+    /** The partition files of two passes are on disk at the same time. */
+    u_int64_t volumePerPass = (_config._volume/4) / _config._nb_passes + 1;
+    if (2*volumePerPass > _config._max_disk_space)  { return false; }
+
+    /** The partition caches of pass N+1 take some memory while pass N is counted;
+     * we want to keep at least half of the memory for counting. */
+    if (2*getFillMemory() > _config._max_memory)  { return false; }
+
+    return true;
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+template<size_t span>
+void SortingCountAlgorithm<span>::executeSequential (Iterator<Sequence>* itSeq, PartiInfo<5>& pInfo)
+{
+    for (size_t current_pass=0; current_pass < _config._nb_passes; current_pass++)
+    {
+        DEBUG (("SortingCountAlgorithm<span>::execute  pass [%ld,%d] \n", current_pass+1, _config._nb_passes));
+
+        pInfo.clear();
+
+        if (_config._solidityKind == KMER_SOLIDITY_SUM)
+        {
+            /** We get rid of the superkmers files of the previous pass. */
+            if (_superKstorage != 0)  {  delete _superKstorage;  _superKstorage = 0;  }
+
+            _superKstorage = createSuperKmerStorage (current_pass, getSuperKmerMemory());
+        }
+
+        /** 1) We fill the partition files. */
+        fillPartitions (current_pass, itSeq, pInfo, _superKstorage);
+
+        /** The superkmers kept in memory are not available for counting. */
+        u_int64_t countMemory = _config._max_memory;
+        if (_superKstorage != 0)  {  countMemory -= _superKstorage->getMemoryUsage() / MBYTE;  }
+
+        /** 2) We fill the kmers solid file from the partition files. */
+        fillSolidKmers (current_pass, pInfo, _superKstorage, countMemory);
+    }
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS : the partitioning of pass N+1 and the counting of pass N are run
+**           in two threads, each one using the main dispatcher for its own job.
+*********************************************************************/
+template<size_t span>
+void SortingCountAlgorithm<span>::executePipelined (Iterator<Sequence>* itSeq, PartiInfo<5>& pInfo)
+{
+    /** We use two slots for the partitions information and the superkmers files: one for the pass
+     * being counted and one for the pass being partitioned. */
+    PartiInfo<5>       pInfoOdd (_config._nb_partitions, _config._minim_size);
+    PartiInfo<5>*      infos[2]    = { &pInfo, &pInfoOdd };
+    SuperKmerBinFiles* storages[2] = { 0, 0 };
+
+    /** The partition caches are alive while counting, so the counting step has less memory. */
+    u_int64_t countMemory = _config._max_memory - getFillMemory();
+
+    DEBUG (("SortingCountAlgorithm<span>::executePipelined  nb_passes=%d  countMemory=%lld MB\n", _config._nb_passes, countMemory));
+
+    /** The first pass can't be overlapped with anything. */
+    infos[0]->clear();
+    storages[0] = createSuperKmerStorage (0);
+    fillPartitions (0, itSeq, *infos[0], storages[0]);
+
+    for (size_t current_pass=0; current_pass < _config._nb_passes; current_pass++)
+    {
+        DEBUG (("SortingCountAlgorithm<span>::execute  pass [%ld,%d] \n", current_pass+1, _config._nb_passes));
+
+        size_t current = current_pass % 2;
+        size_t next    = 1 - current;
+        bool   hasNext = current_pass+1 < _config._nb_passes;
+
+        vector<ICommand*> cmds;
+        cmds.push_back (new FillSolidKmersCommand (*this, current_pass, *infos[current], storages[current], countMemory));
+
+        if (hasNext)
+        {
+            infos[next]->clear();
+            storages[next] = createSuperKmerStorage (current_pass+1);
+            cmds.push_back (new FillPartitionsCommand (*this, current_pass+1, itSeq, *infos[next], storages[next]));
+        }
+
+        Dispatcher(cmds.size()).dispatchCommands (cmds, 0);
+
+        /** The superkmers files of the last pass are kept for the statistics. */
+        if (hasNext)  {  delete storages[current];  storages[current] = 0;  }
+    }
+
+    _superKstorage = storages[(_config._nb_passes-1) % 2];
+
+    /** The totals of a PartiInfo are not reset by 'clear', so each slot holds the totals of its own
+     * passes; we gather them into the provided instance. */
+    pInfo += pInfoOdd;
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+template<size_t span>
+void SortingCountAlgorithm<span>::fillPartitions (size_t pass, Iterator<Sequence>* itSeq, PartiInfo<5>& pInfo, SuperKmerBinFiles* superKstorage)
 	{
 		TIME_INFO (getTimeInfo(), "fill_partitions");
 		
@@ -1095,21 +1618,6 @@ void SortingCountAlgorithm<span>::fillPartitions (size_t pass, Iterator<Sequence
 			setPartitions        (0); // close the partitions first, otherwise new files are opened before  closing parti from previous pass
 			setPartitions        ( & (*_tmpPartitionsStorage)().getPartition<Type> ("parts", _config._nb_partitions));
 			
-		}
-		else
-		{
-			/** We build the temporary storage name from the output storage name. */
-			_tmpStorageName_superK = getInput()->getStr(STR_URI_OUTPUT_TMP) + "/" + System::file().getTemporaryFilename("superK_partitions");
-			
-			
-			if(_superKstorage!=0)
-			{
-				delete _superKstorage;
-				_superKstorage =0;
-			}
-			
-			_superKstorage = new SuperKmerBinFiles(_tmpStorageName_superK,"superKparts", _config._nb_partitions) ;
-			
 		}
 		/** We update the message of the progress bar. */
 		_progress->setMessage (Stringify::format(progressFormat1, pass+1, _config._nb_passes));
@@ -1153,13 +1661,15 @@ void SortingCountAlgorithm<span>::fillPartitions (size_t pass, Iterator<Sequence
 			if(_config._solidityKind == KMER_SOLIDITY_SUM)
 			{
 				getDispatcher()->iterate (itBanks[i], FillPartitions<span,true> (
-																			model, _config._nb_passes, pass, _config._nb_partitions, _config._nb_cached_items_per_core_per_part, _progress, _bankStats, _tmpPartitions, *_repartitor, pInfo,_superKstorage
+																			model, _config._nb_passes, pass, _config._nb_partitions, _config._nb_cached_items_per_core_per_part, _progress, _bankStats, _tmpPartitions, *_repartitor, pInfo,superKstorage,
+																			_config._orientation == KMER_ORIENTATION_CANONICAL
 																			), groupSize, deleteSynchro);
 			}
 			else
 			{
 				getDispatcher()->iterate (itBanks[i], FillPartitions<span,false> (
-																				 model, _config._nb_passes, pass, _config._nb_partitions, _config._nb_cached_items_per_core_per_part, _progress, _bankStats, _tmpPartitions, *_repartitor, pInfo,_superKstorage
+																				 model, _config._nb_passes, pass, _config._nb_partitions, _config._nb_cached_items_per_core_per_part, _progress, _bankStats, _tmpPartitions, *_repartitor, pInfo,superKstorage,
+																																																																																								 _config._orientation == KMER_ORIENTATION_CANONICAL
 																				 ), groupSize, deleteSynchro);
 			}
 			
@@ -1186,8 +1696,8 @@ void SortingCountAlgorithm<span>::fillPartitions (size_t pass, Iterator<Sequence
 		
 		if(_config._solidityKind == KMER_SOLIDITY_SUM)
 		{
-			_superKstorage->flushFiles();
-			_superKstorage->closeFiles();
+			superKstorage->flushFiles();
+			superKstorage->closeFiles();
 		}
 		
 		
@@ -1202,36 +1712,7 @@ void SortingCountAlgorithm<span>::fillPartitions (size_t pass, Iterator<Sequence
 ** REMARKS :
 *********************************************************************/
 template<size_t span>
-std::vector<size_t> SortingCountAlgorithm<span>::getNbCoresList (PartiInfo<5>& pInfo)
-{
-    std::vector<size_t> result;
-
-    for (size_t p=0; p<_config._nb_partitions; )
-    {
-        u_int64_t ram_total = 0;
-        size_t i=0;
-        for (i=0; i< _config._nb_partitions_in_parallel && p<_config._nb_partitions
-            && (ram_total ==0  || ((ram_total+(pInfo.getNbSuperKmer(p)*getSizeofPerItem()))  <= _config._max_memory*MBYTE)) ; i++, p++)
-        {
-            ram_total += pInfo.getNbSuperKmer(p)*getSizeofPerItem();
-        }
-
-        result.push_back (i);
-    }
-
-    return result;
-}
-
-/*********************************************************************
-** METHOD  :
-** PURPOSE :
-** INPUT   :
-** OUTPUT  :
-** RETURN  :
-** REMARKS :
-*********************************************************************/
-template<size_t span>
-void SortingCountAlgorithm<span>::fillSolidKmers (size_t pass, PartiInfo<5>& pInfo)
+void SortingCountAlgorithm<span>::fillSolidKmers (size_t pass, PartiInfo<5>& pInfo, SuperKmerBinFiles* superKstorage, u_int64_t maxMemory)
 {
     TIME_INFO (getTimeInfo(), "fill_solid_kmers");
 
@@ -1240,7 +1721,7 @@ void SortingCountAlgorithm<span>::fillSolidKmers (size_t pass, PartiInfo<5>& pIn
         /** We notify the count processor about the start of the pass. */
         _processors[i]->beginPass (pass);
 
-        fillSolidKmers_aux (_processors[i], pass, pInfo);
+        fillSolidKmers_aux (_processors[i], pass, pInfo, superKstorage, maxMemory);
 
         /** We notify the count processor about the end of the pass. */
         _processors[i]->endPass (pass);
@@ -1256,198 +1737,82 @@ void SortingCountAlgorithm<span>::fillSolidKmers (size_t pass, PartiInfo<5>& pIn
 ** REMARKS :
 *********************************************************************/
 template<size_t span>
-void SortingCountAlgorithm<span>::fillSolidKmers_aux (ICountProcessor<span>* processor, size_t pass, PartiInfo<5>& pInfo)
+void SortingCountAlgorithm<span>::fillSolidKmers_aux (ICountProcessor<span>* processor, size_t pass, PartiInfo<5>& pInfo,
+    SuperKmerBinFiles* superKstorage, u_int64_t maxMemory
+)
 {
     DEBUG (("SortingCountAlgorithm<span>::fillSolidKmers\n"));
 
     /** We update the message of the progress bar. */
     _progress->setMessage (Stringify::format (progressFormat2, pass+1, _config._nb_passes));
 
+    /** The partitions are counted largest first by _nb_partitions_in_parallel threads, each thread taking
+     * a new partition as soon as it is idle and the memory allows it. */
+    PartitionScheduler scheduler (maxMemory*MBYTE, _config._nb_partitions_in_parallel, _config._nbCores);
 
-    /** We retrieve the list of cores number for dispatching N partitions in N threads.
-     *  We need to know these numbers for allocating the N maps according to the maximum allowed memory.
-     */
-    vector<size_t> coreList = getNbCoresList(pInfo); //uses _nb_partitions_in_parallel
-
-    /** We need a memory allocator. We give the cores number in order to compute an extra memory
-     * allocation for alignment constraints. */
-    MemAllocator pool (_config._nbCores);
-
-    size_t p = 0;
-    for (size_t i=0; i<coreList.size(); i++)
+    for (size_t p=0; p<_config._nb_partitions; p++)
     {
-        vector<ICommand*> cmds;
-
-        /** We use a vector to hold all the current CountProcessor clones. */
-        vector<CountProcessor*> clones;
-
-        size_t currentNbCores = coreList[i];
-        assert (currentNbCores > 0);
-
-        /** We correct the number of memory per map according to the max allowed memory.
-         * Note that _max_memory has initially been divided by the user provided cores number. */
-        u_int64_t mem = (_config._max_memory*MBYTE)/currentNbCores;
-
-        /** We need to cache the solid kmers partitions.
-         *  NOTE : it is important to save solid kmers by big chunks (ie cache size) in each partition.
-         *  Indeed, if we directly iterate the solid kmers through a Partition::iterator() object,
-         *  one partition is iterated after another one, which doesn't reflect the way they are in filesystem,
-         *  (ie by chunks of solid kmers) which may lead to many moves into the global HDF5 file.
-         *  One solution is to make sure that the written chunks of solid kmers are big enough: here
-         *  we accept to provide at most 2% of the max memory, or chunks of 200.000 items.
-         */
-        size_t cacheSize = std::min ((u_int64_t)(200*1000), mem/(50*sizeof(Count)));
+        /* Get the memory taken by this partition if loaded for sorting */
+        uint64_t memoryPartition = (pInfo.getNbSuperKmer(p)*getSizeofPerItem()); //in bytes
 
-        DEBUG (("SortingCountAlgorithm::fillSolidKmers:  mem=%d  computing %zu partitions simultaneously , parti : ",
-            mem/MBYTE, currentNbCores
-        ));
-
-        /** We build a list of 'currentNbCores' commands to be dispatched each one in one thread. */
-        for (size_t j=0; j<currentNbCores; j++, p++)
+        /** A partition too large for being sorted is counted by hashing, using all the memory. */
+        if (memoryPartition > maxMemory*MBYTE && !isVectorForced())
         {
-            ISynchronizer* synchro = System::thread().newSynchronizer();
-            LOCAL (synchro);
-
-            /** We clone the prototype count processor instance for the current 'p' kmers partition. */
-            CountProcessor* processorClone = processor->clone ();
-
-            /** We use and put the clone into a vector. */
-            processorClone->use();
-            clones.push_back (processorClone);
-
-            DEBUG ((" %zu ", p));
-
-            /* Get the memory taken by this partition if loaded for sorting */
-            uint64_t memoryPartition = (pInfo.getNbSuperKmer(p)*getSizeofPerItem()); //in bytes
-            DEBUG (("  (%llu  MB) ",memoryPartition/MBYTE));
-
-            /** If we have several input banks, we may have to compute kmer solidity for each bank, which
-             * can be currently done only with sorted vector. */
-            bool forceVector  = _nbKmersPerPartitionPerBank.size() > 1 && \
-                                ( _config._solidityKind != KMER_SOLIDITY_SUM);
-
-            ICommand* cmd = 0;
-
-            //still use hash if by vector would be too large even with single part at a time
-			//I thought it was not possible to have memoryPartition > _max_memory  && currentNbCores>1 , but inf fact it is possible when
-			// some partitions are of size 0 (see getNbCoresList)
-			if ( ((memoryPartition > mem && currentNbCores==1) || ( memoryPartition > (_config._max_memory*MBYTE) ) )  && !forceVector)
-            {
-                if (pool.getCapacity() != 0)  {  pool.reserve(0);  }
+            scheduler.add (p, maxMemory*MBYTE, true);
+            continue;
+        }
 
+        /** In case of forcing sorted vector (multiple banks counting for instance), we may have a
+         * partition bigger than the max memory; the scheduler will then count it alone. */
+        if (isVectorForced()  &&  memoryPartition >= maxMemory*MBYTE)
+        {
+            static const int EXCEED_FACTOR = 2;
 
-					cmd = new PartitionsByHashCommand<span>   (
-															   processorClone, cacheSize, _progress, _fillTimeInfo,
-															   pInfo, pass, p, _config._nbCores_per_partition, _config._kmerSize, pool, mem,_superKstorage
-															   );
-            }
-            else
+            /** We accept to exceed the allowed memory up to some factor, or to the system memory. */
+            if (memoryPartition >= EXCEED_FACTOR*maxMemory*MBYTE)
             {
-                u_int64_t memoryPoolSize = _config._max_memory*MBYTE;
-
-                /** In case of forcing sorted vector (multiple banks counting for instance), we may have a
-                 * partition bigger than the max memory. */
-                if (forceVector  &&  memoryPartition >= memoryPoolSize)
-                {
-                    static const int EXCEED_FACTOR = 2;
-
-                    if (memoryPartition  < EXCEED_FACTOR*memoryPoolSize)
-                    {						
-                        /** We accept in this case to exceed the allowed memory. */
-                        memoryPoolSize = memoryPartition;
-                    }
-                    else
-                    {
-                        bool strict = false;
-
-                        if (strict)
-                        {
-                            /** We launch an exception. */
-                            throw Exception ("memory issue: %lld bytes required and %lld bytes available",
-                                memoryPartition, memoryPoolSize
-                            );
-                        }
-                        else
-                        {
-                            unsigned long system_mem = System::info().getMemoryPhysicalTotal();
-                            memoryPoolSize = memoryPartition; 
-
-                            if (memoryPoolSize > system_mem*0.95)
-                            {
-                                throw Exception ("memory issue: %lld bytes required, %lld bytes set by command-line limit, %lld bytes in system memory",
-                                    memoryPartition, memoryPoolSize, system_mem
-                                );
-                            }
-                            else
-                                cout << "Warning: memory was initially restricted to " << _config._max_memory << " MB, but we actually need to allocate " << memoryPoolSize / MBYTE << " MB due to a partition with " << pInfo.getNbSuperKmer(p) << " superkmers." << endl;
-                        }
-                    }
-                }
+                unsigned long system_mem = System::info().getMemoryPhysicalTotal();
 
-               //if capa pool ==0, reserve max memo , pass pool to partibyvec, will be used  for vec kmers
-                if (pool.getCapacity() == 0)  {  pool.reserve (memoryPoolSize); }
-				else if (memoryPoolSize > pool.getCapacity()) { pool.reserve(0); pool.reserve (memoryPoolSize); }
-
-                /** Recall that we got the following matrix in _nbKmersPerPartitionPerBank
-                 *
-                 *           part0  part1  part2 ... partJ
-                 *   bank0    xxx    xxx    xxx       xxx
-                 *   bank1    xxx    xxx    xxx       xxx
-                 *    ...
-                 *   bankI    xxx    xxx    xxx       xxx
-                 *
-                 *   Now, for the current partition p, we want the number of items found for each bank.
-                 *
-                 *              bank0   bank1   ...   bankI
-                 *   offsets :   xxx     xxx           xxx
-                 */
-                vector<size_t> nbItemsPerBankPerPart;
-                if ( _config._solidityKind != KMER_SOLIDITY_SUM)
+                if (memoryPartition > system_mem*0.95)
                 {
-                    for (size_t i=0; i<_nbKmersPerPartitionPerBank.size(); i++)
-                    {
-                        nbItemsPerBankPerPart.push_back (_nbKmersPerPartitionPerBank[i][p] - (i==0 ? 0 : _nbKmersPerPartitionPerBank[i-1][p]) );
-                    }
+                    throw Exception ("memory issue: %lld bytes required, %lld bytes set by command-line limit, %lld bytes in system memory",
+                        memoryPartition, maxMemory*MBYTE, system_mem
+                    );
                 }
+                else
+                    cout << "Warning: memory was initially restricted to " << maxMemory << " MB, but we actually need to allocate " << memoryPartition / MBYTE << " MB due to a partition with " << pInfo.getNbSuperKmer(p) << " superkmers." << endl;
+            }
+        }
 
-				if ( _config._solidityKind == KMER_SOLIDITY_SUM)
-				{
-					cmd = new PartitionsByVectorCommand<span> (
-															   processorClone, cacheSize, _progress, _fillTimeInfo,
-															   pInfo, pass, p, _config._nbCores_per_partition, _config._kmerSize, pool, nbItemsPerBankPerPart,_superKstorage
-															   );
-				}
-				else
-				{
-					cmd = new PartitionsByVectorCommand_multibank<span> (
-															   (*_tmpPartitions)[p], processorClone, cacheSize, _progress, _fillTimeInfo,
-															   pInfo, pass, p, _config._nbCores_per_partition, _config._kmerSize, pool, nbItemsPerBankPerPart
-															   );
-				}
+        scheduler.add (p, memoryPartition);
+    }
 
-            }
+    scheduler.start ();
 
-            cmds.push_back (cmd);
+    /** The prototype count processor is shared by the threads for cloning and gathering the clones. */
+    ISynchronizer* synchro = System::thread().newSynchronizer();
+    LOCAL (synchro);
 
-        } /* end of for (size_t j=0; j<currentNbCores... */
+    /** The mean partition size is used by the cost model for choosing the partitions to be timed. */
+    u_int64_t nbKmersPass = 0;
+    for (size_t p=0; p<_config._nb_partitions; p++)  {  nbKmersPass += pInfo.getNbKmer(p);  }
+    u_int64_t meanKmers = nbKmersPass / std::max (_config._nb_partitions, (u_int32_t)1);
 
-        DEBUG (("\n"));
+    vector<ICommand*> cmds;
+    for (size_t i=0; i<_config._nb_partitions_in_parallel; i++)
+    {
+        cmds.push_back (new CountPartitionsCommand (*this, processor, pass, pInfo, superKstorage, maxMemory, scheduler, synchro, meanKmers));
+    }
 
-        /** We launch the commands through a dispatcher. */
-        getDispatcher()->dispatchCommands (cmds, 0);
+    /** We launch the commands through a dispatcher. */
+    getDispatcher()->dispatchCommands (cmds, 0);
 
-        /** The N CountProcessor clones should have done their job during the 'dispatchCommands'
-         * We can send a notification about it and get rid of them. */
-        processor->finishClones (clones);
-        for (size_t i=0; i<clones.size(); i++)  { clones[i]->forget(); }  clones.clear();
+    DEBUG (("SortingCountAlgorithm<span>::fillSolidKmers  memory peak %lld MB, %d waits for memory\n",
+        scheduler.getMemoryPeak()/MBYTE, scheduler.getNbWaits()
+    ));
 
-        // free internal memory of pool here
-        pool.free_all();
-    }
-	
-	
 	if(_config._solidityKind == KMER_SOLIDITY_SUM)
-		_superKstorage->closeFiles();
+		superKstorage->closeFiles();
 
 }
 
@@ -31,10 +31,12 @@
 #include <gatb/tools/misc/impl/Algorithm.hpp>
 #include <gatb/bank/api/IBank.hpp>
 #include <gatb/kmer/api/ICountProcessor.hpp>
+#include <gatb/kmer/api/IPartitionListener.hpp>
 #include <gatb/kmer/impl/Model.hpp>
 #include <gatb/kmer/impl/BankKmers.hpp>
 #include <gatb/kmer/impl/Configuration.hpp>
 #include <gatb/kmer/impl/PartiInfo.hpp>
+#include <gatb/kmer/impl/PartitionCostModel.hpp>
 #include <gatb/tools/storage/impl/Storage.hpp>
 #include <string>
 
@@ -128,25 +130,29 @@ public:
      * \param[in] params : used for configuring the processor
      * \param[in] dskStorage : storage for dumping [kmer,count] couples
      * \param[in] otherStorage : used for histogram for instance
+     * \param[in] listeners : consumers of the solid kmers, fed partition by partition during the counting
      * \return a CountProcessor instance
      */
     static CountProcessor* getDefaultProcessor (
         tools::misc::IProperties*       params,
         tools::storage::impl::Storage*  dskStorage,
-        tools::storage::impl::Storage*  otherStorage = 0
+        tools::storage::impl::Storage*  otherStorage = 0,
+        const std::vector<IPartitionListener<span>*>& listeners = std::vector<IPartitionListener<span>*>()
     );
 
     /** Creates a vector holding the default CountProcessor configuration
      * \param[in] params : used for configuring the processor
      * \param[in] dskStorage : storage for dumping [kmer,count] couples
      * \param[in] otherStorage : used for histogram for instance
+     * \param[in] listeners : consumers of the solid kmers, fed partition by partition during the counting
      * \return a vector of CountProcessor instances
      */
     static std::vector<ICountProcessor<span>*> getDefaultProcessorVector (
         Configuration&                  config,
         tools::misc::IProperties*       params,
         tools::storage::impl::Storage*  dskStorage,
-        tools::storage::impl::Storage*  otherStorage = 0
+        tools::storage::impl::Storage*  otherStorage = 0,
+        const std::vector<IPartitionListener<span>*>& listeners = std::vector<IPartitionListener<span>*>()
     );
 
     /** Process the kmers counting. It is mainly composed of a loop over the passes, and for each pass :
@@ -170,6 +176,12 @@ public:
      */
     void addProcessor (CountProcessor* processor)  { processor->use(); _processors.push_back (processor); }
 
+    /** Register a consumer of the solid kmers, which receives each partition as soon as it is counted.
+     * Note that the listeners are used only by the default count processor, ie. when no processor
+     * has been provided to the algorithm.
+     * \param[in] listener : the consumer to be registered. */
+    void addListener (IPartitionListener<span>* listener)  { listener->use(); _listeners.push_back (listener); }
+
     /** Get the iterable over the computed solid kmers.
      * \return the solid kmers iterable. */
     tools::storage::impl::Partition<Count>* getSolidCounts ();
@@ -199,21 +211,58 @@ private:
     /** Fill partition files (for a given pass) from a sequence iterator.
      * \param[in] pass  : current pass whose value is used for choosing the partition file
      * \param[in] itSeq : sequences iterator whose sequence are cut into kmers to be split.
+     * \param[in] pInfo : statistics about the partitions of the pass
+     * \param[in] superKstorage : superkmers files of the pass (only used with the 'sum' solidity kind)
      */
-    void fillPartitions (size_t pass, gatb::core::tools::dp::Iterator<gatb::core::bank::Sequence>* itSeq, PartiInfo<5>& pInfo);
+    void fillPartitions (size_t pass, gatb::core::tools::dp::Iterator<gatb::core::bank::Sequence>* itSeq, PartiInfo<5>& pInfo,
+        tools::storage::impl::SuperKmerBinFiles* superKstorage);
 
     /** Fill the solid kmers bag from the partition files (one partition after another one).
-     * \param[in] solidKmers : bag to put the solid kmers into.
+     * \param[in] pass  : current pass
+     * \param[in] pInfo : statistics about the partitions of the pass
+     * \param[in] superKstorage : superkmers files of the pass (only used with the 'sum' solidity kind)
+     * \param[in] maxMemory : memory (in MBytes) available for counting the partitions
      */
-    void fillSolidKmers (size_t pass, PartiInfo<5>& pInfo);
+    void fillSolidKmers (size_t pass, PartiInfo<5>& pInfo, tools::storage::impl::SuperKmerBinFiles* superKstorage, u_int64_t maxMemory);
 
     /** Fill the solid kmers bag from the partition files (one partition after another one).
-     * \param[in] solidKmers : bag to put the solid kmers into.
+     * \param[in] processor : count processor fed with the counted kmers
      */
-    void fillSolidKmers_aux (ICountProcessor<span>* processor, size_t pass, PartiInfo<5>& pInfo);
+    void fillSolidKmers_aux (ICountProcessor<span>* processor, size_t pass, PartiInfo<5>& pInfo,
+        tools::storage::impl::SuperKmerBinFiles* superKstorage, u_int64_t maxMemory);
+
+    /** Create the superkmers files used by the given pass.
+     * \param[in] pass : current pass
+     * \param[in] maxMemory : memory (in MBytes) for keeping superkmers in memory instead of files (0 for none)
+     * \return the superkmers files, opened for writing. */
+    tools::storage::impl::SuperKmerBinFiles* createSuperKmerStorage (size_t pass, u_int64_t maxMemory=0);
+
+    /** Tells whether the partitioning of pass N+1 can be done while the partitions of pass N are counted.
+     * Both passes must fit into the allowed disk space, and the partition caches must leave some memory
+     * for counting.
+     * \return true if the passes can be pipelined. */
+    bool canPipelinePasses () const;
+
+    /** Get the memory (in MBytes) used by the partition caches during the partitioning step.
+     * \return the memory size. */
+    u_int64_t getFillMemory () const;
+
+    /** Get the memory (in MBytes) for keeping the superkmers in memory (see STR_SUPERK_IN_MEMORY).
+     * \return the memory size, 0 if the superkmers go to disk. */
+    u_int64_t getSuperKmerMemory () const;
+
+    /** Main loop over the passes, one pass after another one. */
+    void executeSequential (gatb::core::tools::dp::Iterator<gatb::core::bank::Sequence>* itSeq, PartiInfo<5>& pInfo);
 
-    /** */
-    std::vector <size_t> getNbCoresList (PartiInfo<5>& pInfo);
+    /** Main loop over the passes where the partitioning of pass N+1 overlaps the counting of pass N. */
+    void executePipelined  (gatb::core::tools::dp::Iterator<gatb::core::bank::Sequence>* itSeq, PartiInfo<5>& pInfo);
+
+    /** Commands used for running the two steps of a pass concurrently (see executePipelined). */
+    class FillPartitionsCommand;
+    class FillSolidKmersCommand;
+
+    /** Command run by each counting thread, taking its partitions from a PartitionScheduler. */
+    class CountPartitionsCommand;
 
     /** Handle on the configuration information. */
     kmer::impl::Configuration _config;
@@ -229,6 +278,12 @@ private:
     /** Handle on the count processor object. */
     std::vector<CountProcessor*> _processors;
 
+    std::vector<IPartitionListener<span>*> _listeners;
+
+    /** Choice of the counting strategy (hash or sort) of each partition. */
+    PartitionCostModel* _costModel;
+    void setCostModel (PartitionCostModel* costModel)  { if (_costModel != costModel)  { delete _costModel;  _costModel = costModel; } }
+
 	
     /** Handle on the progress information. */
     gatb::core::tools::dp::IteratorListener* _progress;
@@ -244,6 +299,10 @@ private:
 
     /** Get the memory size (in bytes) to be used by each item.
      * IMPORTANT : we may have to count both the size of Type and the size for the bank id. */
+    /** If we have several input banks, we may have to compute kmer solidity for each bank, which
+     * can be currently done only with sorted vector. */
+    bool isVectorForced () const { return _config._solidityKind != tools::misc::KMER_SOLIDITY_SUM && _nbKmersPerPartitionPerBank.size() > 1; }
+
     int getSizeofPerItem () const { return Type::getSize()/8 + ((_nbKmersPerPartitionPerBank.size()>1 && _config._solidityKind != tools::misc::KMER_SOLIDITY_SUM) ? sizeof(bank::BankIdType) : 0); }
 
     tools::misc::impl::TimeInfo _fillTimeInfo;
@@ -255,6 +314,10 @@ private:
     tools::storage::impl::StorageMode_e _storage_type;
     tools::storage::impl::Storage* _storage;
     void setStorage (tools::storage::impl::Storage* storage)  { SP_SETATTR(storage); }
+
+    /** Output of a previous run, for an incremental counting. */
+    tools::storage::impl::Storage* _previousStorage;
+    void setPreviousStorage (tools::storage::impl::Storage* previousStorage)  { SP_SETATTR(previousStorage); }
 	
 	
 	//superkmer efficient storage
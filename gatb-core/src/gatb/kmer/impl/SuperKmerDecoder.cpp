@@ -0,0 +1,266 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <gatb/kmer/impl/SuperKmerDecoder.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define GATB_DECODER_X86 1
+    #include <immintrin.h>
+#endif
+
+/********************************************************************************/
+namespace gatb  {  namespace core  {   namespace kmer  {   namespace impl {
+/********************************************************************************/
+
+/** Recall that the complement of a nucleotide (A=0, C=1, T=2, G=3) is obtained with a XOR 2. */
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+static void unpack_scalar (const u_int8_t* packed, size_t nbNt, u_int8_t* forward, u_int8_t* complement)
+{
+    for (size_t i=0; i<nbNt; i++)
+    {
+        u_int8_t nt = (packed[i>>2] >> (2*(i&3))) & 3;
+        forward   [i] = nt;
+        complement[i] = nt ^ 2;
+    }
+}
+
+#ifdef GATB_DECODER_X86
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS : each packed byte is first replicated 4 times with a shuffle, then the i-th copy
+**           is shifted by 2*i bits. Since there is no 8 bits shift, we use 16 bits shifts
+**           and keep only the 2 less significant bits of each byte.
+*********************************************************************/
+__attribute__((target("sse4.2")))
+static void unpack_sse (const u_int8_t* packed, size_t nbNt, u_int8_t* forward, u_int8_t* complement)
+{
+    const __m128i m0   = _mm_set1_epi32 (0x00000003);
+    const __m128i m1   = _mm_set1_epi32 (0x00000300);
+    const __m128i m2   = _mm_set1_epi32 (0x00030000);
+    const __m128i m3   = _mm_set1_epi32 (0x03000000);
+    const __m128i comp = _mm_set1_epi8  (2);
+
+    const __m128i shuffle[4] =
+    {
+        _mm_setr_epi8 ( 0, 0, 0, 0,  1, 1, 1, 1,  2, 2, 2, 2,  3, 3, 3, 3),
+        _mm_setr_epi8 ( 4, 4, 4, 4,  5, 5, 5, 5,  6, 6, 6, 6,  7, 7, 7, 7),
+        _mm_setr_epi8 ( 8, 8, 8, 8,  9, 9, 9, 9, 10,10,10,10, 11,11,11,11),
+        _mm_setr_epi8 (12,12,12,12, 13,13,13,13, 14,14,14,14, 15,15,15,15)
+    };
+
+    /** 16 packed bytes give 64 nucleotides. */
+    size_t nbBlocks = nbNt / 64;
+
+    for (size_t b=0; b<nbBlocks; b++)
+    {
+        __m128i in = _mm_loadu_si128 ((const __m128i*) (packed + 16*b));
+
+        for (size_t c=0; c<4; c++)
+        {
+            __m128i rep = _mm_shuffle_epi8 (in, shuffle[c]);
+
+            __m128i nt = _mm_or_si128 (
+                _mm_or_si128 (_mm_and_si128 (rep, m0),                     _mm_and_si128 (_mm_srli_epi16 (rep, 2), m1)),
+                _mm_or_si128 (_mm_and_si128 (_mm_srli_epi16 (rep, 4), m2), _mm_and_si128 (_mm_srli_epi16 (rep, 6), m3))
+            );
+
+            _mm_storeu_si128 ((__m128i*) (forward    + 64*b + 16*c), nt);
+            _mm_storeu_si128 ((__m128i*) (complement + 64*b + 16*c), _mm_xor_si128 (nt, comp));
+        }
+    }
+
+    /** The remaining nucleotides. */
+    size_t done = 64*nbBlocks;
+    unpack_scalar (packed + done/4, nbNt - done, forward + done, complement + done);
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS : same as the SSE version, with 32 nucleotides per shuffle. Note that the AVX2
+**           shuffle works inside each 128 bits lane, so the 16 packed bytes are broadcast
+**           in both lanes.
+*********************************************************************/
+__attribute__((target("avx2")))
+static void unpack_avx2 (const u_int8_t* packed, size_t nbNt, u_int8_t* forward, u_int8_t* complement)
+{
+    const __m256i m0   = _mm256_set1_epi32 (0x00000003);
+    const __m256i m1   = _mm256_set1_epi32 (0x00000300);
+    const __m256i m2   = _mm256_set1_epi32 (0x00030000);
+    const __m256i m3   = _mm256_set1_epi32 (0x03000000);
+    const __m256i comp = _mm256_set1_epi8  (2);
+
+    const __m256i shuffle[2] =
+    {
+        _mm256_setr_epi8 ( 0, 0, 0, 0,  1, 1, 1, 1,  2, 2, 2, 2,  3, 3, 3, 3,
+                           4, 4, 4, 4,  5, 5, 5, 5,  6, 6, 6, 6,  7, 7, 7, 7),
+        _mm256_setr_epi8 ( 8, 8, 8, 8,  9, 9, 9, 9, 10,10,10,10, 11,11,11,11,
+                          12,12,12,12, 13,13,13,13, 14,14,14,14, 15,15,15,15)
+    };
+
+    /** 16 packed bytes give 64 nucleotides. */
+    size_t nbBlocks = nbNt / 64;
+
+    for (size_t b=0; b<nbBlocks; b++)
+    {
+        __m256i in = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i*) (packed + 16*b)));
+
+        for (size_t c=0; c<2; c++)
+        {
+            __m256i rep = _mm256_shuffle_epi8 (in, shuffle[c]);
+
+            __m256i nt = _mm256_or_si256 (
+                _mm256_or_si256 (_mm256_and_si256 (rep, m0),                        _mm256_and_si256 (_mm256_srli_epi16 (rep, 2), m1)),
+                _mm256_or_si256 (_mm256_and_si256 (_mm256_srli_epi16 (rep, 4), m2), _mm256_and_si256 (_mm256_srli_epi16 (rep, 6), m3))
+            );
+
+            _mm256_storeu_si256 ((__m256i*) (forward    + 64*b + 32*c), nt);
+            _mm256_storeu_si256 ((__m256i*) (complement + 64*b + 32*c), _mm256_xor_si256 (nt, comp));
+        }
+    }
+
+    /** The remaining nucleotides. */
+    size_t done = 64*nbBlocks;
+    unpack_scalar (packed + done/4, nbNt - done, forward + done, complement + done);
+}
+
+#endif /* GATB_DECODER_X86 */
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+bool SuperKmerDecoder::isSupported (Implementation impl)
+{
+#ifdef GATB_DECODER_X86
+    /** We may be called during static initialization, before the CPU information is set. */
+    __builtin_cpu_init ();
+#endif
+
+    switch (impl)
+    {
+        case SCALAR:  return true;
+#ifdef GATB_DECODER_X86
+        case SSE4_2:  return __builtin_cpu_supports ("sse4.2");
+        case AVX2:    return __builtin_cpu_supports ("avx2");
+#endif
+        default:      return false;
+    }
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+SuperKmerDecoder::Implementation SuperKmerDecoder::getDefault ()
+{
+    if (isSupported (AVX2))    { return AVX2;   }
+    if (isSupported (SSE4_2))  { return SSE4_2; }
+    return SCALAR;
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+const char* SuperKmerDecoder::getName (Implementation impl)
+{
+    switch (impl)
+    {
+        case SCALAR:  return "scalar";
+        case SSE4_2:  return "sse4.2";
+        case AVX2:    return "avx2";
+        default:      return "unknown";
+    }
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+void SuperKmerDecoder::unpack (const u_int8_t* packed, size_t nbNt, u_int8_t* forward, u_int8_t* complement, Implementation impl)
+{
+    switch (impl)
+    {
+#ifdef GATB_DECODER_X86
+        case SSE4_2:  unpack_sse    (packed, nbNt, forward, complement);  break;
+        case AVX2:    unpack_avx2   (packed, nbNt, forward, complement);  break;
+#endif
+        default:      unpack_scalar (packed, nbNt, forward, complement);  break;
+    }
+}
+
+/*********************************************************************
+** METHOD  :
+** PURPOSE :
+** INPUT   :
+** OUTPUT  :
+** RETURN  :
+** REMARKS :
+*********************************************************************/
+SuperKmerDecoder::UnpackFct SuperKmerDecoder::getDefaultUnpack ()
+{
+#ifdef GATB_DECODER_X86
+    switch (getDefault())
+    {
+        case AVX2:    return unpack_avx2;
+        case SSE4_2:  return unpack_sse;
+        default:      break;
+    }
+#endif
+    return unpack_scalar;
+}
+
+SuperKmerDecoder::UnpackFct SuperKmerDecoder::_unpack = getDefaultUnpack ();
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
@@ -0,0 +1,97 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/** \file SuperKmerDecoder.hpp
+ *  \brief Unpacking of the 2 bits nucleotides of the superkmers partition files
+ */
+
+#ifndef _GATB_CORE_KMER_IMPL_SUPERKMER_DECODER_HPP_
+#define _GATB_CORE_KMER_IMPL_SUPERKMER_DECODER_HPP_
+
+/********************************************************************************/
+
+#include <gatb/system/api/types.hpp>
+#include <cstddef>
+
+/********************************************************************************/
+namespace gatb      {
+namespace core      {
+namespace kmer      {
+namespace impl      {
+/********************************************************************************/
+
+/** \brief Unpacking of 2 bits encoded nucleotides
+ *
+ * In the superkmers partition files, the nucleotides are packed by 4 in each byte, the first
+ * nucleotide being in the less significant bits. This class unpacks such a stream into one
+ * nucleotide per byte, and gives at the same time the complemented nucleotides, which are the
+ * ones needed for building the reverse complement kmers.
+ *
+ * Several implementations are available (SSE4.2, AVX2 and a scalar fallback); the default one is
+ * chosen at runtime according to the features of the CPU.
+ */
+class SuperKmerDecoder
+{
+public:
+
+    /** Available implementations. */
+    enum Implementation  {  SCALAR, SSE4_2, AVX2, NB_IMPLEMENTATIONS  };
+
+    /** Unpack nucleotides with the default implementation.
+     * \param[in]  packed : the packed nucleotides, 4 per byte
+     * \param[in]  nbNt   : number of nucleotides to be unpacked
+     * \param[out] forward : the nucleotides, one per byte (must hold nbNt bytes)
+     * \param[out] complement : the complemented nucleotides, one per byte (must hold nbNt bytes) */
+    static void unpack (const u_int8_t* packed, size_t nbNt, u_int8_t* forward, u_int8_t* complement)
+    {
+        _unpack (packed, nbNt, forward, complement);
+    }
+
+    /** Unpack nucleotides with the given implementation, which must be supported.
+     * \param[in] impl : the implementation to be used. */
+    static void unpack (const u_int8_t* packed, size_t nbNt, u_int8_t* forward, u_int8_t* complement, Implementation impl);
+
+    /** Tells whether an implementation can be used on the current CPU.
+     * \param[in] impl : the implementation
+     * \return true if supported. */
+    static bool isSupported (Implementation impl);
+
+    /** Get the implementation chosen at runtime.
+     * \return the implementation */
+    static Implementation getDefault ();
+
+    /** Get the name of an implementation.
+     * \param[in] impl : the implementation
+     * \return the name. */
+    static const char* getName (Implementation impl);
+
+private:
+
+    typedef void (*UnpackFct) (const u_int8_t* packed, size_t nbNt, u_int8_t* forward, u_int8_t* complement);
+
+    static UnpackFct _unpack;
+
+    static UnpackFct getDefaultUnpack ();
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _GATB_CORE_KMER_IMPL_SUPERKMER_DECODER_HPP_ */
@@ -108,6 +108,14 @@ public:
      * \return number of  items successfully written */
     virtual size_t fwrite (const void* ptr, size_t size, size_t nmemb) = 0;
 
+    /** Writes a buffer at a given offset of the file, without using nor moving the current position.
+     * Several threads may write concurrently into distinct ranges of the file.
+     * \param[in] ptr : the buffer to be written
+     * \param[in] size : size of the buffer
+     * \param[in] offset : offset in the file where to write the buffer
+     * \return number of bytes successfully written */
+    virtual size_t pwrite (const void* ptr, size_t size, u_int64_t offset) = 0;
+
     /** Flush the file.
      */
     virtual void flush () = 0;
@@ -34,6 +34,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -127,6 +128,23 @@ public:
         return ::fwrite (ptr, size, nmemb, getHandle());
     }
 
+    /** \copydoc IFile::pwrite */
+    size_t pwrite (const void* ptr, size_t size, u_int64_t offset)
+    {
+        /** Note: the stdio buffer is not used, so the file must not be written through fwrite at the same time. */
+        int fd = fileno (getHandle());
+
+        size_t done = 0;
+        while (done < size)
+        {
+            ssize_t nb = ::pwrite (fd, (const char*)ptr + done, size - done, offset + done);
+            if (nb < 0 && errno == EINTR)  { continue; }
+            if (nb <= 0)  { break; }
+            done += nb;
+        }
+        return done;
+    }
+
     /** \copydoc IFile::flush */
     void flush ()  { if (isOpen())  {  fflush (getHandle()); } }
 
@@ -42,6 +42,10 @@
 #include <gatb/tools/math/NativeInt64.hpp>
 #include <gatb/tools/math/FastMinimizer.hpp>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 #ifndef ASSERTS
 #define assertLI(x) {} // disable asserts for large int; those asserts make sure that with PRECISION == [1 or 2], all is correct
 #else
@@ -708,6 +712,7 @@ private:
     template<int T>  friend u_int64_t   hash2    (const LargeInt<T>& key, u_int64_t  seed);
     template<int T>  friend u_int64_t   oahash  (const LargeInt<T>& key);
     template<int T>  friend u_int64_t   simplehash16    (const LargeInt<T>& key, int  shift);
+    template<int T>  friend u_int8_t    radixByte (const LargeInt<T>& key, size_t idx);
     template<int T, typename m_T>  \
                      friend void fastLexiMinimizer (const LargeInt<T>& key, const unsigned int _nbMinimizers, \
                              const unsigned int m, m_T &minimizer, size_t &position, bool &validResult);
@@ -719,19 +724,52 @@ private:
 };
 
 /********************************************************************************/
+#ifdef __AVX2__
+/** Reverse complement of 4 consecutive 64 bits words, as NativeInt64::revcompWord does for one word:
+ * bytes reversed inside each word by a shuffle, then nibbles and 2-bit pairs swapped, then complemented. */
+inline __m256i revcompWords4 (__m256i x)
+{
+    const __m256i bytes  = _mm256_setr_epi8 (7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8, 7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8);
+    const __m256i mask4  = _mm256_set1_epi8 (0x0F);
+    const __m256i mask2  = _mm256_set1_epi8 (0x33);
+    const __m256i compl2 = _mm256_set1_epi8 ((char)0xAA);
+
+    x = _mm256_shuffle_epi8 (x, bytes);
+    x = _mm256_or_si256 (_mm256_and_si256 (_mm256_srli_epi64 (x,4), mask4), _mm256_slli_epi64 (_mm256_and_si256 (x,mask4), 4));
+    x = _mm256_or_si256 (_mm256_and_si256 (_mm256_srli_epi64 (x,2), mask2), _mm256_slli_epi64 (_mm256_and_si256 (x,mask2), 2));
+    return _mm256_xor_si256 (x, compl2);
+}
+#endif
+
 template<int precision>  inline LargeInt<precision> revcomp (const LargeInt<precision>& x, size_t sizeKmer)
 {
+    // The 32*precision nucleotides are reverse complemented word by word, the words being
+    // written in reverse order; the unused nucleotides are then shifted out.
     LargeInt<precision> res;
-    res.setVal(0);
-    unsigned char* kmerrev  = (unsigned char *) (&(res.value[0]));
-    unsigned char* kmer     = (unsigned char *) (&(x.value[0]));
+    int i = 0;
 
-    for (size_t i=0; i<8*precision; ++i)
+#ifdef __AVX2__
+    for ( ; i+4 <= precision; i+=4)
     {
-        kmerrev[8*precision-1-i] = revcomp_4NT [kmer[i]];
+        __m256i w = revcompWords4 (_mm256_loadu_si256 ((const __m256i*) (x.value + i)));
+        _mm256_storeu_si256 ((__m256i*) (res.value + precision-4-i), _mm256_permute4x64_epi64 (w, 0x1B));
     }
+#endif
+
+    for ( ; i<precision; i++)  {  res.value[precision-1-i] = NativeInt64::revcompWord (x.value[i]);  }
+
+    size_t shift = 2*(32*precision - sizeKmer);
 
-    return (res >> (2*( 32*precision - sizeKmer))  ) ;
+    // Usual case of a kmer using all the words: the words are shifted in place, with fixed indexes
+    // (the double left shift gives 0 instead of an undefined result when shift is 0)
+    if (shift < 64)
+    {
+        for (i=0; i<precision-1; i++)  {  res.value[i] = (res.value[i] >> shift) | ((res.value[i+1] << 1) << (63-shift));  }
+        res.value[precision-1] >>= shift;
+        return res;
+    }
+
+    return (res >> shift) ;
 }
 
 /********************************************************************************/
@@ -747,6 +785,13 @@ template<int precision>  inline u_int64_t hash1 (const LargeInt<precision>& elem
     return result;
 }
 
+/********************************************************************************/
+/** Get the byte 'idx' of the integer (0 being the less significant byte); used by RadixSort. */
+template<int precision>  inline u_int8_t radixByte (const LargeInt<precision>& elem, size_t idx)
+{
+    return (elem.value[idx >> 3] >> (8*(idx & 7))) & 0xFF;
+}
+
 template<int precision>  inline u_int64_t hash2 (const LargeInt<precision>& elem, u_int64_t seed=0)
 {
     // hash = XOR_of_series[hash(i-th chunk of 64 bits)]
@@ -771,17 +816,14 @@ template<int precision>  inline u_int64_t hash2 (const LargeInt<precision>& elem
 
 
 /********************************************************************************/
-template<int precision>  u_int64_t oahash (const LargeInt<precision>& elem)
+template<int precision>  inline u_int64_t oahash (const LargeInt<precision>& elem)
 {
     // hash = XOR_of_series[hash(i-th chunk iof 64 bits)]
-    u_int64_t result = 0, chunk, mask = ~0;
+    u_int64_t result = 0;
 
-    LargeInt<precision> intermediate = elem;
     for (size_t i=0;i<precision;i++)
     {
-        chunk = (intermediate & mask).value[0];
-        intermediate = intermediate >> 64;
-        result ^= NativeInt64::oahash64 (chunk);
+        result ^= NativeInt64::oahash64 (elem.value[i]);
     }
     return result;
 }
@@ -791,13 +833,7 @@ template<int precision>  u_int64_t oahash (const LargeInt<precision>& elem)
 /********************************************************************************/
 template<int precision> inline u_int64_t simplehash16 (const LargeInt<precision>& elem, int  shift)
 {
-    u_int64_t result = 0, chunk, mask = ~0;
-    LargeInt<precision> intermediate = elem;
-    
-    chunk = (intermediate & mask).value[0];
-    result ^= NativeInt64::simplehash16_64 (chunk,shift);
-
-    return result;
+    return NativeInt64::simplehash16_64 (elem.value[0],shift);
 }
 
 /*
@@ -136,21 +136,7 @@ public:
     /********************************************************************************/
     inline static u_int64_t revcomp64 (const u_int64_t& x, size_t sizeKmer)
     {
-        u_int64_t res = x;
-
-        // OLD VERSION (with lookup table)
-        // unsigned char* kmerrev  = (unsigned char *) (&(res));
-        // unsigned char* kmer     = (unsigned char *) (&(x));
-        // for (size_t i=0; i<8; ++i)  {  kmerrev[8-1-i] = revcomp_4NT [kmer[i]];  }
-
-        res = ((res>> 2 & 0x3333333333333333) | (res & 0x3333333333333333) <<  2);
-        res = ((res>> 4 & 0x0F0F0F0F0F0F0F0F) | (res & 0x0F0F0F0F0F0F0F0F) <<  4);
-        res = ((res>> 8 & 0x00FF00FF00FF00FF) | (res & 0x00FF00FF00FF00FF) <<  8);
-        res = ((res>>16 & 0x0000FFFF0000FFFF) | (res & 0x0000FFFF0000FFFF) << 16);
-        res = ((res>>32 & 0x00000000FFFFFFFF) | (res & 0x00000000FFFFFFFF) << 32);
-        res = res ^ 0xAAAAAAAAAAAAAAAA;
-        
-        return (res >> (2*(32-sizeKmer))) ;
+        return NativeInt64::revcomp64 (x, sizeKmer);
     }
 
     /********************************************************************************/
@@ -281,6 +267,12 @@ inline u_int64_t simplehash16 (const LargeInt<1>& key, int  shift)
     return LargeInt<1>::simplehash16_64 (key.value, shift);
 }
 
+/********************************************************************************/
+inline u_int8_t radixByte (const LargeInt<1>& key, size_t idx)
+{
+    return (key.value >> (8*idx)) & 0xFF;
+}
+
 inline void fastLexiMinimizer (const LargeInt<1>& x, const unsigned int _nbMinimizers, const unsigned int m,  u_int32_t &minimizer, size_t &position, bool &validResult) 
 {
     if (m > sizeof(u_int32_t)*4) {std::cout << "wrong minimizer size for fastLeximinimizer :" << m; exit(1);}
@@ -158,6 +158,7 @@ private:
     friend u_int64_t    hash2    (const LargeInt<2>& key, u_int64_t  seed);
     friend u_int64_t    oahash  (const LargeInt<2>& key);
     friend u_int64_t    simplehash16    (const LargeInt<2>& key, int  shift);
+    friend u_int8_t     radixByte (const LargeInt<2>& key, size_t idx);
     template<typename m_T> friend void fastLexiMinimizer (const LargeInt<2>& x, const unsigned int _nbMinimizers, \
                              const unsigned int m, m_T &minimizer, size_t &position, bool &validResult);
     friend void justSweepForAA(const LargeInt<2>& x, const unsigned int _nbMinimizers, unsigned int &dummy);
@@ -172,28 +173,19 @@ inline LargeInt<2> revcomp (const LargeInt<2>& in, size_t sizeKmer)
     //
     // ex:            [         AC  | .......TG   ]
     //
-    //revcomp:        [         CA  | .......GT   ]
-    //                 \_low_nucl__/\high_nucl/
+    // each 64 bits word is reverse complemented as a whole and the two words are swapped,
+    // which gives the 64 nucleotides revcomp; the unused nucleotides are then shifted out.
 
     const __uint128_t& x = in.value;
 
-    u_int64_t high_nucl = (u_int64_t)(x>>64);
-    int nb_high_nucl = sizeKmer>32?sizeKmer - 32:0;
+    u_int64_t revcomp_low_nucl  = NativeInt64::revcompWord ((u_int64_t) x);
+    u_int64_t revcomp_high_nucl = NativeInt64::revcompWord ((u_int64_t) (x>>64));
 
-    u_int64_t revcomp_high_nucl = NativeInt64::revcomp64 (high_nucl, nb_high_nucl);
+    __uint128_t res = (((__uint128_t) revcomp_low_nucl) << 64) | revcomp_high_nucl;
 
-    if (sizeKmer<=32) revcomp_high_nucl = 0; // srsly dunno why this is needed. gcc bug? u_int64_t x ---> (x>>64) != 0
-
-    u_int64_t low_nucl = (u_int64_t)(x&((((__uint128_t)1)<<64)-1));
-    int nb_low_nucl = sizeKmer>32?32:sizeKmer;
-
-    u_int64_t revcomp_low_nucl = NativeInt64::revcomp64 (low_nucl, nb_low_nucl);
-
-    LargeInt<2> res;
-    res.setVal(revcomp_low_nucl);
-    res <<= 2* nb_high_nucl;
-    res += revcomp_high_nucl;
-    return res;
+    LargeInt<2> result;
+    result.value = res >> (2*(64 - sizeKmer));
+    return result;
 }
 
 /********************************************************************************/
@@ -250,6 +242,12 @@ inline u_int64_t simplehash16 (const LargeInt<2>& key, int  shift)
     return NativeInt64::simplehash16_64 ((u_int64_t)key.value, shift);
 }
 
+/********************************************************************************/
+inline u_int8_t radixByte (const LargeInt<2>& key, size_t idx)
+{
+    return (u_int8_t) (key.value >> (8*idx));
+}
+
 /********************************************************************************/
 template<typename minimizer_type> void fastLexiMinimizer (const LargeInt<2>& x, const unsigned int _nbMinimizers, \
                              const unsigned int m, minimizer_type &minimizer, size_t &position, bool &validResult)
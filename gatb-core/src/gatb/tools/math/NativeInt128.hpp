@@ -159,6 +159,7 @@ private:
     friend u_int64_t    hash1    (const NativeInt128& key, u_int64_t  seed);
     friend u_int64_t    oahash  (const NativeInt128& key);
     friend u_int64_t    simplehash16    (const NativeInt128& key, int  shift);
+    friend u_int8_t     radixByte (const NativeInt128& key, size_t idx);
 
 };
 
@@ -170,24 +171,17 @@ inline NativeInt128 revcomp (const NativeInt128& in, size_t sizeKmer)
     //
     // ex:            [         AC  | .......TG   ]
     //
-    //revcomp:        [         CA  | .......GT   ]
-    //                 \_low_nucl__/\high_nucl/
+    // each 64 bits word is reverse complemented as a whole and the two words are swapped,
+    // which gives the 64 nucleotides revcomp; the unused nucleotides are then shifted out.
 
     const __uint128_t& x = in.value[0];
 
-    u_int64_t high_nucl = (u_int64_t)(x>>64);
-    int nb_high_nucl = sizeKmer>32?sizeKmer - 32:0;
+    u_int64_t revcomp_low_nucl  = NativeInt64::revcompWord ((u_int64_t) x);
+    u_int64_t revcomp_high_nucl = NativeInt64::revcompWord ((u_int64_t) (x>>64));
 
-    __uint128_t revcomp_high_nucl = NativeInt64::revcomp64 (high_nucl, nb_high_nucl);
+    __uint128_t res = (((__uint128_t) revcomp_low_nucl) << 64) | revcomp_high_nucl;
 
-    if (sizeKmer<=32) revcomp_high_nucl = 0; // srsly dunno why this is needed. gcc bug? u_int64_t x ---> (x>>64) != 0
-
-    u_int64_t low_nucl = (u_int64_t)(x&((((__uint128_t)1)<<64)-1));
-    int nb_low_nucl = sizeKmer>32?32:sizeKmer;
-
-    __uint128_t revcomp_low_nucl = NativeInt64::revcomp64 (low_nucl, nb_low_nucl);
-
-    return (revcomp_low_nucl<<(2*nb_high_nucl)) + revcomp_high_nucl;
+    return NativeInt128 (res >> (2*(64 - sizeKmer)));
 }
 
 /********************************************************************************/
@@ -214,6 +208,12 @@ inline u_int64_t simplehash16 (const NativeInt128& key, int  shift)
     return NativeInt64::simplehash16_64 ((u_int64_t)key.value[0], shift);
 }
 
+/********************************************************************************/
+inline u_int8_t radixByte (const NativeInt128& key, size_t idx)
+{
+    return (u_int8_t) (key.value[0] >> (8*idx));
+}
+
 /********************************************************************************/
 } } } } /* end of namespaces. */
 /********************************************************************************/
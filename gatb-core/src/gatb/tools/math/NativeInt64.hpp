@@ -143,30 +143,35 @@ public:
 
     
     /********************************************************************************/
-    inline static u_int64_t revcomp64 (const u_int64_t& x, size_t sizeKmer)
+    /** Reverse complement of the 32 nucleotides held by a 64 bits word, without lookup
+     * table: the bytes are reversed, then the nibbles and the 2-bit pairs inside each byte,
+     * and the complement is a XOR since A<->T and C<->G only differ by their high bit. */
+    inline static u_int64_t revcompWord (u_int64_t x)
     {
+#if defined(__GNUC__)
+        u_int64_t res = __builtin_bswap64 (x);
+#else
         u_int64_t res = x;
+        res = ((res>> 8 & 0x00FF00FF00FF00FF) | (res & 0x00FF00FF00FF00FF) <<  8);
+        res = ((res>>16 & 0x0000FFFF0000FFFF) | (res & 0x0000FFFF0000FFFF) << 16);
+        res = ((res>>32 & 0x00000000FFFFFFFF) | (res & 0x00000000FFFFFFFF) << 32);
+#endif
+        res = ((res>> 4 & 0x0F0F0F0F0F0F0F0F) | (res & 0x0F0F0F0F0F0F0F0F) <<  4);
+        res = ((res>> 2 & 0x3333333333333333) | (res & 0x3333333333333333) <<  2);
+        return res ^ 0xAAAAAAAAAAAAAAAA;
+    }
 
-        unsigned char* kmerrev  = (unsigned char *) (&(res));
-        unsigned char* kmer     = (unsigned char *) (&(x));
-
-        for (size_t i=0; i<8; ++i)  {  kmerrev[8-1-i] = revcomp_4NT [kmer[i]];  }
-
-        return (res >> (2*( 32 - sizeKmer))) ;
+    /********************************************************************************/
+    inline static u_int64_t revcomp64 (const u_int64_t& x, size_t sizeKmer)
+    {
+        return (revcompWord (x) >> (2*( 32 - sizeKmer))) ;
     }
 
 	
 	/********************************************************************************/
     inline static u_int64_t revcomp8 (const u_int64_t& x, size_t sizeKmer)
     {
-        u_int64_t res = x;
-		
-        unsigned char* kmerrev  = (unsigned char *) (&(res));
-        unsigned char* kmer     = (unsigned char *) (&(x));
-		
-        for (size_t i=0; i<2; ++i)  {  kmerrev[8-1-i] = revcomp_4NT [kmer[i]];  }
-		
-        return (res >> (2*( 32 - sizeKmer))) ;
+        return (revcompWord (x & 0xFFFF) >> (2*( 32 - sizeKmer))) ;
     }
 
 	
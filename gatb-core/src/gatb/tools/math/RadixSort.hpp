@@ -0,0 +1,151 @@
+/*****************************************************************************
+ *   GATB : Genome Assembly Tool Box
+ *   Copyright (C) 2014  INRIA
+ *   Authors: R.Chikhi, G.Rizk, E.Drezen
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/** \file RadixSort.hpp
+ *  \brief In place radix sort for the integer types used for kmers
+ */
+
+#ifndef _GATB_CORE_TOOLS_MATH_RADIX_SORT_HPP_
+#define _GATB_CORE_TOOLS_MATH_RADIX_SORT_HPP_
+
+/********************************************************************************/
+
+#include <gatb/system/api/types.hpp>
+#include <algorithm>
+#include <cstddef>
+
+/********************************************************************************/
+namespace gatb  {
+namespace core  {
+namespace tools {
+namespace math  {
+/********************************************************************************/
+
+/** Get a byte of an integer, 0 being the less significant byte. This generic version only relies on
+ * the shift operator; the integer classes (LargeInt, NativeInt128...) provide their own overload
+ * that reads the byte directly from their internal words.
+ * \param[in] x   : the integer
+ * \param[in] idx : index of the byte
+ * \return the byte value. */
+template<typename T>  inline u_int8_t radixByte (const T& x, size_t idx)
+{
+    T tmp = x >> (int)(8*idx);
+    return tmp.getVal() & 0xFF;
+}
+
+/********************************************************************************/
+
+/** \brief In place MSD radix sort (American flag sort) on integers.
+ *
+ * The items are distributed into 256 buckets according to their most significant byte (in place, by
+ * cycles of swaps), then each bucket is sorted recursively on the next byte. Small buckets are
+ * finished with std::sort. When all the items of a range share the same byte, the distribution
+ * step is skipped, which is the usual case for the leading bytes of kmers put into a radix bucket.
+ *
+ * The resulting order is the same as the one given by operator< on the integer type.
+ *
+ * Example:
+ * \code
+ * LargeInt<2>* kmers = ...;
+ * // sort kmers of 63 nucleotides, ie. 126 bits, ie. 16 bytes
+ * RadixSort<LargeInt<2> >::sort (kmers, kmers+nbKmers, 16);
+ * \endcode
+ */
+template<typename T>
+class RadixSort
+{
+public:
+
+    /** Sort the [begin,end) range.
+     * \param[in] begin : first item
+     * \param[in] end   : end of the range
+     * \param[in] nbBytes : number of significant bytes of the items; the bytes beyond are supposed to be 0. */
+    static void sort (T* begin, T* end, size_t nbBytes)
+    {
+        if (nbBytes == 0 || end-begin < 2)  { return; }
+        sort_aux (begin, end-begin, nbBytes-1);
+    }
+
+    /** Below this number of items, we use std::sort. */
+    static const size_t THRESHOLD = 64;
+
+private:
+
+    static void sort_aux (T* data, size_t size, size_t byte)
+    {
+        while (true)
+        {
+            if (size < THRESHOLD)  {  std::sort (data, data+size);  return;  }
+
+            size_t count[256];
+            for (size_t b=0; b<256; b++)  { count[b] = 0; }
+
+            for (size_t i=0; i<size; i++)  {  count[radixByte(data[i],byte)] ++;  }
+
+            /** All the items share the same byte: we go directly to the next one. */
+            if (count[radixByte(data[0],byte)] == size)
+            {
+                if (byte == 0)  { return; }
+                byte--;
+                continue;
+            }
+
+            size_t head[256];
+            size_t tail[256];
+            size_t offset = 0;
+            for (size_t b=0; b<256; b++)  {  head[b] = offset;  offset += count[b];  tail[b] = offset;  }
+
+            /** We put each item in its bucket by following the swaps cycles. */
+            for (size_t b=0; b<256; b++)
+            {
+                while (head[b] < tail[b])
+                {
+                    T v = data[head[b]];
+                    u_int8_t k = radixByte (v, byte);
+
+                    while (k != b)
+                    {
+                        std::swap (v, data[head[k]++]);
+                        k = radixByte (v, byte);
+                    }
+
+                    data[head[b]++] = v;
+                }
+            }
+
+            if (byte == 0)  { return; }
+
+            /** We sort each bucket on the next byte. */
+            offset = 0;
+            for (size_t b=0; b<256; b++)
+            {
+                if (count[b] > 1)  {  sort_aux (data+offset, count[b], byte-1);  }
+                offset += count[b];
+            }
+
+            return;
+        }
+    }
+};
+
+/********************************************************************************/
+} } } } /* end of namespaces. */
+/********************************************************************************/
+
+#endif /* _GATB_CORE_TOOLS_MATH_RADIX_SORT_HPP_ */
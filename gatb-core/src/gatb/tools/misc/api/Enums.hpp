@@ -275,6 +275,44 @@ static std::string toString (KmerSolidityKind kind)
 
 /********************************************************************************/
 
+/** Enumeration of the orientations of the counted kmers. */
+enum KmerOrientation
+{
+    /** a kmer and its reverse complement are counted together */
+    KMER_ORIENTATION_CANONICAL,
+    /** kmers are counted as read (strand specific) */
+    KMER_ORIENTATION_DIRECT,
+    /** both canonical counts and strand specific counts */
+    KMER_ORIENTATION_BOTH
+};
+
+/** Get the enum from a string.
+ * \param[in] s : string to be parsed
+ * \param[out] kind : enum to be set from the string parsing. */
+static void parse (const std::string& s, KmerOrientation& kind)
+{
+         if (s == "canonical")  { kind = KMER_ORIENTATION_CANONICAL;  }
+    else if (s == "direct")     { kind = KMER_ORIENTATION_DIRECT;  }
+    else if (s == "both")       { kind = KMER_ORIENTATION_BOTH;  }
+    else   { throw system::Exception ("bad kmer orientation '%s'", s.c_str()); }
+}
+
+/** Get the string associated to an enum
+ * \param[in] kind : the enum value
+ * \return the associated string */
+static std::string toString (KmerOrientation kind)
+{
+    switch (kind)
+    {
+        case KMER_ORIENTATION_CANONICAL:  return "canonical";
+        case KMER_ORIENTATION_DIRECT:     return "direct";
+        case KMER_ORIENTATION_BOTH:       return "both";
+        default:    throw system::Exception ("bad kmer orientation %d", kind);
+    }
+}
+
+/********************************************************************************/
+
 /** Enumeration of different kinds of graph traversal. */
 enum TraversalKind
 {
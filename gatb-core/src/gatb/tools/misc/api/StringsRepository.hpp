@@ -120,6 +120,18 @@ public:
     const char* compress_level()   { return "-out-compress"; }
     const char* config_only()      { return "-config-only"; }
     const char* storage_type()     { return "-storage-type"; }
+    const char* pipeline_passes()  { return "-pipeline-passes"; }
+    const char* superk_compress()  { return "-superk-compress"; }
+    const char* superk_in_memory() { return "-superk-in-memory"; }
+    const char* count_strategy()   { return "-count-strategy"; }
+    const char* kmer_orientation() { return "-kmer-orientation"; }
+    const char* estimate_distinct(){ return "-estimate-distinct"; }
+    const char* repartition_sample_size() { return "-repartition-sample-size"; }
+    const char* repartition_sample_time() { return "-repartition-sample-time"; }
+    const char* repartition_in()   { return "-repartition-in"; }
+    const char* repartition_out()  { return "-repartition-out"; }
+    const char* count_matrix()     { return "-count-matrix"; }
+    const char* incremental_in()   { return "-incremental-in"; }
 
     const char* attr_uri_input      ()  { return "input";           }
     const char* attr_kmer_size      ()  { return "kmer_size";       }
@@ -173,6 +185,18 @@ public:
 #define STR_COMPRESS_LEVEL      gatb::core::tools::misc::StringRepository::singleton().compress_level()
 #define STR_CONFIG_ONLY         gatb::core::tools::misc::StringRepository::singleton().config_only()
 #define STR_STORAGE_TYPE        gatb::core::tools::misc::StringRepository::singleton().storage_type ()
+#define STR_PIPELINE_PASSES     gatb::core::tools::misc::StringRepository::singleton().pipeline_passes ()
+#define STR_SUPERK_COMPRESS     gatb::core::tools::misc::StringRepository::singleton().superk_compress ()
+#define STR_SUPERK_IN_MEMORY    gatb::core::tools::misc::StringRepository::singleton().superk_in_memory ()
+#define STR_COUNT_STRATEGY      gatb::core::tools::misc::StringRepository::singleton().count_strategy ()
+#define STR_KMER_ORIENTATION    gatb::core::tools::misc::StringRepository::singleton().kmer_orientation ()
+#define STR_ESTIMATE_DISTINCT   gatb::core::tools::misc::StringRepository::singleton().estimate_distinct ()
+#define STR_REPARTITION_SAMPLE_SIZE  gatb::core::tools::misc::StringRepository::singleton().repartition_sample_size ()
+#define STR_REPARTITION_SAMPLE_TIME  gatb::core::tools::misc::StringRepository::singleton().repartition_sample_time ()
+#define STR_REPARTITION_IN      gatb::core::tools::misc::StringRepository::singleton().repartition_in ()
+#define STR_REPARTITION_OUT     gatb::core::tools::misc::StringRepository::singleton().repartition_out ()
+#define STR_COUNT_MATRIX        gatb::core::tools::misc::StringRepository::singleton().count_matrix ()
+#define STR_INCREMENTAL_IN      gatb::core::tools::misc::StringRepository::singleton().incremental_in ()
 
 /********************************************************************************/
 
@@ -20,6 +20,8 @@
 /********************************************************************************/
 
 #include <gatb/tools/storage/impl/Storage.hpp>
+#include <gatb/system/api/Exception.hpp>
+#include <zlib.h>
 
 /********************************************************************************/
 namespace gatb { namespace core {  namespace tools {  namespace storage {  namespace impl {
@@ -307,10 +309,16 @@ Storage::istream::~istream ()
 ////////// SuperKmerBinFiles //////////
 ///////////////////////////////////////
 	
-SuperKmerBinFiles::SuperKmerBinFiles(const std::string& path,const std::string& name, size_t nb_files) : _basefilename(name), _path(path),_nb_files(nb_files)
+SuperKmerBinFiles::SuperKmerBinFiles(const std::string& path,const std::string& name, size_t nb_files, bool compress, u_int64_t memory_budget)
+	: _basefilename(name), _path(path),_nb_files(nb_files), _compress(compress), _memory_budget(memory_budget), _memory_used(0)
 {
 	_nbKmerperFile.resize(_nb_files,0);
 	_FileSize.resize(_nb_files,0);
+	_RawFileSize.resize(_nb_files,0);
+	_writeOffset.resize(_nb_files,0);
+	_memBlocks.resize(_nb_files);
+	_memReadPos.resize(_nb_files,0);
+	_onDisk.resize(_nb_files, _memory_budget==0 ? 1 : 0);
 	
 	openFiles("wb"); //at construction will open file for writing
 	// then use close() and openFiles() to open for reading
@@ -319,12 +327,20 @@ SuperKmerBinFiles::SuperKmerBinFiles(const std::string& path,const std::string&
 
 void SuperKmerBinFiles::openFile( const char* mode, int fileId)
 {
-	std::stringstream ss;
-	ss << _basefilename << "." << fileId;
-		
-	_files[fileId] = system::impl::System::file().newFile (_path, ss.str(), mode);
 	_synchros[fileId] = system::impl::System::thread().newSynchronizer();
 	_synchros[fileId]->use();
+
+	_memReadPos[fileId] = 0;
+	if(mode[0]=='w')  { _writeOffset[fileId] = 0; }
+
+	//in memory mode, the files are created only when the memory budget is exceeded (see writeBlock)
+	if(_memory_budget==0 || (mode[0]!='w' && _onDisk[fileId]))
+	{
+		std::stringstream ss;
+		ss << _basefilename << "." << fileId;
+		
+		_files[fileId] = system::impl::System::file().newFile (_path, ss.str(), mode);
+	}
 }
 	
 void SuperKmerBinFiles::openFiles( const char* mode)
@@ -336,13 +352,7 @@ void SuperKmerBinFiles::openFiles( const char* mode)
 
 	for(unsigned int ii=0;ii<_files.size();ii++)
 	{
-		std::stringstream ss;
-		ss << _basefilename << "." << ii;
-		
-		_files[ii] = system::impl::System::file().newFile (_path, ss.str(), mode);
-		_synchros[ii] = system::impl::System::thread().newSynchronizer();
-		_synchros[ii]->use();
-
+		openFile(mode, ii);
 	}
 }
 
@@ -356,13 +366,33 @@ std::string SuperKmerBinFiles::getFileName(int fileId)
 	return ss.str();
 }
 
+size_t SuperKmerBinFiles::readData(int file_id, void* ptr, size_t size)
+{
+	//the blocks kept in memory are read first, then the ones written to disk
+	std::vector<unsigned char>& mem = _memBlocks[file_id];
+	
+	if(_memReadPos[file_id] < mem.size())
+	{
+		size_t nb = std::min (size, mem.size() - _memReadPos[file_id]);
+		memcpy(ptr, &mem[_memReadPos[file_id]], nb);
+		_memReadPos[file_id] += nb;
+		return nb;
+	}
+	
+	if(_files[file_id]!=0)
+	{
+		return _files[file_id]->fread(ptr, 1, size);
+	}
+	
+	return 0;
+}
 	
 int SuperKmerBinFiles::readBlock(unsigned char ** block, unsigned int* max_block_size, unsigned int* nb_bytes_read, int file_id)
 {
 	_synchros[file_id]->lock();
 	
 	//block header
-	int nbr = _files[file_id]->fread(nb_bytes_read, sizeof(*max_block_size),1);
+	size_t nbr = readData(file_id, nb_bytes_read, sizeof(*nb_bytes_read));
 
 	if(nbr == 0)
 	{
@@ -371,6 +401,42 @@ int SuperKmerBinFiles::readBlock(unsigned char ** block, unsigned int* max_block
 		return 0;
 	}
 	
+	if(_compress)
+	{
+		//nb_bytes_read holds the stored size, followed by the raw size
+		unsigned int stored_size = *nb_bytes_read;
+		unsigned int raw_size = 0;
+		readData(file_id, &raw_size, sizeof(raw_size));
+		
+		std::vector<unsigned char> stored (stored_size);
+		readData(file_id, &stored[0], stored_size);
+		
+		_synchros[file_id]->unlock();
+		
+		//decompression is done outside the lock
+		if(raw_size > *max_block_size)
+		{
+			*block = (unsigned char *) realloc(*block, raw_size);
+			*max_block_size = raw_size;
+		}
+		
+		if(stored_size == raw_size)
+		{
+			memcpy(*block, &stored[0], raw_size);
+		}
+		else
+		{
+			uLongf dest_size = raw_size;
+			if(uncompress(*block, &dest_size, &stored[0], stored_size) != Z_OK || dest_size != raw_size)
+			{
+				throw system::Exception ("Unable to uncompress superkmers block of file %s", getFileName(file_id).c_str());
+			}
+		}
+		
+		*nb_bytes_read = raw_size;
+		return *nb_bytes_read;
+	}
+	
 	if(*nb_bytes_read > *max_block_size)
 	{
 		*block = (unsigned char *) realloc(*block, *nb_bytes_read);
@@ -378,7 +444,7 @@ int SuperKmerBinFiles::readBlock(unsigned char ** block, unsigned int* max_block
 	}
 	
 	//block
-	_files[file_id]->fread(*block, sizeof(unsigned char),*nb_bytes_read);
+	readData(file_id, *block, *nb_bytes_read);
 	
 	_synchros[file_id]->unlock();
 	
@@ -414,22 +480,121 @@ void SuperKmerBinFiles::getFilesStats(u_int64_t & total, u_int64_t & biggest, u_
 	
 }
 	
+u_int64_t SuperKmerBinFiles::getRawFilesSize()
+{
+	u_int64_t total =0;
+	for(unsigned int ii=0;ii<_RawFileSize.size();ii++)
+	{
+		total+=_RawFileSize[ii];
+	}
+	return total;
+}
+
+int SuperKmerBinFiles::getNbFilesOnDisk()
+{
+	int nb = 0;
+	for(unsigned int ii=0;ii<_onDisk.size();ii++)
+	{
+		if(_onDisk[ii]) { nb++; }
+	}
+	return nb;
+}
+	
+void SuperKmerBinFiles::writeData(int file_id, const void* header, size_t header_size, const void* data, size_t data_size)
+{
+	//must be called with the lock of the file
+	if(_memory_budget > 0)
+	{
+		std::vector<unsigned char>& mem = _memBlocks[file_id];
+		
+		size_t needed = mem.size() + header_size + data_size;
+		size_t growth = 0;
+		if(needed > mem.capacity())
+		{
+			growth = std::max (needed, 2*mem.capacity()) - mem.capacity();
+		}
+		
+		//we reserve the memory for the whole set of files at once, other files may be written concurrently
+		bool fits = (growth == 0);
+		if(!fits)
+		{
+			u_int64_t previous = __sync_fetch_and_add (&_memory_used, growth);
+			fits = previous + growth <= _memory_budget;
+			if(!fits)  { __sync_fetch_and_sub (&_memory_used, growth); }
+		}
+		
+		if(fits)
+		{
+			mem.reserve(mem.capacity() + growth);
+			mem.insert(mem.end(), (const unsigned char*)header, (const unsigned char*)header + header_size);
+			mem.insert(mem.end(), (const unsigned char*)data,   (const unsigned char*)data   + data_size);
+			return;
+		}
+		
+		//memory budget reached : the block goes to disk
+		if(_files[file_id]==0)
+		{
+			std::stringstream ss;
+			ss << _basefilename << "." << file_id;
+			
+			_files[file_id] = system::impl::System::file().newFile (_path, ss.str(), "wb");
+			_onDisk[file_id] = 1;
+		}
+	}
+	
+	_files[file_id]->fwrite(header, header_size,1);
+	_files[file_id]->fwrite(data, sizeof(unsigned char),data_size);
+}
 	
 void SuperKmerBinFiles::writeBlock(unsigned char * block, unsigned int block_size, int file_id, int nbkmers)
 {
-
-	_synchros[file_id]->lock();
+	//block header : block size, or stored size + raw size with compression
+	unsigned int header[2] = { block_size, block_size };
+	size_t header_size = sizeof(block_size);
 	
-	_nbKmerperFile[file_id]+=nbkmers;
-	_FileSize[file_id] += block_size+sizeof(block_size);
-	//block header
-	_files[file_id]->fwrite(&block_size, sizeof(block_size),1);
-
-	//block
-	_files[file_id]->fwrite(block, sizeof(unsigned char),block_size);
+	unsigned char* data = block;
+	uLongf stored_size = block_size;
+	std::vector<unsigned char> stored;
 	
-	_synchros[file_id]->unlock();
-
+	if(_compress)
+	{
+		//compression is done by the writer thread, the caller owns the block
+		stored_size = compressBound(block_size);
+		stored.resize(stored_size);
+		
+		data = &stored[0];
+		if(compress2(data, &stored_size, block, block_size, Z_BEST_SPEED) != Z_OK || stored_size >= block_size)
+		{
+			//not worth it : the block is stored as is
+			data = block;
+			stored_size = block_size;
+		}
+		
+		header[0] = (unsigned int) stored_size;
+		header_size = sizeof(header);
+	}
+	
+	__sync_fetch_and_add (&_nbKmerperFile[file_id], nbkmers);
+	__sync_fetch_and_add (&_FileSize[file_id],    stored_size+header_size);
+	__sync_fetch_and_add (&_RawFileSize[file_id], block_size+sizeof(block_size));
+	
+	//the blocks kept in memory are appended to a growing buffer, which needs the lock of the file
+	if(_memory_budget > 0)
+	{
+		_synchros[file_id]->lock();
+		writeData(file_id, header, header_size, data, stored_size);
+		_synchros[file_id]->unlock();
+		return;
+	}
+	
+	//otherwise we reserve the range of the block in the file, then we write it without lock
+	u_int64_t offset = __sync_fetch_and_add (&_writeOffset[file_id], header_size+stored_size);
+	
+	if(_files[file_id]->pwrite(header, header_size, offset) != header_size
+	|| _files[file_id]->pwrite(data, stored_size, offset+header_size) != stored_size)
+	{
+		throw system::Exception ("Unable to write superkmers block into file %s", getFileName(file_id).c_str());
+	}
 }
 	
 void SuperKmerBinFiles::flushFiles()
@@ -452,6 +617,8 @@ void SuperKmerBinFiles::eraseFiles()
 {
 	for(unsigned int ii=0;ii<_files.size();ii++)
 	{
+		if(!_onDisk[ii])  { continue; }
+		
 		std::stringstream ss;
 		ss << _path << "/" <<_basefilename << "." << ii;
 		system::impl::System::file().remove(ss.str());
@@ -466,7 +633,11 @@ void SuperKmerBinFiles::closeFile(  int fileId)
 	{
 		delete _files[fileId];
 		_files[fileId] = 0;
+	}
+	if(_synchros[fileId]!=0)
+	{
 		_synchros[fileId]->forget();
+		_synchros[fileId] = 0;
 	}
 }
 
@@ -475,12 +646,7 @@ void SuperKmerBinFiles::closeFiles()
 {
 	for(unsigned int ii=0;ii<_files.size();ii++)
 	{
-		if(_files[ii]!=0)
-		{
-			delete _files[ii];
-			_files[ii] = 0;
-			_synchros[ii]->forget();
-		}
+		closeFile(ii);
 	}
 }
 	
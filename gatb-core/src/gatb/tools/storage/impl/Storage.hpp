@@ -243,6 +243,16 @@ protected:
 //the  block structure makes it easier for buffered read,
 //otherwise we would not know how to read a big chunk without stopping in the middle of superkmer
 
+//with compression, each block is deflated (zlib, fastest level) on its own
+//block header = 4B = stored size + 4B = raw size ; if both sizes are equal, the block is stored uncompressed
+
+//with a memory budget, the blocks are kept in memory (same layout as on disk) and a file is created
+//only for the blocks that do not fit in the budget ; when reading, the blocks in memory come first
+
+//without memory budget, the writers don't take any lock : each one reserves the range of its block
+//through an atomic offset per file, then writes it there with pwrite ; so the blocks of a file are
+//not in a determined order
+
 class SuperKmerBinFiles
 {
 	
@@ -250,7 +260,9 @@ public:
 	
 	//construtor will open the files for writing
 	//use closeFiles to close them all then openFiles to open in different mode
-	SuperKmerBinFiles(const std::string& path,const std::string& name, size_t nb_files);
+	//if compress is true, the blocks are compressed before being written to disk
+	//if memory_budget (in bytes) is not 0, the blocks are kept in memory up to this budget
+	SuperKmerBinFiles(const std::string& path,const std::string& name, size_t nb_files, bool compress=false, u_int64_t memory_budget=0);
 	
 	~SuperKmerBinFiles();
 
@@ -272,19 +284,42 @@ public:
 	void getFilesStats(u_int64_t & total, u_int64_t & biggest, u_int64_t & smallest, float & mean);
 	u_int64_t getFileSize(int fileId);
 
+	bool isCompressed() const { return _compress; }
+
+	//total size the files would have without compression
+	u_int64_t getRawFilesSize();
+
+	//memory used by the blocks kept in memory, in bytes
+	u_int64_t getMemoryUsage() const { return _memory_used; }
+
+	//number of files actually created on disk
+	int getNbFilesOnDisk();
+
 	
 	std::string getFileName(int fileId);
 private:
 
+	size_t readData(int file_id, void* ptr, size_t size);
+	void writeData(int file_id, const void* header, size_t header_size, const void* data, size_t data_size);
+
 	std::string _basefilename;
 	std::string _path;
 	
 	std::vector<int> _nbKmerperFile;
 	std::vector<u_int64_t> _FileSize;
+	std::vector<u_int64_t> _RawFileSize;
+	std::vector<u_int64_t> _writeOffset; //next free offset of each file, reserved atomically by the writers
 
 	std::vector<system::IFile* > _files;
 	std::vector <system::ISynchronizer*> _synchros;
 	int _nb_files;
+	bool _compress;
+
+	u_int64_t _memory_budget;
+	u_int64_t _memory_used;
+	std::vector< std::vector<unsigned char> > _memBlocks;
+	std::vector<size_t> _memReadPos;
+	std::vector<u_int8_t> _onDisk; //not a vector<bool> : items are set concurrently
 };
 
 
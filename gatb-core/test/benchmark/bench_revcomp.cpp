@@ -0,0 +1,180 @@
+/* benchmarks the reverse complement and the hash of kmers for each kmer span,
+ * against the former byte-lookup revcomp and the shift-based oahash,
+ * then times neighbors() queries on a graph (which revcomp every candidate node)
+ * */
+
+#include <chrono>
+#define get_wtime() chrono::system_clock::now()
+#define diff_wtime(x,y) chrono::duration_cast<chrono::nanoseconds>(y - x).count()
+
+// prevents the compiler from computing a pass over the kmers once for all the passes
+inline void barrier ()  {  asm volatile ("" ::: "memory");  }
+
+
+#include <gatb/system/impl/System.hpp>
+
+#include <gatb/tools/math/LargeInt.hpp>
+#include <gatb/tools/math/Integer.hpp>
+
+#include <gatb/tools/misc/api/StringsRepository.hpp>
+
+#include <gatb/debruijn/impl/Graph.hpp>
+
+#include <gatb/bank/impl/BankStrings.hpp>
+
+#include <gatb/kmer/impl/Model.hpp>
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+using namespace gatb::core::debruijn;
+using namespace gatb::core::debruijn::impl;
+
+using namespace gatb::core::bank;
+using namespace gatb::core::bank::impl;
+
+using namespace gatb::core::kmer;
+using namespace gatb::core::kmer::impl;
+
+using namespace gatb::core::tools::misc;
+using namespace gatb::core::tools::misc::impl;
+
+using namespace gatb::core::system;
+using namespace gatb::core::system::impl;
+
+using namespace gatb::core::tools::math;
+
+/* revcomp as it was done before: one lookup in revcomp_4NT per byte of the integer */
+template <typename T> T revcompLookup (const T& x, size_t sizeKmer)
+{
+    T res;  res.setVal(0);
+    unsigned char* kmerrev  = (unsigned char *) (&res);
+    const unsigned char* kmer = (const unsigned char *) (&x);
+
+    for (size_t i=0; i<sizeof(T); ++i)  {  kmerrev[sizeof(T)-1-i] = revcomp_4NT [kmer[i]];  }
+
+    return (res >> (2*(4*sizeof(T) - sizeKmer)));
+}
+
+/* oahash as it was done before: one mask and one 64 bits shift of the whole integer per chunk */
+template <typename T> u_int64_t oahashShift (const T& x)
+{
+    u_int64_t result = 0, mask = ~0;
+    T intermediate = x;
+    for (size_t i=0; i<sizeof(T)/8; i++)
+    {
+        result ^= NativeInt64::oahash64 ((intermediate & mask).getVal());
+        intermediate = intermediate >> 64;
+    }
+    return result;
+}
+
+struct Parameter
+{
+    Parameter (size_t k, size_t nbKmers, size_t nbReads) : k(k), nbKmers(nbKmers), nbReads(nbReads) {}
+    size_t k;
+    size_t nbKmers;
+    size_t nbReads;
+};
+
+template<size_t span> struct revcomp_bench {  void operator ()  (Parameter params)
+{
+    typedef typename Kmer<span>::Type  Type;
+
+    size_t kmerSize = params.k;
+    double unit = 1000000000;
+
+    /** We generate random kmers; the set is kept small enough to stay in cache and is
+     * processed several times, so we time the computation and not the memory bandwidth. */
+    srand (1234);
+    vector<Type> kmers (1<<14);
+    size_t nbLoops = params.nbKmers / kmers.size() + 1;
+    for (size_t i=0; i<kmers.size(); i++)
+    {
+        Type x; x.setVal(0);
+        for (size_t j=0; j<kmerSize; j++)  { x = (x << 2) + (u_int64_t) (rand() & 3); }
+        kmers[i] = x;
+    }
+
+    u_int64_t checksum = 0;
+
+    cout << "k=" << kmerSize << " (" << Type::getName() << ") " << nbLoops*kmers.size() << " kmers" << endl;
+
+    auto start_t=get_wtime();
+    for (size_t n=0; n<nbLoops; n++, barrier())  for (size_t i=0; i<kmers.size(); i++)  { checksum += revcompLookup (kmers[i], kmerSize).getVal(); }
+    auto end_t=get_wtime();
+    cout << "k=" << kmerSize << " (" << Type::getName() << ") revcomp, byte lookup     : " << diff_wtime(start_t, end_t) / unit << " seconds" << endl;
+
+    start_t=get_wtime();
+    for (size_t n=0; n<nbLoops; n++, barrier())  for (size_t i=0; i<kmers.size(); i++)  { checksum -= revcomp (kmers[i], kmerSize).getVal(); }
+    end_t=get_wtime();
+    cout << "k=" << kmerSize << " (" << Type::getName() << ") revcomp, bit parallel    : " << diff_wtime(start_t, end_t) / unit << " seconds" << endl;
+
+    start_t=get_wtime();
+    for (size_t n=0; n<nbLoops; n++, barrier())  for (size_t i=0; i<kmers.size(); i++)  { checksum += oahashShift (kmers[i]); }
+    end_t=get_wtime();
+    cout << "k=" << kmerSize << " (" << Type::getName() << ") oahash, shifted chunks   : " << diff_wtime(start_t, end_t) / unit << " seconds" << endl;
+
+    start_t=get_wtime();
+    for (size_t n=0; n<nbLoops; n++, barrier())  for (size_t i=0; i<kmers.size(); i++)  { checksum -= oahash (kmers[i]); }
+    end_t=get_wtime();
+    cout << "k=" << kmerSize << " (" << Type::getName() << ") oahash, direct words     : " << diff_wtime(start_t, end_t) / unit << " seconds" << endl;
+
+    /** Both flavors compute the same values, so the checksum must be 0. */
+    if (checksum != 0)  { cout << "MISMATCH between the two flavors !" << endl;  return; }
+
+    if (params.nbReads == 0)  { return; }
+
+    /** We time a graph traversal: each neighbors() query revcomps the candidate nodes. */
+    string args = "-kmer-size " + std::to_string(kmerSize) + " -abundance-min 1 -verbose 0 -max-memory 500";
+    vector<string> reads (params.nbReads);
+    for (size_t i=0; i<reads.size(); i++)
+    {
+        for (size_t j=0; j<200; j++)  {  reads[i] += "ACGT"[rand() & 3];  }
+    }
+    Graph graph = Graph::create (new BankStrings (reads), args.c_str());
+
+    graph.disableNodeState();
+
+    GraphIterator<Node> nodes = graph.iterator();
+    size_t nbNeighbors = 0;
+
+    start_t=get_wtime();
+    for (nodes.first(); !nodes.isDone(); nodes.next())  { nbNeighbors += graph.neighbors (nodes.item()).size(); }
+    end_t=get_wtime();
+    cout << "k=" << kmerSize << " (" << Type::getName() << ") neighbors() on " << nodes.size() << " nodes (" << nbNeighbors << " neighbors) : "
+         << diff_wtime(start_t, end_t) / unit << " seconds" << endl;
+
+    graph.remove ();
+}};
+
+int main (int argc, char* argv[])
+{
+    size_t nbKmers = argc > 1 ? atol (argv[1]) : 10*1000*1000;
+    size_t nbReads = argc > 2 ? atol (argv[2]) : 10*1000;
+
+    cout.setf(ios_base::fixed);
+    cout.precision(3);
+
+    try
+    {
+        /** One (odd) kmer size per span, ie. per LargeInt precision. */
+        size_t spans[] = { KSIZE_LIST };
+
+        for (size_t i=0; i<ARRAY_SIZE(spans); i++)
+        {
+            size_t kmerSize = spans[i] - 1;
+            Integer::apply<revcomp_bench, Parameter> (kmerSize, Parameter (kmerSize, nbKmers, nbReads));
+        }
+    }
+    catch (Exception& e)
+    {
+        cerr << "EXCEPTION: " << e.getMessage() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -85,6 +85,7 @@ class TestBank : public Test
         //        CPPUNIT_TEST_GATB (bank_datalinesize); // disabled since we're printing fasta in one line now (see "#if 1" in BankFasta)
         CPPUNIT_TEST_GATB (bank_registery_types);
         CPPUNIT_TEST_GATB (bank_checkPower2);
+        CPPUNIT_TEST_GATB (bank_checkOffset);
 
     CPPUNIT_TEST_SUITE_GATB_END();
 
@@ -1092,6 +1093,56 @@ public:
         System::file().remove(filename);
         CPPUNIT_ASSERT (System::file().doesExist(filename) == false);
     }
+
+    /********************************************************************************/
+    void bank_checkOffset_aux (const string& filename, size_t step)
+    {
+        BankFasta b (filename);
+
+        /** We get all the sequences of the bank. */
+        vector<string> all;
+        BankFasta::Iterator it (b, BankFasta::Iterator::NONE);
+        for (it.first(); !it.isDone(); it.next())  {  all.push_back (it->toString());  }
+        CPPUNIT_ASSERT (all.size() > 0);
+
+        /** The sequences found after some offset must be the last ones of the bank. */
+        size_t previous = all.size();
+        for (u_int64_t offset=1; offset < System::file().getSize(filename); offset += step)
+        {
+            vector<string> part;
+            Iterator<Sequence>* itOffset = b.iterator (offset);  LOCAL (itOffset);
+            for (itOffset->first(); !itOffset->isDone(); itOffset->next())  {  part.push_back (itOffset->item().toString());  }
+
+            CPPUNIT_ASSERT (part.size() <= previous);
+            CPPUNIT_ASSERT (std::equal (part.begin(), part.end(), all.end() - part.size()));
+
+            previous = part.size();
+        }
+    }
+
+    /********************************************************************************/
+    void bank_checkOffset ()
+    {
+        bank_checkOffset_aux (DBPATH("sample1.fa"),      7);
+        bank_checkOffset_aux (DBPATH("reads1.fa"),       1001);
+        bank_checkOffset_aux (DBPATH("sample.fastq"),    7);
+        bank_checkOffset_aux (DBPATH("sample.fastq.gz"), 7);
+
+        /** We check a FASTQ file whose quality lines start with the header characters. */
+        string filename = "test.fastq";
+        ofstream file (filename.c_str());
+        CPPUNIT_ASSERT (file.is_open());
+
+        for (size_t i=0; i<20; i++)
+        {
+            file << "@read" << i << endl << "ACGTACGTTGCA" << endl << "+" << endl << (i%2==0 ? "@@@@IIIIIIII" : "+IIIIIIIIIII") << endl;
+        }
+        file.close ();
+
+        bank_checkOffset_aux (filename, 3);
+
+        System::file().remove(filename);
+    }
 };
 
 /********************************************************************************/
@@ -26,8 +26,12 @@
 #include <gatb/bank/impl/Bank.hpp>
 
 #include <gatb/kmer/impl/SortingCountAlgorithm.hpp>
+#include <gatb/kmer/impl/CountProcessor.hpp>
+#include <gatb/kmer/impl/ConfigurationAlgorithm.hpp>
+#include <gatb/kmer/impl/RepartitionAlgorithm.hpp>
 #include <gatb/kmer/impl/Model.hpp>
 #include <gatb/kmer/impl/BankKmers.hpp>
+#include <gatb/kmer/impl/BloomBuilder.hpp>
 
 #include <gatb/tools/misc/api/Macros.hpp>
 #include <gatb/tools/misc/impl/Property.hpp>
@@ -102,6 +106,16 @@ class TestDSK : public Test
         CPPUNIT_TEST_GATB (DSK_perBank2);
         CPPUNIT_TEST_GATB (DSK_perBankKmer);
         CPPUNIT_TEST_GATB (DSK_multibank);
+        CPPUNIT_TEST_GATB (DSK_pipeline);
+        CPPUNIT_TEST_GATB (DSK_superkInMemory);
+        CPPUNIT_TEST_GATB (DSK_stream);
+        CPPUNIT_TEST_GATB (DSK_countStrategy);
+        CPPUNIT_TEST_GATB (DSK_kmerOrientation);
+        CPPUNIT_TEST_GATB (DSK_estimateDistinct);
+        CPPUNIT_TEST_GATB (DSK_repartitionSample);
+        CPPUNIT_TEST_GATB (DSK_repartitionReuse);
+        CPPUNIT_TEST_GATB (DSK_countMatrix);
+        CPPUNIT_TEST_GATB (DSK_incremental);
 		 
 
     CPPUNIT_TEST_SUITE_GATB_END();
@@ -703,6 +717,649 @@ public:
 
         boost::mpl::for_each<gatb::core::tools::math::IntegerList>(DSK_multibank_aux());
     }
+
+    /********************************************************************************/
+    template<size_t span>
+    size_t DSK_pipeline_aux (IBank* bank, size_t kmerSize, size_t nbPasses, bool pipeline, bool& pipelined)
+    {
+        /** We configure parameters for a SortingCountAlgorithm object. */
+        IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+        params->setInt (STR_KMER_SIZE,          kmerSize);
+        params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+        params->setInt (STR_KMER_ABUNDANCE_MIN, 1);
+        params->setInt (STR_PIPELINE_PASSES,    pipeline ? 1 : 0);
+
+        Storage* storage = StorageFactory(STORAGE_HDF5).create ("testPipeline", true, true);
+        LOCAL (storage);
+
+        /** We get a configuration and force the number of passes (the bank is too small otherwise). */
+        ConfigurationAlgorithm<span> configAlgo (bank, params);
+        configAlgo.execute();
+        Configuration config = configAlgo.getConfiguration();
+        config._nb_passes = nbPasses;
+
+        RepartitorAlgorithm<span> repart (bank, (*storage)("minimizers"), config);
+        repart.execute();
+
+        SortingCountAlgorithm<span> sortingCount (
+            bank,
+            config,
+            new Repartitor ((*storage)("minimizers")),
+            SortingCountAlgorithm<span>::getDefaultProcessorVector (config, params, storage, storage),
+            params
+        );
+        sortingCount.execute();
+
+        pipelined = sortingCount.getInfo()->getInt("pipelined_passes") != 0;
+
+        return sortingCount.getSolidCounts()->getNbItems();
+    }
+
+    void DSK_pipeline ()
+    {
+        size_t kmerSize = 15;
+
+        IBank* bank = new BankStrings (
+            "CGCTACAGCAGCTAGTTCATCATTGTTTATCAATGATAAAATATAATAAGCTAAAAGGAAACTATAAATA",
+            "ACCATGTATAATTATAAGTAGGTACCTATTTTTTTATTTTAAACTGAAATTCAATATTATATAGGCAAAG",
+            "ACTTAGATGTAAGATTTCGAAGACTTGGATGTAAACAACAAATAAGATAATAACCATAAAAATAGAAATG",
+            "AACGATATTAAAATTAAAAAATACGAAAAAACTAACACGTATTGTGTCCAATAAATTCGATTTGATAATT",
+            0
+        );
+        LOCAL (bank);
+
+        bool pipelined = false;
+
+        /** Reference: one single pass. */
+        size_t nbSolids = DSK_pipeline_aux<KSIZE_1> (bank, kmerSize, 1, false, pipelined);
+        CPPUNIT_ASSERT (nbSolids > 0);
+        CPPUNIT_ASSERT (pipelined == false);
+
+        /** Several passes run one after another one. */
+        CPPUNIT_ASSERT (DSK_pipeline_aux<KSIZE_1> (bank, kmerSize, 3, false, pipelined) == nbSolids);
+        CPPUNIT_ASSERT (pipelined == false);
+
+        /** Several passes, partitioning pass N+1 while counting pass N. */
+        CPPUNIT_ASSERT (DSK_pipeline_aux<KSIZE_1> (bank, kmerSize, 3, true, pipelined) == nbSolids);
+        CPPUNIT_ASSERT (pipelined == true);
+        CPPUNIT_ASSERT (DSK_pipeline_aux<KSIZE_1> (bank, kmerSize, 4, true, pipelined) == nbSolids);
+        CPPUNIT_ASSERT (pipelined == true);
+    }
+
+    /********************************************************************************/
+    void DSK_superkInMemory ()
+    {
+        size_t kmerSize = 15;
+
+        IBank* bank = new BankStrings (
+            "CGCTACAGCAGCTAGTTCATCATTGTTTATCAATGATAAAATATAATAAGCTAAAAGGAAACTATAAATA",
+            "ACCATGTATAATTATAAGTAGGTACCTATTTTTTTATTTTAAACTGAAATTCAATATTATATAGGCAAAG",
+            "ACTTAGATGTAAGATTTCGAAGACTTGGATGTAAACAACAAATAAGATAATAACCATAAAAATAGAAATG",
+            "AACGATATTAAAATTAAAAAATACGAAAAAACTAACACGTATTGTGTCCAATAAATTCGATTTGATAATT",
+            0
+        );
+        LOCAL (bank);
+
+        size_t nbSolids[2];
+
+        for (size_t inMemory=0; inMemory<2; inMemory++)
+        {
+            IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+            params->setInt (STR_KMER_SIZE,          kmerSize);
+            params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+            params->setInt (STR_KMER_ABUNDANCE_MIN, 1);
+            params->setInt (STR_SUPERK_IN_MEMORY,   inMemory);
+
+            SortingCountAlgorithm<KSIZE_1> sortingCount (bank, params);
+            sortingCount.execute();
+
+            nbSolids[inMemory] = sortingCount.getSolidCounts()->getNbItems();
+
+            /** No superkmers file should have been created in memory mode. */
+            int nbFilesOnDisk = sortingCount.getInfo()->getInt ("nb_files_on_disk");
+            if (inMemory)  { CPPUNIT_ASSERT (nbFilesOnDisk == 0); }
+            else           { CPPUNIT_ASSERT (nbFilesOnDisk >  0); }
+        }
+
+        CPPUNIT_ASSERT (nbSolids[0] > 0);
+        CPPUNIT_ASSERT (nbSolids[0] == nbSolids[1]);
+    }
+
+    /********************************************************************************/
+    void DSK_countStrategy ()
+    {
+        typedef Kmer<KSIZE_1>::Count Count;
+
+        size_t kmerSize = 15;
+
+        /** Some sequences are repeated, so some partitions are redundant. */
+        IBank* bank = new BankStrings (
+            "CGCTACAGCAGCTAGTTCATCATTGTTTATCAATGATAAAATATAATAAGCTAAAAGGAAACTATAAATA",
+            "CGCTACAGCAGCTAGTTCATCATTGTTTATCAATGATAAAATATAATAAGCTAAAAGGAAACTATAAATA",
+            "CGCTACAGCAGCTAGTTCATCATTGTTTATCAATGATAAAATATAATAAGCTAAAAGGAAACTATAAATA",
+            "ACCATGTATAATTATAAGTAGGTACCTATTTTTTTATTTTAAACTGAAATTCAATATTATATAGGCAAAG",
+            "ACTTAGATGTAAGATTTCGAAGACTTGGATGTAAACAACAAATAAGATAATAACCATAAAAATAGAAATG",
+            "ACTTAGATGTAAGATTTCGAAGACTTGGATGTAAACAACAAATAAGATAATAACCATAAAAATAGAAATG",
+            "AACGATATTAAAATTAAAAAATACGAAAAAACTAACACGTATTGTGTCCAATAAATTCGATTTGATAATT",
+            0
+        );
+        LOCAL (bank);
+
+        const char* strategies[] = { "sort", "hash", "auto" };
+        vector<Count> solids[3];
+
+        for (size_t i=0; i<3; i++)
+        {
+            IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+            params->setInt (STR_KMER_SIZE,          kmerSize);
+            params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+            params->setInt (STR_KMER_ABUNDANCE_MIN, 1);
+            params->setStr (STR_COUNT_STRATEGY,     strategies[i]);
+
+            SortingCountAlgorithm<KSIZE_1> sortingCount (bank, params);
+            sortingCount.execute();
+
+            Iterator<Count>* it = sortingCount.getSolidCounts()->iterator();  LOCAL (it);
+            for (it->first(); !it->isDone(); it->next())  {  solids[i].push_back (it->item());  }
+            std::sort (solids[i].begin(), solids[i].end(), lessCount<Count>);
+
+            int nbSorted = sortingCount.getInfo()->getInt ("nb_parts_sort");
+            int nbHashed = sortingCount.getInfo()->getInt ("nb_parts_hash");
+            CPPUNIT_ASSERT (nbSorted + nbHashed > 0);
+            if (i==0)  { CPPUNIT_ASSERT (nbHashed == 0); }
+            if (i==1)  { CPPUNIT_ASSERT (nbSorted == 0); }
+        }
+
+        /** Same kmers with same abundances whatever the strategy. */
+        CPPUNIT_ASSERT (solids[0].size() > 0);
+        for (size_t i=1; i<3; i++)
+        {
+            CPPUNIT_ASSERT (solids[i].size() == solids[0].size());
+            for (size_t j=0; j<solids[0].size(); j++)
+            {
+                CPPUNIT_ASSERT (solids[i][j].value == solids[0][j].value && solids[i][j].abundance == solids[0][j].abundance);
+            }
+        }
+    }
+
+    /********************************************************************************/
+    void DSK_kmerOrientation ()
+    {
+        typedef Kmer<KSIZE_1>::Count Count;
+        typedef Kmer<KSIZE_1>::Type  Type;
+
+        size_t kmerSize = 15;
+
+        /** The first sequence is also given as its reverse complement. */
+        IBank* bank = new BankStrings (
+            "CGCTACAGCAGCTAGTTCATCATTGTTTATCAATGATAAAATATAATAAGCTAAAAGGAAACTATAAATA",
+            "TATTTATAGTTTCCTTTTAGCTTATTATATTTTATCATTGATAAACAATGATGAACTAGCTGCTGTAGCG",
+            "ACCATGTATAATTATAAGTAGGTACCTATTTTTTTATTTTAAACTGAAATTCAATATTATATAGGCAAAG",
+            "ACTTAGATGTAAGATTTCGAAGACTTGGATGTAAACAACAAATAAGATAATAACCATAAAAATAGAAATG",
+            "ACTTAGATGTAAGATTTCGAAGACTTGGATGTAAACAACAAATAAGATAATAACCATAAAAATAGAAATG",
+            0
+        );
+        LOCAL (bank);
+
+        const char* orientations[] = { "canonical", "direct", "both" };
+        size_t      abundanceMin[] = { 2, 1, 2 };
+        vector<Count> solids[3];
+        vector<Count> stranded;
+
+        for (size_t i=0; i<3; i++)
+        {
+            IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+            params->setInt (STR_KMER_SIZE,          kmerSize);
+            params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+            params->setInt (STR_KMER_ABUNDANCE_MIN, abundanceMin[i]);
+            params->setStr (STR_KMER_ORIENTATION,   orientations[i]);
+
+            SortingCountAlgorithm<KSIZE_1> sortingCount (bank, params);
+            sortingCount.execute();
+
+            Iterator<Count>* it = sortingCount.getSolidCounts()->iterator();  LOCAL (it);
+            for (it->first(); !it->isDone(); it->next())  {  solids[i].push_back (it->item());  }
+            std::sort (solids[i].begin(), solids[i].end(), lessCount<Count>);
+
+            if (i==2)
+            {
+                CountProcessorStrand<KSIZE_1>* strand = sortingCount.getProcessor(0)->get<CountProcessorStrand<KSIZE_1> >();
+                CPPUNIT_ASSERT (strand != 0 && strand->getStranded() != 0);
+
+                CountProcessorDump<KSIZE_1>* dump = strand->getStranded()->get<CountProcessorDump<KSIZE_1> >();
+                CPPUNIT_ASSERT (dump != 0);
+
+                Iterator<Count>* itStranded = dump->getSolidCounts()->iterator();  LOCAL (itStranded);
+                for (itStranded->first(); !itStranded->isDone(); itStranded->next())  {  stranded.push_back (itStranded->item());  }
+                std::sort (stranded.begin(), stranded.end(), lessCount<Count>);
+            }
+        }
+
+        /** The canonical counts of the 'both' orientation are the ones of the 'canonical' orientation. */
+        CPPUNIT_ASSERT (solids[0].size() > 0);
+        CPPUNIT_ASSERT (solids[2].size() == solids[0].size());
+        for (size_t j=0; j<solids[0].size(); j++)
+        {
+            CPPUNIT_ASSERT (solids[2][j].value == solids[0][j].value && solids[2][j].abundance == solids[0][j].abundance);
+        }
+
+        /** The stranded counts are the ones of the 'direct' orientation... */
+        CPPUNIT_ASSERT (stranded.size() > solids[0].size());
+        std::map<Type,size_t> canonicalSums;
+        for (size_t j=0; j<stranded.size(); j++)
+        {
+            vector<Count>::iterator found = std::lower_bound (solids[1].begin(), solids[1].end(), stranded[j], lessCount<Count>);
+            CPPUNIT_ASSERT (found != solids[1].end() && found->value == stranded[j].value && found->abundance == stranded[j].abundance);
+
+            canonicalSums [std::min (stranded[j].value, revcomp (stranded[j].value, kmerSize))] += stranded[j].abundance;
+        }
+
+        /** ... and they sum up to the canonical counts of the solid kmers. */
+        CPPUNIT_ASSERT (canonicalSums.size() == solids[0].size());
+        for (size_t j=0; j<solids[0].size(); j++)
+        {
+            CPPUNIT_ASSERT (canonicalSums[solids[0][j].value] == (size_t)solids[0][j].abundance);
+        }
+    }
+
+    /********************************************************************************/
+    void DSK_estimateDistinct ()
+    {
+        size_t kmerSize = 31;
+
+        /** We build a random bank; each read is given twice. */
+        srand (1234);
+        vector<string> sequences;
+        for (size_t i=0; i<1000; i++)
+        {
+            string seq;
+            for (size_t j=0; j<200; j++)  {  seq += "ACGT"[rand()%4];  }
+            sequences.push_back (seq);
+            sequences.push_back (seq);
+        }
+
+        IBank* bank = new BankStrings (sequences);
+        LOCAL (bank);
+
+        IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+        params->setInt (STR_KMER_SIZE,          kmerSize);
+        params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+        params->setInt (STR_KMER_ABUNDANCE_MIN, 1);
+        params->setInt (STR_ESTIMATE_DISTINCT,  1);
+
+        ConfigurationAlgorithm<KSIZE_1> configAlgo (bank, params);
+        configAlgo.execute();
+
+        u_int64_t estimate = configAlgo.getConfiguration()._estimatedDistinctKmersNb;
+        double    error    = configAlgo.getConfiguration()._estimatedDistinctKmersError;
+        CPPUNIT_ASSERT (estimate > 0 && error > 0);
+        CPPUNIT_ASSERT (configAlgo.getInfo()->get ("distinct_kmers_estimate") != 0);
+
+        /** We compare with the exact number of distinct kmers. */
+        SortingCountAlgorithm<KSIZE_1> sortingCount (bank, params);
+        sortingCount.execute();
+
+        double nbDistinct = sortingCount.getSolidCounts()->getNbItems();
+        CPPUNIT_ASSERT (nbDistinct > 0);
+        CPPUNIT_ASSERT (std::abs ((double)estimate - nbDistinct) <= 4 * error * nbDistinct);
+    }
+
+    /********************************************************************************/
+    void DSK_repartitionSample ()
+    {
+        /** The sampling of the repartition may be bounded in size or in time; the counts must be the same. */
+        const char* sampleSizes[] = { "0", "10", "0" };
+        const char* sampleTimes[] = { "0", "0",  "1" };
+
+        IBank* bank = Bank::open (DBPATH("album.txt"));
+        LOCAL (bank);
+
+        vector<Kmer<KSIZE_1>::Count> solids[3];
+
+        for (size_t i=0; i<3; i++)
+        {
+            IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+            params->setInt (STR_KMER_SIZE,               31);
+            params->setInt (STR_MAX_MEMORY,              MAX_MEMORY);
+            params->setInt (STR_KMER_ABUNDANCE_MIN,      1);
+            params->setStr (STR_REPARTITION_SAMPLE_SIZE, sampleSizes[i]);
+            params->setStr (STR_REPARTITION_SAMPLE_TIME, sampleTimes[i]);
+
+            SortingCountAlgorithm<KSIZE_1> sortingCount (bank, params);
+            sortingCount.execute();
+
+            Iterator<Kmer<KSIZE_1>::Count>* it = sortingCount.getSolidCounts()->iterator();  LOCAL (it);
+            for (it->first(); !it->isDone(); it->next())  {  solids[i].push_back (it->item());  }
+            std::sort (solids[i].begin(), solids[i].end(), lessCount<Kmer<KSIZE_1>::Count>);
+        }
+
+        CPPUNIT_ASSERT (solids[0].size() > 0);
+        for (size_t i=1; i<3; i++)
+        {
+            CPPUNIT_ASSERT (solids[i].size() == solids[0].size());
+            for (size_t j=0; j<solids[0].size(); j++)
+            {
+                CPPUNIT_ASSERT (solids[i][j].value == solids[0][j].value && solids[i][j].abundance == solids[0][j].abundance);
+            }
+        }
+    }
+
+    /********************************************************************************/
+    vector<Kmer<KSIZE_1>::Count> DSK_repartitionReuse_aux (IBank* bank, size_t kmerSize, size_t minimizerType, const char* repartitionIn, const char* repartitionOut)
+    {
+        IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+        params->setInt (STR_KMER_SIZE,          kmerSize);
+        params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+        params->setInt (STR_KMER_ABUNDANCE_MIN, 1);
+        params->setInt (STR_MINIMIZER_TYPE,     minimizerType);
+        if (repartitionIn)   {  params->setStr (STR_REPARTITION_IN,  repartitionIn);  }
+        if (repartitionOut)  {  params->setStr (STR_REPARTITION_OUT, repartitionOut); }
+
+        SortingCountAlgorithm<KSIZE_1> sortingCount (bank, params);
+        sortingCount.execute();
+
+        vector<Kmer<KSIZE_1>::Count> solids;
+        Iterator<Kmer<KSIZE_1>::Count>* it = sortingCount.getSolidCounts()->iterator();  LOCAL (it);
+        for (it->first(); !it->isDone(); it->next())  {  solids.push_back (it->item());  }
+        std::sort (solids.begin(), solids.end(), lessCount<Kmer<KSIZE_1>::Count>);
+
+        return solids;
+    }
+
+    void DSK_repartitionReuse ()
+    {
+        size_t kmerSize = 21;
+
+        IBank* bank1 = Bank::open (DBPATH("reads1.fa"));  LOCAL (bank1);
+        IBank* bank2 = Bank::open (DBPATH("reads2.fa"));  LOCAL (bank2);
+
+        for (size_t minimizerType=0; minimizerType<2; minimizerType++)
+        {
+            /** We save the repartition computed for a first bank. */
+            DSK_repartitionReuse_aux (bank1, kmerSize, minimizerType, 0, "repartition.h5");
+            CPPUNIT_ASSERT (System::file().doesExist ("repartition.h5"));
+
+            /** We count a second bank with this repartition; the counts must be the usual ones. */
+            vector<Kmer<KSIZE_1>::Count> ref    = DSK_repartitionReuse_aux (bank2, kmerSize, minimizerType, 0, 0);
+            vector<Kmer<KSIZE_1>::Count> reused = DSK_repartitionReuse_aux (bank2, kmerSize, minimizerType, "repartition.h5", 0);
+
+            CPPUNIT_ASSERT (ref.size() > 0  &&  reused.size() == ref.size());
+            for (size_t j=0; j<ref.size(); j++)
+            {
+                CPPUNIT_ASSERT (reused[j].value == ref[j].value && reused[j].abundance == ref[j].abundance);
+            }
+
+            /** The repartition can't be used with another kmer size or another minimizer type. */
+            CPPUNIT_ASSERT_THROW (DSK_repartitionReuse_aux (bank2, kmerSize+2, minimizerType,   "repartition.h5", 0), gatb::core::system::Exception);
+            CPPUNIT_ASSERT_THROW (DSK_repartitionReuse_aux (bank2, kmerSize,   1-minimizerType, "repartition.h5", 0), gatb::core::system::Exception);
+
+            System::file().remove ("repartition.h5");
+        }
+    }
+
+    /********************************************************************************/
+    void DSK_countMatrix ()
+    {
+        typedef Kmer<KSIZE_1>::Type  Type;
+        typedef Kmer<KSIZE_1>::Count Count;
+
+        size_t kmerSize = 21;
+
+        const char* names[] = { "reads1.fa", "reads2.fa", "reads3.fa.gz" };
+        size_t nbBanks = ARRAY_SIZE(names);
+
+        BankAlbum* album = new BankAlbum ("albumMatrix", true);  LOCAL (album);
+
+        /** We count each bank alone. */
+        vector< map<Type,CountNumber> > refs (nbBanks);
+        set<Type> all;
+
+        for (size_t i=0; i<nbBanks; i++)
+        {
+            IBank* bank = Bank::open (DBPATH(names[i]));  LOCAL (bank);
+            album->addBank (DBPATH(names[i]));
+
+            IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+            params->setInt (STR_KMER_SIZE,          kmerSize);
+            params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+            params->setInt (STR_KMER_ABUNDANCE_MIN, 1);
+
+            SortingCountAlgorithm<KSIZE_1> sortingCount (bank, params);
+            sortingCount.execute();
+
+            Iterator<Count>* it = sortingCount.getSolidCounts()->iterator();  LOCAL (it);
+            for (it->first(); !it->isDone(); it->next())
+            {
+                refs[i][it->item().value] = it->item().abundance;
+                all.insert (it->item().value);
+            }
+        }
+
+        /** We count the banks together, with one column per bank in the matrix. */
+        IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+        params->setInt (STR_KMER_SIZE,          kmerSize);
+        params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+        params->setInt (STR_KMER_ABUNDANCE_MIN, 1);
+        params->setStr (STR_SOLIDITY_KIND,      "max");
+        params->setInt (STR_COUNT_MATRIX,       1);
+
+        Storage* storage = StorageFactory(STORAGE_HDF5).create ("testMatrix", true, true);
+        LOCAL (storage);
+
+        ConfigurationAlgorithm<KSIZE_1> configAlgo (album, params);
+        configAlgo.execute();
+        Configuration config = configAlgo.getConfiguration();
+
+        RepartitorAlgorithm<KSIZE_1> repart (album, (*storage)("minimizers"), config);
+        repart.execute();
+
+        SortingCountAlgorithm<KSIZE_1> sortingCount (
+            album,
+            config,
+            new Repartitor ((*storage)("minimizers")),
+            SortingCountAlgorithm<KSIZE_1>::getDefaultProcessorVector (config, params, storage, storage),
+            params
+        );
+        sortingCount.execute();
+
+        /** We read back the matrix; each row must hold the counts of each bank alone. */
+        CountMatrix<KSIZE_1> matrix ((*storage)("matrix"));
+
+        CPPUNIT_ASSERT (all.size() > 0);
+        CPPUNIT_ASSERT (matrix.getNbSamples()     == nbBanks);
+        CPPUNIT_ASSERT (matrix.getNbPartitions()  == config._nb_partitions * config._nb_passes);
+        CPPUNIT_ASSERT (matrix.getNbKmers()       == all.size());
+
+        size_t nbRows  = 0;
+        size_t nbCells = 0;
+
+        Iterator<CountMatrix<KSIZE_1>::Row>* it = matrix.iterator();  LOCAL (it);
+        for (it->first(); !it->isDone(); it->next())
+        {
+            const CountMatrix<KSIZE_1>::Row& row = it->item();
+            CPPUNIT_ASSERT (row.counts.size() == nbBanks);
+
+            for (size_t i=0; i<nbBanks; i++)
+            {
+                map<Type,CountNumber>::iterator lookup = refs[i].find (row.kmer);
+                CPPUNIT_ASSERT (row.counts[i] == (lookup == refs[i].end() ? 0 : lookup->second));
+                if (row.counts[i] > 0)  { nbCells++; }
+            }
+            nbRows++;
+        }
+
+        CPPUNIT_ASSERT (nbRows  == all.size());
+        CPPUNIT_ASSERT (nbCells == matrix.getNbCells());
+    }
+
+    /********************************************************************************/
+    vector<Kmer<KSIZE_1>::Count> DSK_incremental_aux (IBank* bank, size_t nksMin, const char* output, const char* incrementalIn, vector<u_int64_t>& histo)
+    {
+        IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+        params->setInt (STR_KMER_SIZE,          21);
+        params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+        params->setInt (STR_KMER_ABUNDANCE_MIN, nksMin);
+        params->setStr (STR_URI_OUTPUT,         output);
+        if (incrementalIn)  {  params->setStr (STR_INCREMENTAL_IN, incrementalIn);  }
+
+        SortingCountAlgorithm<KSIZE_1> sortingCount (bank, params);
+        sortingCount.execute();
+
+        IHistogram* histogram = sortingCount.getProcessor(0)->get<CountProcessorHistogram<KSIZE_1> > ()->getHistogram();
+        histo.clear();
+        for (size_t i=0; i<histogram->getLength(); i++)  {  histo.push_back (histogram->get(i));  }
+
+        vector<Kmer<KSIZE_1>::Count> solids;
+        Iterator<Kmer<KSIZE_1>::Count>* it = sortingCount.getSolidCounts()->iterator();  LOCAL (it);
+        for (it->first(); !it->isDone(); it->next())  {  solids.push_back (it->item());  }
+        std::sort (solids.begin(), solids.end(), lessCount<Kmer<KSIZE_1>::Count>);
+
+        return solids;
+    }
+
+    void DSK_incremental ()
+    {
+        IBank* bank1 = Bank::open (DBPATH("reads1.fa"));  LOCAL (bank1);
+        IBank* bank2 = Bank::open (DBPATH("reads2.fa"));  LOCAL (bank2);
+
+        BankAlbum* album = new BankAlbum ("albumIncremental", true);  LOCAL (album);
+        album->addBank (DBPATH("reads1.fa"));
+        album->addBank (DBPATH("reads2.fa"));
+
+        vector<u_int64_t> histoRef, histoIncr;
+
+        /** We count the first bank, keeping all its kmers. */
+        DSK_incremental_aux (bank1, 1, "incremental1", 0, histoRef);
+
+        for (size_t nksMin=1; nksMin<=2; nksMin++)
+        {
+            /** Adding the counts of the second bank to the first ones must give the counts of both banks. */
+            vector<Kmer<KSIZE_1>::Count> ref  = DSK_incremental_aux (album, nksMin, "incrementalRef", 0,              histoRef);
+            vector<Kmer<KSIZE_1>::Count> incr = DSK_incremental_aux (bank2, nksMin, "incremental2",   "incremental1", histoIncr);
+
+            CPPUNIT_ASSERT (ref.size() > 0  &&  incr.size() == ref.size());
+            for (size_t j=0; j<ref.size(); j++)
+            {
+                CPPUNIT_ASSERT (incr[j].value == ref[j].value && incr[j].abundance == ref[j].abundance);
+            }
+
+            /** The histogram is the one of the merged counts. */
+            CPPUNIT_ASSERT (histoIncr == histoRef);
+        }
+
+        /** The previous counts can't be overwritten by the output. */
+        CPPUNIT_ASSERT_THROW (DSK_incremental_aux (bank2, 1, "incremental1", "incremental1.h5", histoIncr), gatb::core::system::Exception);
+
+        System::file().remove ("incremental1.h5");
+        System::file().remove ("incremental2.h5");
+        System::file().remove ("incrementalRef.h5");
+    }
+
+    /********************************************************************************/
+    template<size_t span>
+    class CollectListener : public IPartitionListener<span>
+    {
+    public:
+        typedef typename Kmer<span>::Count Count;
+
+        CollectListener () : _synchro(System::thread().newSynchronizer()), _nbPartitions(0), _nbBegin(0), _nbEnd(0)  {}
+        ~CollectListener ()  { delete _synchro; }
+
+        void begin (const Configuration& config)  { _nbBegin++; }
+        void end   ()                             { _nbEnd++;   }
+
+        void publish (size_t passId, size_t partId, const vector<Count>& items)
+        {
+            LocalSynchronizer ls (_synchro);
+            _items.insert (_items.end(), items.begin(), items.end());
+            _nbPartitions++;
+        }
+
+        ISynchronizer* _synchro;
+        vector<Count>  _items;
+        size_t         _nbPartitions;
+        size_t         _nbBegin;
+        size_t         _nbEnd;
+    };
+
+    template<typename Count>  static bool lessCount (const Count& a, const Count& b)  { return a.value < b.value; }
+
+    void DSK_stream ()
+    {
+        typedef Kmer<KSIZE_1>::Count Count;
+
+        size_t kmerSize = 15;
+        size_t nbPasses = 3;
+
+        IBank* bank = new BankStrings (
+            "CGCTACAGCAGCTAGTTCATCATTGTTTATCAATGATAAAATATAATAAGCTAAAAGGAAACTATAAATA",
+            "ACCATGTATAATTATAAGTAGGTACCTATTTTTTTATTTTAAACTGAAATTCAATATTATATAGGCAAAG",
+            "ACTTAGATGTAAGATTTCGAAGACTTGGATGTAAACAACAAATAAGATAATAACCATAAAAATAGAAATG",
+            "AACGATATTAAAATTAAAAAATACGAAAAAACTAACACGTATTGTGTCCAATAAATTCGATTTGATAATT",
+            "CGCTACAGCAGCTAGTTCATCATTGTTTATCAATGATAAAATATAATAAGCTAAAAGGAAACTATAAATA",
+            0
+        );
+        LOCAL (bank);
+
+        IProperties* params = SortingCountAlgorithm<>::getDefaultProperties();  LOCAL (params);
+        params->setInt (STR_KMER_SIZE,          kmerSize);
+        params->setInt (STR_MAX_MEMORY,         MAX_MEMORY);
+        params->setInt (STR_KMER_ABUNDANCE_MIN, 2);
+
+        Storage* storage = StorageFactory(STORAGE_HDF5).create ("testStream", true, true);
+        LOCAL (storage);
+
+        /** We force several passes (the bank is too small otherwise). */
+        ConfigurationAlgorithm<KSIZE_1> configAlgo (bank, params);
+        configAlgo.execute();
+        Configuration config = configAlgo.getConfiguration();
+        config._nb_passes = nbPasses;
+
+        RepartitorAlgorithm<KSIZE_1> repart (bank, (*storage)("minimizers"), config);
+        repart.execute();
+
+        /** We listen to the counted partitions, one listener gathers the kmers, the other one fills a Bloom filter. */
+        CollectListener<KSIZE_1>* collect = new CollectListener<KSIZE_1> ();
+        LOCAL (collect);
+
+        BloomPartitionListener<KSIZE_1>* bloom = new BloomPartitionListener<KSIZE_1> (
+            BloomBuilder<KSIZE_1> (1<<16, 7, kmerSize, BLOOM_CACHE).create()
+        );
+        LOCAL (bloom);
+
+        vector<IPartitionListener<KSIZE_1>*> listeners;
+        listeners.push_back (collect);
+        listeners.push_back (bloom);
+
+        SortingCountAlgorithm<KSIZE_1> sortingCount (
+            bank,
+            config,
+            new Repartitor ((*storage)("minimizers")),
+            SortingCountAlgorithm<KSIZE_1>::getDefaultProcessorVector (config, params, storage, storage, listeners),
+            params
+        );
+        sortingCount.execute();
+
+        CPPUNIT_ASSERT (collect->_nbBegin == 1);
+        CPPUNIT_ASSERT (collect->_nbEnd   == 1);
+        CPPUNIT_ASSERT (collect->_nbPartitions == config._nb_partitions * nbPasses);
+
+        /** The published kmers must be the solid kmers. */
+        vector<Count> solids;
+        Iterator<Count>* it = sortingCount.getSolidCounts()->iterator();  LOCAL (it);
+        for (it->first(); !it->isDone(); it->next())  {  solids.push_back (it->item());  }
+
+        CPPUNIT_ASSERT (solids.size() > 0);
+        CPPUNIT_ASSERT (collect->_items.size() == solids.size());
+
+        std::sort (solids.begin(),          solids.end(),          lessCount<Count>);
+        std::sort (collect->_items.begin(), collect->_items.end(), lessCount<Count>);
+        CPPUNIT_ASSERT (collect->_items == solids);
+
+        /** The Bloom filter must hold all the solid kmers. */
+        CPPUNIT_ASSERT (bloom->getNbItems() == solids.size());
+        for (size_t i=0; i<solids.size(); i++)  {  CPPUNIT_ASSERT (bloom->getBloom()->contains (solids[i].value));  }
+    }
 };
 
 /********************************************************************************/
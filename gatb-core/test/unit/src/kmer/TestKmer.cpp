@@ -24,6 +24,12 @@
 #include <gatb/bank/api/Sequence.hpp>
 #include <gatb/bank/impl/Alphabet.hpp>
 #include <gatb/kmer/impl/Model.hpp>
+#include <gatb/kmer/impl/SuperKmerDecoder.hpp>
+#include <gatb/kmer/impl/PartitionScheduler.hpp>
+#include <gatb/kmer/impl/PartitionCostModel.hpp>
+#include <gatb/kmer/impl/PartiInfo.hpp>
+#include <gatb/kmer/impl/HyperLogLog.hpp>
+#include <gatb/tools/designpattern/impl/Command.hpp>
 
 #include <gatb/tools/math/LargeInt.hpp>
 #include <gatb/tools/math/Integer.hpp>
@@ -49,6 +55,7 @@ using namespace gatb::core::kmer;
 using namespace gatb::core::kmer::impl;
 
 using namespace gatb::core::tools::dp;
+using namespace gatb::core::tools::dp::impl;
 
 using namespace gatb::core::tools::collections;
 using namespace gatb::core::tools::collections::impl;
@@ -74,10 +81,16 @@ class TestKmer : public Test
         CPPUNIT_TEST_GATB (kmer_checkCompute);
         CPPUNIT_TEST_GATB (kmer_checkIterator);
         CPPUNIT_TEST_GATB (kmer_build);
+        CPPUNIT_TEST_GATB (kmer_buildBatch);
         CPPUNIT_TEST_GATB (kmer_minimizer); // with ModelDirect
         CPPUNIT_TEST_GATB (kmer_minimizer2); // with ModelDirect
         CPPUNIT_TEST_GATB (kmer_minimizer3); // with ModelCanonical
+        CPPUNIT_TEST_GATB (kmer_minimizer4); // with ModelCanonical, frequency order and large mmers
         CPPUNIT_TEST_GATB (kmer_badchar);
+        CPPUNIT_TEST_GATB (kmer_superKmerDecoder);
+        CPPUNIT_TEST_GATB (kmer_partitionScheduler);
+        CPPUNIT_TEST_GATB (kmer_partitionCostModel);
+        CPPUNIT_TEST_GATB (kmer_hyperLogLog);
 
     CPPUNIT_TEST_SUITE_GATB_END();
 
@@ -260,6 +273,76 @@ public:
         CPPUNIT_ASSERT (kmer.value() == check[0]);
     }
 
+    /********************************************************************************/
+    template<class Model>
+    void kmer_buildBatch_aux (IBank& bank, Model& model)
+    {
+        Kmer<>::KmerBatch batch;
+        vector<typename Model::Kmer> kmers;
+        size_t nbSequences = 0;
+
+        /** We build the kmers of blocks of sequences, as retrieved by a dispatcher. */
+        vector<Sequence> sequences (50);
+
+        Iterator<Sequence>* itSeq = bank.iterator();  LOCAL (itSeq);
+        itSeq->first();
+
+        for (bool isRunning=true; isRunning; )
+        {
+            isRunning = itSeq->get (sequences);
+
+            size_t nbKmers = model.build (sequences, batch);
+
+            CPPUNIT_ASSERT (nbKmers == batch.size());
+            CPPUNIT_ASSERT (batch.getNbSequences() == sequences.size());
+            CPPUNIT_ASSERT ((size_t)batch.forward()   % 64 == 0);
+            CPPUNIT_ASSERT ((size_t)batch.canonical() % 64 == 0);
+            CPPUNIT_ASSERT ((size_t)batch.strands()   % 64 == 0);
+            CPPUNIT_ASSERT ((size_t)batch.invalid()   % 64 == 0);
+
+            /** The kmers of each sequence must be the ones built one sequence at a time. */
+            for (size_t i=0; i<sequences.size(); i++, nbSequences++)
+            {
+                kmers.clear();
+                model.build (sequences[i].getData(), kmers);
+
+                CPPUNIT_ASSERT (batch.getOffset(i+1) - batch.getOffset(i) == kmers.size());
+
+                for (size_t j=0, idx=batch.getOffset(i); j<kmers.size(); j++, idx++)
+                {
+                    CPPUNIT_ASSERT (batch.forward()[idx]   == kmers[j].forward());
+                    CPPUNIT_ASSERT (batch.canonical()[idx] == kmers[j].value());
+                    CPPUNIT_ASSERT (batch.strand(idx)      == kmers[j].strand());
+                    CPPUNIT_ASSERT (batch.isValid(idx)     == kmers[j].isValid());
+                }
+            }
+        }
+
+        CPPUNIT_ASSERT (nbSequences > 0);
+    }
+
+    void kmer_buildBatch ()
+    {
+        const char* seqs[] = {
+            "ACTACGATCGATGTA",
+            "ACGT",
+            "ACCATGTATAATTATAAGTAGGTACCTATTTTTTTATTTTAAACTGAAATTCAATATTATATAGGCAAAGAT",
+            "TCCCCAGGCCCCTACACCCAATGTNGAACCGGGGTCCCGAATGAAAATGCTGNNNNNNTTCCCTGGAGGTGTTCT"
+        };
+        IBank* bank1 = new BankStrings (seqs, ARRAY_SIZE(seqs));  LOCAL (bank1);
+        IBank* bank2 = new BankRandom  (500, 300);                LOCAL (bank2);
+
+        Kmer<>::ModelCanonical                         model1 (21);
+        Kmer<>::ModelDirect                            model2 (21);
+        Kmer<>::ModelMinimizer<Kmer<>::ModelCanonical> model3 (21, 8);
+
+        kmer_buildBatch_aux (*bank1, model1);
+        kmer_buildBatch_aux (*bank1, model2);
+        kmer_buildBatch_aux (*bank1, model3);
+        kmer_buildBatch_aux (*bank2, model1);
+        kmer_buildBatch_aux (*bank2, model3);
+    }
+
     /********************************************************************************/
     template<size_t span>
     struct kmer_minimizer_fct
@@ -502,6 +585,102 @@ public:
     }
 
 
+    /** Check the minimizer of a canonical kmer against the lowest of its canonical mmers. */
+    template<class ModelMinimizer>
+    struct kmer_minimizer4_fct
+    {
+        const ModelMinimizer& model;  size_t miniSize;  uint32_t* freq;  size_t& nbKmers;
+
+        kmer_minimizer4_fct (const ModelMinimizer& model, size_t miniSize, uint32_t* freq, size_t& nbKmers)
+            : model(model), miniSize(miniSize), freq(freq), nbKmers(nbKmers) {}
+
+        u_int64_t value (const string& s)  {  u_int64_t v=0;  for (size_t i=0; i<s.size(); i++)  { v = 4*v + ((s[i]>>1) & 3); }  return v;  }
+
+        string revcomp (const string& s)
+        {
+            string r (s.rbegin(), s.rend());
+            for (size_t i=0; i<r.size(); i++)  {  r[i] = r[i]=='A' ? 'T' : r[i]=='T' ? 'A' : r[i]=='C' ? 'G' : 'C';  }
+            return r;
+        }
+
+        bool lower (u_int64_t a, u_int64_t b)  {  return freq==0 || freq[a]==freq[b] ? a < b : freq[a] < freq[b];  }
+
+        void operator() (const typename ModelMinimizer::Kmer& kmer, size_t idx)
+        {
+            string    forward = model.toString (kmer.value(0));
+            u_int64_t mask    = ((u_int64_t)1 << (2*miniSize)) - 1;
+            u_int64_t best    = mask;
+
+            for (size_t i=0; i<forward.size() - miniSize + 1; i++)
+            {
+                string mmer = forward.substr (i, miniSize);
+                string rev  = revcomp (mmer);
+                if (value(rev) < value(mmer))  { mmer = rev; }
+
+                /** Without frequencies, mmers with AA (except at their beginning) are not allowed. */
+                u_int64_t candidate = (freq==0 && mmer.find("AA",1) != string::npos) ? mask : value(mmer);
+
+                if (lower (candidate, best))  { best = candidate; }
+            }
+
+            CPPUNIT_ASSERT (kmer.minimizer().value().getVal() == best);
+
+            nbKmers++;
+        }
+    };
+
+    void kmer_minimizer4_aux (IBank& bank, size_t kmerSize, size_t miniSize, uint32_t* freq)
+    {
+        typedef Kmer<>::ModelMinimizer<Kmer<>::ModelCanonical> ModelMinimizer;
+
+        ModelMinimizer model (kmerSize, miniSize, Kmer<>::ComparatorMinimizerFrequencyOrLex(), freq);
+
+        size_t nbKmers = 0;
+
+        Iterator<Sequence>* itSeq = bank.iterator();  LOCAL (itSeq);
+        for (itSeq->first(); !itSeq->isDone(); itSeq->next())
+        {
+            model.iterate ((*itSeq)->getData(), kmer_minimizer4_fct<ModelMinimizer> (model, miniSize, freq, nbKmers));
+        }
+        CPPUNIT_ASSERT (nbKmers > 0);
+    }
+
+    void kmer_minimizer4 ()
+    {
+        vector<IBank*> banks;
+        banks.push_back (new BankStrings ("ACCATGTATAATTATAAGTAGGTACCTATTTTTTTATTTTAAACTGAAATTCAATATTATATAGGCAAAGAT"
+                                          "TCCCCAGGCCCCTACACCCAATGTGGAACCGGGGTCCCGAATGAAAATGCTGCTGTTCCCTGGAGGTGTTCT",
+                                          "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAATTTTTTTTTTTTTTTTTTTTTCACACACACACA"
+                                          "CACACACACACACACACACACACAGTGTGTGTGTGTGTGTGTGTGTTTTTTTTTTTTTTTTTTTTTTTTTTTT", NULL));
+        banks.push_back (Bank::open (DBPATH("reads1.fa")));
+        banks.push_back (new BankRandom (50, 300));
+
+        size_t kmerSizes[] = { 15, 21, 31 };
+        size_t miniSizes[] = {  5,  8, 10 };
+
+        for (size_t b=0; b<banks.size(); b++)
+        {
+            IBank* bank = banks[b];   LOCAL(bank);
+
+            for (size_t i=0; i<ARRAY_SIZE(kmerSizes); i++)
+            {
+                for (size_t j=0; j<ARRAY_SIZE(miniSizes); j++)
+                {
+                    /** We use the lexicographic order and a frequency order with many equal frequencies. */
+                    vector<uint32_t> freq (1 << (2*miniSizes[j]));
+                    for (size_t f=0; f<freq.size(); f++)  {  freq[f] = (f * 2654435761UL) % 7;  }
+
+                    kmer_minimizer4_aux (*bank, kmerSizes[i], miniSizes[j], 0);
+                    kmer_minimizer4_aux (*bank, kmerSizes[i], miniSizes[j], freq.data());
+                }
+            }
+
+            /** Mmers may be as large as the kmers, up to 31 nucleotides. */
+            kmer_minimizer4_aux (*bank, 31, 20, 0);
+            kmer_minimizer4_aux (*bank, 31, 31, 0);
+        }
+    }
+
     /********************************************************************************/
 
     typedef Kmer<>::ModelDirect  ModelDirect;
@@ -586,6 +765,243 @@ public:
         CPPUNIT_ASSERT (model.toString(kmer.value()) == kmer_str);
 #endif
     }
+
+    /********************************************************************************/
+    void kmer_superKmerDecoder (void)
+    {
+        srand (12345);
+
+        for (size_t nbNt=0; nbNt<=300; nbNt++)
+        {
+            vector<u_int8_t> packed ((nbNt+3)/4 + 1);
+            for (size_t i=0; i<packed.size(); i++)  {  packed[i] = rand() & 0xFF;  }
+
+            vector<u_int8_t> forward (nbNt+1, 0xFF), complement (nbNt+1, 0xFF);
+            SuperKmerDecoder::unpack (&packed[0], nbNt, &forward[0], &complement[0], SuperKmerDecoder::SCALAR);
+
+            for (size_t i=0; i<nbNt; i++)
+            {
+                CPPUNIT_ASSERT (forward[i]    == ((packed[i/4] >> (2*(i%4))) & 3));
+                CPPUNIT_ASSERT (complement[i] == comp_NT[forward[i]]);
+            }
+            CPPUNIT_ASSERT (forward[nbNt] == 0xFF && complement[nbNt] == 0xFF);
+
+            /** All the supported implementations must give the same result as the scalar one. */
+            for (size_t impl=0; impl<SuperKmerDecoder::NB_IMPLEMENTATIONS; impl++)
+            {
+                if (SuperKmerDecoder::isSupported ((SuperKmerDecoder::Implementation)impl) == false)  { continue; }
+
+                vector<u_int8_t> f (nbNt+1, 0xFF), c (nbNt+1, 0xFF);
+                SuperKmerDecoder::unpack (&packed[0], nbNt, &f[0], &c[0], (SuperKmerDecoder::Implementation)impl);
+
+                CPPUNIT_ASSERT (f == forward);
+                CPPUNIT_ASSERT (c == complement);
+            }
+        }
+    }
+
+    /********************************************************************************/
+    class SchedulerCommand : public ICommand, public SmartPointer
+    {
+    public:
+        SchedulerCommand (PartitionScheduler& scheduler, vector<u_int8_t>& counted, u_int64_t maxMemory, u_int64_t& used, ISynchronizer* synchro)
+            : _scheduler(scheduler), _counted(counted), _maxMemory(maxMemory), _used(used), _synchro(synchro) {}
+
+        void execute ()
+        {
+            u_int64_t held = 0;
+            PartitionScheduler::Job job;
+
+            while (_scheduler.next (job, held))
+            {
+                {
+                    LocalSynchronizer ls (_synchro);
+                    _counted[job.partition]++;
+                    _used += job.memory;
+                    /** The memory may be exceeded only by a partition counted alone. */
+                    if (_used > _maxMemory)  {  CPPUNIT_ASSERT (_used == job.memory);  }
+                }
+                {
+                    LocalSynchronizer ls (_synchro);
+                    _used -= job.memory;
+                }
+                _scheduler.done (job);
+            }
+        }
+
+    private:
+        PartitionScheduler& _scheduler;
+        vector<u_int8_t>&   _counted;
+        u_int64_t           _maxMemory;
+        u_int64_t&          _used;
+        ISynchronizer*      _synchro;
+    };
+
+    /** */
+    void kmer_partitionScheduler (void)
+    {
+        u_int64_t memory[] = { 10, 50, 0, 30, 200, 20, 50, 5 };
+        size_t nbPartitions = ARRAY_SIZE(memory);
+
+        /** With one worker, the partitions are given largest first, whatever the memory. */
+        {
+            PartitionScheduler scheduler (100, 1, 4);
+            for (size_t p=0; p<nbPartitions; p++)  {  scheduler.add (p, memory[p], p==4);  }
+            scheduler.start ();
+
+            size_t expected[] = { 4, 1, 6, 3, 5, 0, 7, 2 };
+            u_int64_t held = 0;
+            PartitionScheduler::Job job;
+
+            for (size_t i=0; i<nbPartitions; i++)
+            {
+                CPPUNIT_ASSERT (scheduler.next (job, held) == true);
+                CPPUNIT_ASSERT (job.partition == expected[i]);
+                CPPUNIT_ASSERT (job.exclusive == (job.partition==4));
+                CPPUNIT_ASSERT (scheduler.getNbCores() == 4);
+                scheduler.done (job);
+            }
+            CPPUNIT_ASSERT (scheduler.next (job, held) == false);
+            CPPUNIT_ASSERT (held == 0);
+            CPPUNIT_ASSERT (scheduler.getMemoryPeak() == 200);
+        }
+
+        /** With two workers, the second one gets the largest partition that fits the remaining memory. */
+        {
+            PartitionScheduler scheduler (70, 2, 4);
+            for (size_t p=0; p<nbPartitions; p++)  {  if (p!=4)  { scheduler.add (p, memory[p]); }  }
+            scheduler.start ();
+
+            u_int64_t held1 = 0, held2 = 0;
+            PartitionScheduler::Job job1, job2;
+
+            CPPUNIT_ASSERT (scheduler.next (job1, held1) == true);
+            CPPUNIT_ASSERT (job1.partition == 1 && held1 == 50);
+            CPPUNIT_ASSERT (scheduler.next (job2, held2) == true);
+            CPPUNIT_ASSERT (job2.partition == 5 && held2 == 20);
+
+            /** The first worker keeps its memory for the next partitions. */
+            CPPUNIT_ASSERT (scheduler.next (job1, held1) == true);
+            CPPUNIT_ASSERT (job1.partition == 6 && held1 == 50);
+            CPPUNIT_ASSERT (scheduler.getMemoryPeak() == 70);
+        }
+
+        /** All the partitions are counted once by several workers, within the memory. */
+        for (size_t nbWorkers=1; nbWorkers<=8; nbWorkers*=2)
+        {
+            size_t nb = 500;
+            PartitionScheduler scheduler (1000, nbWorkers, 8);
+
+            srand (nbWorkers);
+            for (size_t p=0; p<nb; p++)  {  scheduler.add (p, rand()%1200, p%100==0);  }
+            scheduler.start ();
+
+            vector<u_int8_t> counted (nb, 0);
+            u_int64_t used = 0;
+
+            ISynchronizer* synchro = System::thread().newSynchronizer();
+            LOCAL (synchro);
+
+            vector<ICommand*> commands;
+            for (size_t i=0; i<nbWorkers; i++)  {  commands.push_back (new SchedulerCommand (scheduler, counted, 1000, used, synchro));  }
+
+            Dispatcher(nbWorkers).dispatchCommands (commands, 0);
+
+            for (size_t p=0; p<nb; p++)  {  CPPUNIT_ASSERT (counted[p] == 1);  }
+            CPPUNIT_ASSERT (used == 0);
+        }
+    }
+
+    /********************************************************************************/
+    void kmer_partitionCostModel (void)
+    {
+        typedef PartitionCostModel PCM;
+
+        /** The distinct kmers of a partition are estimated from a sample of their hash values. */
+        {
+            PartiInfo<5> pInfo (2, 8);
+            u_int64_t nbDistinct = 20000;
+            for (u_int64_t i=0; i<10*nbDistinct; i++)
+            {
+                pInfo.incKmer_and_rad (i%2, 0, 0);
+                pInfo.incDistinct (i%2, oahash (NativeInt64 (i % nbDistinct)));
+            }
+            for (size_t p=0; p<2; p++)
+            {
+                CPPUNIT_ASSERT (pInfo.getNbKmer(p) == 5*nbDistinct);
+                CPPUNIT_ASSERT (pInfo.getNbDistinctKmer(p) > 0.8*nbDistinct/2 && pInfo.getNbDistinctKmer(p) < 1.2*nbDistinct/2);
+            }
+        }
+
+        /** Default rule : hashing for redundant partitions only, and nothing but sorting if hashing is not allowed. */
+        {
+            PCM model (true, true);
+            CPPUNIT_ASSERT (model.choose (1000, 1000, 1000) == PCM::SORT);
+            CPPUNIT_ASSERT (model.choose (1000, 100,  1000) == PCM::HASH);
+
+            PCM sortOnly (true, false);
+            CPPUNIT_ASSERT (sortOnly.choose (1000, 100, 1000) == PCM::SORT);
+
+            PCM hashOnly (false, true);
+            CPPUNIT_ASSERT (hashOnly.choose (1000, 1000, 1000) == PCM::HASH);
+        }
+
+        /** A small partition is used once for timing the other strategy, then the model keeps the cheapest one. */
+        {
+            PCM model (true, true);
+
+            CPPUNIT_ASSERT (model.choose (100, 100, 1000) == PCM::HASH);
+            CPPUNIT_ASSERT (model.choose (100, 100, 1000) == PCM::SORT);
+            CPPUNIT_ASSERT (model.getCost (PCM::HASH, 100, 100) < 0);
+
+            model.update (PCM::HASH, 1000*1000, 1000*1000, 100);
+            model.update (PCM::SORT, 1000*1000, 1000*1000, 300);
+
+            CPPUNIT_ASSERT (model.getCost (PCM::HASH, 100, 100) == 100.0);
+            CPPUNIT_ASSERT (model.getCost (PCM::SORT, 100, 100) == 300.0);
+            CPPUNIT_ASSERT (model.choose (5000, 5000, 1000) == PCM::HASH);
+
+            /** Other multiplicities are not concerned. */
+            CPPUNIT_ASSERT (model.getCost (PCM::HASH, 8000, 1000) < 0);
+            CPPUNIT_ASSERT (model.choose (8000, 1000, 1000) == PCM::HASH);
+        }
+    }
+
+    /********************************************************************************/
+    void kmer_hyperLogLog (void)
+    {
+        /** Small and large cardinalities, each item being added several times. */
+        u_int64_t nbDistinct[] = { 100, 5000, 1000*1000 };
+
+        for (size_t n=0; n<ARRAY_SIZE(nbDistinct); n++)
+        {
+            HyperLogLog hll;
+            for (size_t r=0; r<3; r++)
+            {
+                for (u_int64_t i=0; i<nbDistinct[n]; i++)  {  hll.add (oahash (NativeInt64 (i)));  }
+            }
+
+            double error = (double)hll.estimate() / (double)nbDistinct[n] - 1.0;
+            CPPUNIT_ASSERT (std::fabs (error) < 4*hll.getError());
+        }
+
+        /** Sketches filled separately (with overlapping items) give the estimation of the union once merged. */
+        {
+            HyperLogLog hll1, hll2, all;
+            for (u_int64_t i=0;      i<300000; i++)  {  hll1.add (oahash (NativeInt64 (i)));  all.add (oahash (NativeInt64 (i)));  }
+            for (u_int64_t i=200000; i<500000; i++)  {  hll2.add (oahash (NativeInt64 (i)));  all.add (oahash (NativeInt64 (i)));  }
+
+            hll1.merge (hll2);
+            CPPUNIT_ASSERT (hll1.estimate() == all.estimate());
+            CPPUNIT_ASSERT (std::fabs ((double)hll1.estimate() / 500000.0 - 1.0) < 4*hll1.getError());
+
+            HyperLogLog other (10);
+            CPPUNIT_ASSERT_THROW (hll1.merge (other), gatb::core::system::Exception);
+        }
+
+        /** The memory doesn't depend on the number of items. */
+        CPPUNIT_ASSERT (HyperLogLog().getMemory() == 16*1024);
+    }
 };
 
 /********************************************************************************/
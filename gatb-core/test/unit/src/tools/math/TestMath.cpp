@@ -22,6 +22,12 @@
 
 #include <gatb/tools/math/LargeInt.hpp>
 #include <gatb/tools/math/Integer.hpp>
+#include <gatb/tools/math/NativeInt128.hpp>
+#include <gatb/tools/math/RadixSort.hpp>
+
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
 
 using namespace std;
 using namespace gatb::core::tools::math;
@@ -38,6 +44,8 @@ class TestMath : public Test
         CPPUNIT_TEST_GATB (math_checkBasic);
         CPPUNIT_TEST_GATB (math_checkFibo);
         CPPUNIT_TEST_GATB (math_test1);
+        CPPUNIT_TEST_GATB (math_radixSort);
+        CPPUNIT_TEST_GATB (math_revcomp);
 
     CPPUNIT_TEST_SUITE_GATB_END();
 
@@ -172,6 +180,100 @@ public:
         math_test1_template <LargeInt<4> >();
         math_test1_template <LargeInt<5> >();
     }
+
+    /********************************************************************************/
+    template <typename T> void math_radixSort_template (size_t nbItems, size_t nbBits)
+    {
+        srand (nbItems + nbBits);
+
+        T mask (1);  mask = (mask << nbBits) - T(1);
+
+        std::vector<T> v1;
+        for (size_t i=0; i<nbItems; i++)
+        {
+            T x (0);
+            for (size_t j=0; j<T::getSize(); j+=16)  {  x = (x << 16) | T(rand() & 0xFFFF);  }
+
+            /** We want some duplicates and some items sharing their most significant bytes. */
+            if (i%7 == 0 && i>0)  { x = v1[i/2]; }
+            if (i%5 == 0)         { x = x & T(0xFFFF); }
+
+            v1.push_back (x & mask);
+        }
+
+        std::vector<T> v2 (v1);
+
+        std::sort (v1.begin(), v1.end());
+        RadixSort<T>::sort (&v2[0], &v2[0] + v2.size(), (nbBits+7)/8);
+
+        for (size_t i=0; i<nbItems; i++)  {  CPPUNIT_ASSERT (v1[i] == v2[i]);  }
+    }
+
+    void math_radixSort ()
+    {
+        size_t nbItems[] = { 0, 1, 10, 100, 10000 };
+
+        for (size_t i=0; i<sizeof(nbItems)/sizeof(nbItems[0]); i++)
+        {
+            math_radixSort_template <LargeInt<1> > (nbItems[i],  62);
+            math_radixSort_template <LargeInt<2> > (nbItems[i],  70);
+            math_radixSort_template <LargeInt<2> > (nbItems[i], 127);
+            math_radixSort_template <LargeInt<3> > (nbItems[i], 190);
+            math_radixSort_template <LargeInt<4> > (nbItems[i], 134);
+            math_radixSort_template <LargeInt<4> > (nbItems[i], 254);
+#if INT128_FOUND == 1
+            math_radixSort_template <NativeInt128> (nbItems[i], 126);
+#endif
+        }
+    }
+
+    /********************************************************************************/
+    template <typename T> void math_revcomp_template (size_t nbItems, size_t kmerSize)
+    {
+        srand (nbItems + kmerSize);
+
+        for (size_t i=0; i<nbItems; i++)
+        {
+            T x (0);
+            for (size_t j=0; j<kmerSize; j++)  {  x = (x << 2) | T(rand() & 3);  }
+
+            /** Reference revcomp, one nucleotide at a time (complement of A=0,C=1,T=2,G=3 is a XOR with 2). */
+            T check (0);
+            for (size_t j=0; j<kmerSize; j++)  {  check = (check << 2) | T(((x >> (2*j)) & T(3)).getVal() ^ 2);  }
+
+            T rev = revcomp (x, kmerSize);
+
+            CPPUNIT_ASSERT (rev == check);
+            CPPUNIT_ASSERT (revcomp (rev, kmerSize) == x);
+
+            /** Reference hashes, taking the 64 bits chunks by shifts of the whole integer. */
+            u_int64_t hash = 0;
+            T chunks = x;
+            for (size_t j=0; j<T::getSize()/64; j++)  {  hash ^= NativeInt64::oahash64 (chunks.getVal());  chunks = chunks >> 64;  }
+
+            CPPUNIT_ASSERT (oahash (x) == hash);
+        }
+    }
+
+    void math_revcomp ()
+    {
+        size_t kmerSizes[] = { 1, 13, 31, 32, 33, 63, 64, 65, 95, 96, 97, 127, 128, 160, 255, 256 };
+
+        for (size_t i=0; i<sizeof(kmerSizes)/sizeof(kmerSizes[0]); i++)
+        {
+            size_t k = kmerSizes[i];
+
+            if (k <=  32)  {  math_revcomp_template <LargeInt<1> > (1000, k);  }
+            if (k <=  64)  {  math_revcomp_template <LargeInt<2> > (1000, k);  }
+            if (k <=  96)  {  math_revcomp_template <LargeInt<3> > (1000, k);  }
+            if (k <= 128)  {  math_revcomp_template <LargeInt<4> > (1000, k);  }
+            if (k <= 160)  {  math_revcomp_template <LargeInt<5> > (1000, k);  }
+            if (k <= 256)  {  math_revcomp_template <LargeInt<8> > (1000, k);  }
+#if INT128_FOUND == 1
+            if (k <=  64)  {  math_revcomp_template <NativeInt128> (1000, k);  }
+#endif
+        }
+    }
 };
 
 /********************************************************************************/
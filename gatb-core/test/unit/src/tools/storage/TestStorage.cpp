@@ -74,6 +74,10 @@ class TestStorage : public Test
 
         CPPUNIT_TEST_GATB (storage_HDF5_check_collection);
         CPPUNIT_TEST_GATB (storage_HDF5_check_partition);
+
+        CPPUNIT_TEST_GATB (storage_superkmers_compress);
+        CPPUNIT_TEST_GATB (storage_superkmers_memory);
+        CPPUNIT_TEST_GATB (storage_superkmers_concurrent);
         
         CPPUNIT_TEST_SUITE_GATB_END();
 
@@ -447,7 +451,165 @@ public:
         free(buffer2);
     }
 
+    /********************************************************************************/
+    void storage_superkmers_compress_aux (bool compress, u_int64_t memory=0, int nbFilesOnDisk=3)
+    {
+        size_t nbFiles = 3;
+
+        SuperKmerBinFiles files ("test_superkmers", "superKparts", nbFiles, compress, memory);
+        CPPUNIT_ASSERT (files.isCompressed() == compress);
+
+        /** We write some compressible blocks and some random ones (that won't be compressed). */
+        vector< vector<unsigned char> > blocks;
+        srand (1234);
+        for (size_t i=0; i<4*nbFiles; i++)
+        {
+            vector<unsigned char> block (1000 + 777*i);
+            for (size_t j=0; j<block.size(); j++)  {  block[j] = (i%2==0) ? (j%13) : (rand() & 0xFF);  }
+            files.writeBlock (&block[0], block.size(), i%nbFiles, 1);
+            blocks.push_back (block);
+        }
+        files.closeFiles();
+
+        u_int64_t total, biggest, smallest;  float mean;
+        files.getFilesStats (total, biggest, smallest, mean);
+        if (compress)  { CPPUNIT_ASSERT (total < files.getRawFilesSize()); }
+        else           { CPPUNIT_ASSERT (total == files.getRawFilesSize()); }
+
+        CPPUNIT_ASSERT (files.getMemoryUsage() <= memory);
+        if (nbFilesOnDisk >= 0)  { CPPUNIT_ASSERT (files.getNbFilesOnDisk() == nbFilesOnDisk); }
+        else                     { CPPUNIT_ASSERT (files.getNbFilesOnDisk() > 0);              }
+
+        /** We read back the blocks. */
+        files.openFiles ("rb");
+
+        unsigned char* buffer = 0;
+        unsigned int bufferSize = 0;
+        unsigned int nbRead = 0;
+
+        for (size_t f=0; f<nbFiles; f++)
+        {
+            CPPUNIT_ASSERT (files.getNbItems(f) == 4);
+
+            /** The blocks kept in memory are read before the ones on disk, so we don't check the order. */
+            vector< vector<unsigned char> > expected, found;
+            for (size_t i=f; i<blocks.size(); i+=nbFiles)  {  expected.push_back (blocks[i]);  }
+
+            while (files.readBlock (&buffer, &bufferSize, &nbRead, f) > 0)
+            {
+                found.push_back (vector<unsigned char> (buffer, buffer+nbRead));
+            }
+
+            sort (expected.begin(), expected.end());
+            sort (found.begin(),    found.end());
+            CPPUNIT_ASSERT (found == expected);
+        }
+
+        free (buffer);
+    }
+
+    void storage_superkmers_compress ()
+    {
+        storage_superkmers_compress_aux (false);
+        storage_superkmers_compress_aux (true);
+    }
+
+    void storage_superkmers_memory ()
+    {
+        /** Everything fits in memory: no file is created. */
+        storage_superkmers_compress_aux (false, 1000000, 0);
+        storage_superkmers_compress_aux (true,  1000000, 0);
+
+        /** Only the first blocks fit in memory, the other ones are written to disk. */
+        storage_superkmers_compress_aux (false, 5000, -1);
+        storage_superkmers_compress_aux (true,  2000, -1);
+    }
+
+    /********************************************************************************/
+    class SuperKmerWriterCommand : public ICommand, public SmartPointer
+    {
+    public:
+        SuperKmerWriterCommand (CacheSuperKmerBinFiles& cache, u_int32_t id, u_int32_t nbItems, size_t nbFiles)
+            : _cache(cache), _id(id), _nbItems(nbItems), _nbFiles(nbFiles)  {}
+
+        void execute ()
+        {
+            /** Each thread has its own buffers. */
+            CacheSuperKmerBinFiles cache (_cache);
+
+            for (u_int32_t i=0; i<_nbItems; i++)
+            {
+                u_int32_t item = _id*_nbItems + i;
+                cache.insertSuperkmer ((u_int8_t*)&item, sizeof(item), 1, item % _nbFiles);
+            }
+        }
+
+        CacheSuperKmerBinFiles& _cache;
+        u_int32_t _id;
+        u_int32_t _nbItems;
+        size_t    _nbFiles;
+    };
+
+    void storage_superkmers_concurrent_aux (bool compress, u_int64_t memory)
+    {
+        size_t    nbFiles   = 5;
+        size_t    nbThreads = 8;
+        u_int32_t nbItems   = 20000;
+
+        SuperKmerBinFiles files ("test_superkmers", "superKparts", nbFiles, compress, memory);
+
+        /** Small buffers, so many blocks are written concurrently into the same files. */
+        {
+            CacheSuperKmerBinFiles cache (&files, 100);
+
+            vector<ICommand*> commands;
+            for (size_t t=0; t<nbThreads; t++)  {  commands.push_back (new SuperKmerWriterCommand (cache, t, nbItems, nbFiles));  }
+            Dispatcher (nbThreads).dispatchCommands (commands, 0);
+        }
+        files.closeFiles();
+
+        u_int64_t total, biggest, smallest;  float mean;
+        files.getFilesStats (total, biggest, smallest, mean);
+        if (!compress)  { CPPUNIT_ASSERT (total == files.getRawFilesSize()); }
+
+        /** Each item must be found once, in its file. */
+        files.openFiles ("rb");
 
+        vector<u_int8_t> found (nbThreads*nbItems, 0);
+        unsigned char* buffer = 0;
+        unsigned int bufferSize = 0;
+        unsigned int nbRead = 0;
+
+        for (size_t f=0; f<nbFiles; f++)
+        {
+            u_int64_t nbInFile = 0;
+            while (files.readBlock (&buffer, &bufferSize, &nbRead, f) > 0)
+            {
+                CPPUNIT_ASSERT (nbRead % (1+sizeof(u_int32_t)) == 0);
+                for (unsigned int pos=0; pos<nbRead; pos+=1+sizeof(u_int32_t))
+                {
+                    u_int32_t item;
+                    memcpy (&item, buffer+pos+1, sizeof(item));
+                    CPPUNIT_ASSERT (buffer[pos] == 1);
+                    CPPUNIT_ASSERT (item < found.size() && item % nbFiles == f);
+                    found[item]++;
+                    nbInFile++;
+                }
+            }
+            CPPUNIT_ASSERT ((u_int64_t)files.getNbItems(f) == nbInFile);
+        }
+
+        for (size_t i=0; i<found.size(); i++)  {  CPPUNIT_ASSERT (found[i] == 1);  }
+
+        free (buffer);
+    }
+
+    void storage_superkmers_concurrent ()
+    {
+        storage_superkmers_concurrent_aux (false, 0);
+        storage_superkmers_concurrent_aux (true,  0);
+        storage_superkmers_concurrent_aux (false, 200000);
+    }
 };
 
 /********************************************************************************/